@@ -14,6 +14,7 @@
 #ifndef LLVM_ANALYSIS_BASICALIASANALYSIS_H
 #define LLVM_ANALYSIS_BASICALIASANALYSIS_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/AssumptionCache.h"
@@ -24,7 +25,9 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/PassManager.h"
+#include "llvm/IR/ValueHandle.h"
 #include "llvm/Support/ErrorHandling.h"
+#include <vector>
 
 namespace llvm {
 class AssumptionCache;
@@ -32,10 +35,14 @@ class DominatorTree;
 class LoopInfo;
 
 /// This is the AA result object for the basic, local, and stateless alias
-/// analysis. It implements the AA query interface in an entirely stateless
-/// manner. As one consequence, it is never invalidated. While it does retain
-/// some storage, that is used as an optimization and not to preserve
-/// information from query to query.
+/// analysis. It implements the AA query interface in a stateless manner: its
+/// answers only depend on the IR. When asked to, it also caches the answers
+/// to top-level queries and the GEP decompositions across queries, as an
+/// optimization. Those entries refer to the IR as it was when they were made,
+/// so they are flushed whenever a value they depend on is deleted or has its
+/// uses replaced, and dropped whenever a pass changes the function; a pass
+/// that rewrites pointer computations in place and then queries again must
+/// call invalidateCaches() itself.
 class BasicAAResult : public AAResultBase<BasicAAResult> {
   friend AAResultBase<BasicAAResult>;
 
@@ -45,23 +52,34 @@ class BasicAAResult : public AAResultBase<BasicAAResult> {
   DominatorTree *DT;
   LoopInfo *LI;
 
+  /// Whether answers and GEP decompositions are kept across queries. Only
+  /// results that learn about every pass that changes the function may keep
+  /// them.
+  bool CacheAcrossQueries;
+
 public:
   BasicAAResult(const DataLayout &DL, const TargetLibraryInfo &TLI,
                 AssumptionCache &AC, DominatorTree *DT = nullptr,
-                LoopInfo *LI = nullptr)
-      : AAResultBase(), DL(DL), TLI(TLI), AC(AC), DT(DT), LI(LI) {}
+                LoopInfo *LI = nullptr, bool CacheAcrossQueries = false)
+      : AAResultBase(), DL(DL), TLI(TLI), AC(AC), DT(DT), LI(LI),
+        CacheAcrossQueries(CacheAcrossQueries) {}
 
   BasicAAResult(const BasicAAResult &Arg)
       : AAResultBase(Arg), DL(Arg.DL), TLI(Arg.TLI), AC(Arg.AC), DT(Arg.DT),
-        LI(Arg.LI) {}
+        LI(Arg.LI), CacheAcrossQueries(Arg.CacheAcrossQueries) {}
   BasicAAResult(BasicAAResult &&Arg)
       : AAResultBase(std::move(Arg)), DL(Arg.DL), TLI(Arg.TLI), AC(Arg.AC),
-        DT(Arg.DT), LI(Arg.LI) {}
+        DT(Arg.DT), LI(Arg.LI), CacheAcrossQueries(Arg.CacheAcrossQueries) {}
 
   /// Handle invalidation events from the new pass manager.
   ///
-  /// By definition, this result is stateless and so remains valid.
-  bool invalidate(Function &, const PreservedAnalyses &) { return false; }
+  /// By definition, this result is stateless and so remains valid. Its caches
+  /// are dropped after every pass that changes the function, even one that
+  /// preserves it, since such passes may edit instructions in place.
+  bool invalidate(Function &, const PreservedAnalyses &PA);
+
+  /// Drop the results cached across queries.
+  void invalidateCaches();
 
   AliasResult alias(const MemoryLocation &LocA, const MemoryLocation &LocB);
 
@@ -128,6 +146,32 @@ private:
   typedef SmallDenseMap<LocPair, AliasResult, 8> AliasCacheTy;
   AliasCacheTy AliasCache;
 
+  /// Flushes the cross-query caches when the value it tracks is deleted or
+  /// replaced, as the entries refer to values by address.
+  class CachedValueHandle final : public CallbackVH {
+    BasicAAResult *AAR;
+
+    void deleted() override;
+    void allUsesReplacedWith(Value *) override;
+
+  public:
+    CachedValueHandle(const Value *V, BasicAAResult *AAR)
+        : CallbackVH(const_cast<Value *>(V)), AAR(AAR) {}
+  };
+
+  /// The answers to top-level alias queries. Unlike AliasCache, which also
+  /// holds the provisional results of the queries in progress, this one
+  /// outlives the queries.
+  DenseMap<LocPair, AliasResult> QueryCache;
+
+  /// The decomposition of the GEPs seen so far, and whether the decomposition
+  /// hit MaxLookupSearchDepth.
+  DenseMap<const Value *, std::pair<DecomposedGEP, bool>> DecomposedGEPs;
+
+  /// The values the cached entries refer to.
+  SmallPtrSet<const Value *, 16> CachedValues;
+  std::vector<CachedValueHandle> CachedValueHandles;
+
   /// Tracks phi nodes we have visited.
   ///
   /// When interpret "Value" pointer equality as value equality we need to make
@@ -156,6 +200,12 @@ private:
   static bool DecomposeGEPExpression(const Value *V, DecomposedGEP &Decomposed,
       const DataLayout &DL, AssumptionCache *AC, DominatorTree *DT);
 
+  /// DecomposeGEPExpression, through the cache of decompositions.
+  bool decomposeGEP(const Value *V, DecomposedGEP &Decomposed);
+
+  /// Flush the caches when \p V changes.
+  void trackCachedValue(const Value *V);
+
   static bool isGEPBaseAtNegativeOffset(const GEPOperator *GEPOp,
       const DecomposedGEP &DecompGEP, const DecomposedGEP &DecompObject,
       uint64_t ObjectAccessSize);
@@ -207,6 +257,11 @@ public:
 };
 
 /// Legacy wrapper pass to provide the BasicAAResult object.
+///
+/// Its result never caches across queries: the legacy pass manager keeps it
+/// across the passes that preserve it, such as InstCombine, without telling
+/// it whether they changed the function. The legacy pipelines, including the
+/// default -O2 one, therefore get none of the benefit of those caches.
 class BasicAAWrapperPass : public FunctionPass {
   std::unique_ptr<BasicAAResult> Result;
 
@@ -23,6 +23,7 @@
 
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/IR/ConstantRange.h"
@@ -540,6 +541,19 @@ namespace llvm {
     /// predicate by splitting it into a set of independent predicates.
     bool ProvingSplitPredicate;
 
+    /// The number of values createSCEV may still analyze and of expressions
+    /// getAddExpr and getMulExpr may still try to fold in this function. Once
+    /// it runs out, new values are left as SCEVUnknowns and sums and products
+    /// are no longer simplified, which bounds the time spent on pathological
+    /// expression trees.
+    unsigned FoldingBudget;
+
+    /// Set while createSCEV builds the expression of a new value. Only these
+    /// sums and products are subject to the folding budget: clients computing
+    /// e.g. the distance between two add recurrences expect the same answer
+    /// each time, however much of the budget is left.
+    bool CreatingSCEV;
+
     /// Information about the number of loop iterations for which a loop exit's
     /// branch condition evaluates to the not-taken path.  This is a temporary
     /// pair of exact and max expressions that are eventually summarized in
@@ -932,6 +946,24 @@ namespace llvm {
                                        bool ControlsExit,
                                        bool AllowPredicates = false);
 
+    /// The exit limits computeExitLimitFromCond found for the operands of an
+    /// exit condition, keyed by the operand and ControlsExit. A chain of
+    /// and/or whose operands are shared would otherwise be walked once per
+    /// path through it, i.e. an exponential number of times.
+    typedef DenseMap<PointerIntPair<Value *, 1, bool>, ExitLimit>
+        ExitLimitCacheTy;
+
+    ExitLimit computeExitLimitFromCondCached(ExitLimitCacheTy &Cache,
+                                             const Loop *L, Value *ExitCond,
+                                             BasicBlock *TBB, BasicBlock *FBB,
+                                             bool ControlsExit,
+                                             bool AllowPredicates);
+    ExitLimit computeExitLimitFromCondImpl(ExitLimitCacheTy &Cache,
+                                           const Loop *L, Value *ExitCond,
+                                           BasicBlock *TBB, BasicBlock *FBB,
+                                           bool ControlsExit,
+                                           bool AllowPredicates);
+
     /// Compute the number of times the backedge of the specified loop will
     /// execute if its exit condition were a conditional branch of the ICmpInst
     /// ExitCond, TBB, and FBB. If AllowPredicates is set, this call will try
@@ -1023,6 +1055,15 @@ namespace llvm {
                        Value *FoundCondValue,
                        bool Inverse);
 
+    /// Implementation of the above, which looks through the and/or of
+    /// conditions. Visited holds the conditions already tried, so that each
+    /// operand shared in the and/or tree is only tried once.
+    bool isImpliedCond(ICmpInst::Predicate Pred,
+                       const SCEV *LHS, const SCEV *RHS,
+                       Value *FoundCondValue,
+                       bool Inverse,
+                       SmallPtrSetImpl<Value *> &Visited);
+
     /// Test whether the condition described by Pred, LHS, and RHS is true
     /// whenever the condition described by FoundPred, FoundLHS, FoundRHS is
     /// true.
@@ -1680,6 +1721,20 @@ namespace llvm {
     bool doesIVOverflowOnGT(const SCEV *RHS, const SCEV *Stride,
                             bool IsSigned, bool NoWrap);
 
+    /// Charge one unit of work to the folding budget. Returns false if the
+    /// budget is already exhausted.
+    bool consumeFoldingBudget();
+
+    /// Return the add expression of \p Ops, which must already be sorted by
+    /// GroupByComplexity, without trying to fold them.
+    const SCEV *getOrCreateAddExpr(SmallVectorImpl<const SCEV *> &Ops,
+                                   SCEV::NoWrapFlags Flags);
+
+    /// Return the mul expression of \p Ops, which must already be sorted by
+    /// GroupByComplexity, without trying to fold them.
+    const SCEV *getOrCreateMulExpr(SmallVectorImpl<const SCEV *> &Ops,
+                                   SCEV::NoWrapFlags Flags);
+
   private:
     FoldingSet<SCEV> UniqueSCEVs;
     FoldingSet<SCEVPredicate> UniquePreds;
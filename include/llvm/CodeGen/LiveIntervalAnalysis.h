@@ -66,6 +66,10 @@ extern cl::opt<bool> UseSegmentSetForPhysRegs;
     /// Live interval pointers for all the virtual registers.
     IndexedMap<LiveInterval*, VirtReg2IndexFunctor> VirtRegIntervals;
 
+    /// True if the intervals of virtual registers are only computed when
+    /// first queried, rather than all up front.
+    bool Lazy;
+
     /// RegMaskSlots - Sorted list of instructions with register mask operands.
     /// Always use the 'r' slot, RegMasks are normal clobbers, not early
     /// clobbers.
@@ -117,10 +121,17 @@ extern cl::opt<bool> UseSegmentSetForPhysRegs;
       return const_cast<LiveIntervals*>(this)->getInterval(Reg);
     }
 
+    /// Return true if the interval of \p Reg has been computed. In lazy mode,
+    /// a virtual register with operands may not have one yet, getInterval()
+    /// computes it.
     bool hasInterval(unsigned Reg) const {
       return VirtRegIntervals.inBounds(Reg) && VirtRegIntervals[Reg];
     }
 
+    /// Return true if the intervals of virtual registers are computed on
+    /// first query.
+    bool isLazy() const { return Lazy; }
+
     // Interval creation.
     LiveInterval &createEmptyInterval(unsigned Reg) {
       assert(!hasInterval(Reg) && "Interval already exists!");
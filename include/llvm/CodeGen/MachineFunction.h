@@ -199,6 +199,16 @@ class MachineFunction {
   // Allocation management for operand arrays on instructions.
   ArrayRecycler<MachineOperand> OperandRecycler;
 
+  // In arena mode, instructions and operand arrays are allocated from
+  // Allocator in creation order, and the memory of deleted ones isn't reused.
+  // Each instruction is then directly followed by its operands, and the
+  // instructions created together, such as those of a block emitted by
+  // instruction selection, are laid out together.
+  bool ArenaStorage;
+
+  // Allocate the memory of a new MachineInstr.
+  void *allocateMachineInstr();
+
   // Allocation management for basic blocks in function.
   Recycler<MachineBasicBlock> BasicBlockRecycler;
 
@@ -548,6 +558,10 @@ public:
   /// Allocate an array of MachineOperands. This is only intended for use by
   /// internal MachineInstr functions.
   MachineOperand *allocateOperandArray(OperandCapacity Cap) {
+    if (ArenaStorage)
+      return static_cast<MachineOperand *>(
+          Allocator.Allocate(sizeof(MachineOperand) * Cap.getSize(),
+                             AlignOf<MachineOperand>::Alignment));
     return OperandRecycler.allocate(Cap, Allocator);
   }
 
@@ -555,7 +569,8 @@ public:
   /// only intended for use by internal MachineInstr functions.
   /// Cap must be the same capacity that was used to allocate the array.
   void deallocateOperandArray(OperandCapacity Cap, MachineOperand *Array) {
-    OperandRecycler.deallocate(Cap, Array);
+    if (!ArenaStorage)
+      OperandRecycler.deallocate(Cap, Array);
   }
 
   /// \brief Allocate and initialize a register mask with @p NumRegister bits.
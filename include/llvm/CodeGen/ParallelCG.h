@@ -30,7 +30,9 @@ class raw_pwrite_stream;
 /// factory function for the TargetMachine TMFactory. Writes OSs.size() output
 /// files to the output streams in OSs. The resulting output files if linked
 /// together are intended to be equivalent to the single output file that would
-/// have been code generated from M.
+/// have been code generated from M. The last partition is generated in the
+/// context of M on the calling thread, the others are moved to contexts of
+/// their own through bitcode and generated on a thread each.
 ///
 /// Writes bitcode for individual partitions into output streams in BCOSs, if
 /// BCOSs is not empty.
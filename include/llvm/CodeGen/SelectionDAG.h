@@ -207,10 +207,17 @@ class SelectionDAG {
   /// CSE with existing nodes when a duplicate is requested.
   FoldingSet<SDNode> CSEMap;
 
-  /// Pool allocation for machine-opcode SDNode operands.
+  /// Pool allocation for machine-opcode SDNode operands. Like the nodes, the
+  /// operand arrays are recycled rather than released when the DAG is
+  /// cleared, so the memory reached by the largest block is reused by the
+  /// following blocks and functions instead of being allocated again.
   BumpPtrAllocator OperandAllocator;
   ArrayRecycler<SDUse> OperandRecycler;
 
+  /// Pool allocation for node data that isn't recycled with the nodes, such
+  /// as shuffle masks. Released when the DAG is cleared.
+  BumpPtrAllocator NodeDataAllocator;
+
   /// Pool allocation for misc. objects that are created once per SelectionDAG.
   BumpPtrAllocator Allocator;
 
@@ -219,6 +226,11 @@ class SelectionDAG {
 
   uint16_t NextPersistentId = 0;
 
+  /// Nodes the DAG combiner found nothing to combine in since they, their
+  /// operands or their users were last modified. Only populated when the
+  /// combiner runs incrementally.
+  DenseSet<SDNode *> CombineSettledNodes;
+
 public:
   /// Clients of various APIs that cause global effects on
   /// the DAG can optionally implement this interface.  This allows the clients
@@ -400,6 +412,17 @@ public:
   void Combine(CombineLevel Level, AliasAnalysis &AA,
                CodeGenOpt::Level OptLevel);
 
+  /// Record that the DAG combiner found nothing to combine in \p N. The mark
+  /// is dropped when N, one of its operands or one of its users is modified
+  /// or deleted, so that incremental combines only revisit what changed.
+  void setCombineSettled(SDNode *N) { CombineSettledNodes.insert(N); }
+
+  /// Return true if the DAG combiner found nothing to combine in \p N and
+  /// nothing around it changed since.
+  bool isCombineSettled(SDNode *N) const {
+    return CombineSettledNodes.count(N);
+  }
+
   /// This transforms the SelectionDAG into a SelectionDAG that
   /// only uses types natively supported by the target.
   /// Returns "true" if it made any changes.
@@ -1390,6 +1413,7 @@ private:
 
   void DeleteNodeNotInCSEMaps(SDNode *N);
   void DeallocateNode(SDNode *N);
+  void unsettleCombineAround(SDNode *N);
 
   void allnodes_clear();
 
@@ -66,6 +66,8 @@ public:
 
   bool runOnMachineFunction(MachineFunction &MF) override;
 
+  bool doFinalization(Module &M) override;
+
   virtual void EmitFunctionEntryCode() {}
 
   /// PreprocessISelDAG - This hook allows targets to hack on the graph before
@@ -266,6 +268,12 @@ private:
   void CannotYetSelect(SDNode *N);
 
 private:
+  /// Instructions selected, instructions FastISel left to SelectionDAG, and
+  /// wall time spent selecting, for -isel-report-throughput.
+  uint64_t NumInstsSelected;
+  uint64_t NumInstsFellBack;
+  double SelectionTime;
+
   void DoInstructionSelection();
   SDNode *MorphNode(SDNode *Node, unsigned TargetOpc, SDVTList VTs,
                     ArrayRef<SDValue> Ops, unsigned EmitNodeInfo);
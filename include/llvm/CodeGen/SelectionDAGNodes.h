@@ -30,6 +30,7 @@
 #include "llvm/CodeGen/ISDOpcodes.h"
 #include "llvm/CodeGen/MachineMemOperand.h"
 #include "llvm/CodeGen/ValueTypes.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DebugLoc.h"
 #include "llvm/IR/Instructions.h"
@@ -446,9 +447,12 @@ private:
   friend class HandleSDNode;
 
 public:
+#ifdef LLVM_ENABLE_ABI_BREAKING_CHECKS
   /// Unique and persistent id per SDNode in the DAG.
-  /// Used for debug printing.
+  /// Used for debug printing. Without it, SDNode and hence every slot of the
+  /// node allocator is 8 bytes smaller on 64-bit hosts.
   uint16_t PersistentId;
+#endif
 
   //===--------------------------------------------------------------------===//
   //  Accessors
@@ -973,9 +977,11 @@ class HandleSDNode : public SDNode {
 public:
   explicit HandleSDNode(SDValue X)
     : SDNode(ISD::HANDLENODE, 0, DebugLoc(), getSDVTList(MVT::Other)) {
+#ifdef LLVM_ENABLE_ABI_BREAKING_CHECKS
     // HandleSDNodes are never inserted into the DAG, so they won't be
     // auto-numbered. Use ID 65535 as a sentinel.
     PersistentId = 0xffff;
+#endif
 
     // Manually set up the operand list. This node type is special in that it's
     // always stack allocated and SelectionDAG does not manage its operands.
@@ -1227,8 +1233,8 @@ public:
 /// An index of -1 is treated as undef, such that the code generator may put
 /// any value in the corresponding element of the result.
 class ShuffleVectorSDNode : public SDNode {
-  // The memory for Mask is owned by the SelectionDAG's OperandAllocator, and
-  // is freed when the SelectionDAG object is destroyed.
+  // The memory for Mask is owned by the SelectionDAG's NodeDataAllocator, and
+  // is freed when the SelectionDAG is cleared or destroyed.
   const int *Mask;
 protected:
   friend class SelectionDAG;
@@ -22,6 +22,7 @@
 #include "llvm/DebugInfo/DWARF/DWARFDebugRangeList.h"
 #include "llvm/DebugInfo/DWARF/DWARFSection.h"
 #include "llvm/DebugInfo/DWARF/DWARFTypeUnit.h"
+#include <mutex>
 
 namespace llvm {
 
@@ -45,6 +46,7 @@ class DWARFContext : public DIContext {
   std::unique_ptr<DWARFDebugAbbrev> Abbrev;
   std::unique_ptr<DWARFDebugLoc> Loc;
   std::unique_ptr<DWARFDebugAranges> Aranges;
+  std::once_flag ArangesOnce;
   std::unique_ptr<DWARFDebugLine> Line;
   std::unique_ptr<DWARFDebugFrame> DebugFrame;
   std::unique_ptr<DWARFDebugFrame> EHFrame;
@@ -55,6 +57,9 @@ class DWARFContext : public DIContext {
   std::unique_ptr<DWARFDebugAbbrev> AbbrevDWO;
   std::unique_ptr<DWARFDebugLocDWO> LocDWO;
 
+  /// Number of threads used when the DIEs of every unit need to be extracted.
+  unsigned NumThreads = 1;
+
   DWARFContext(DWARFContext &) = delete;
   DWARFContext &operator=(DWARFContext &) = delete;
 
@@ -136,6 +141,16 @@ public:
     return DWOTUs.size();
   }
 
+  /// Set the number of threads used to extract the DIEs of all the compile
+  /// units at once, e.g. when building the address to compile unit index
+  /// without .debug_aranges. Units are still extracted lazily otherwise.
+  void setNumThreads(unsigned N) { NumThreads = std::max(N, 1U); }
+  unsigned getNumThreads() const { return NumThreads; }
+
+  /// Extract the DIEs of every compile unit, in parallel if getNumThreads()
+  /// is greater than one. Units already extracted are left untouched.
+  void extractCompileUnitDIEs();
+
   /// Get the compile unit at the specified index for this compile unit.
   DWARFCompileUnit *getCompileUnitAtIndex(unsigned index) {
     parseCompileUnits();
@@ -163,7 +178,8 @@ public:
   /// Get a pointer to the parsed DebugLoc object.
   const DWARFDebugLocDWO *getDebugLocDWO();
 
-  /// Get a pointer to the parsed DebugAranges object.
+  /// Get a pointer to the parsed DebugAranges object. It is built once, and
+  /// then shared by concurrent queries.
   const DWARFDebugAranges *getDebugAranges();
 
   /// Get a pointer to the parsed frame information object.
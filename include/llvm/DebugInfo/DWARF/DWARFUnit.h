@@ -17,6 +17,7 @@
 #include "llvm/DebugInfo/DWARF/DWARFRelocMap.h"
 #include "llvm/DebugInfo/DWARF/DWARFSection.h"
 #include "llvm/DebugInfo/DWARF/DWARFUnitIndex.h"
+#include <mutex>
 #include <vector>
 
 namespace llvm {
@@ -125,6 +126,10 @@ class DWARFUnit {
   uint64_t BaseAddr;
   // The compile unit debug information entry items.
   std::vector<DWARFDebugInfoEntryMinimal> DieArray;
+  // Serializes extraction and clearing of DieArray, so that a unit extracted
+  // from several threads is only parsed once. The readers of DieArray don't
+  // take it.
+  std::recursive_mutex DieArrayMutex;
 
   class DWOHolder {
     object::OwningBinary<object::ObjectFile> DWOFile;
@@ -219,6 +224,15 @@ public:
   /// getUnitSection - Return the DWARFUnitSection containing this unit.
   const DWARFUnitSectionBase &getUnitSection() const { return UnitSection; }
 
+  /// \brief Extracts all the DIEs of the unit if that hasn't been done yet.
+  /// Concurrent extractions of the unit are serialized, so it is parsed at
+  /// most once. Concurrent readers are not supported: getUnitDIE(),
+  /// getNumDIEs(), getDIEAtIndex() and the DIE links may see the array being
+  /// reallocated by an extraction on another thread. Pointers to DIEs
+  /// previously obtained from getUnitDIE() are invalidated if only the unit
+  /// DIE had been extracted so far.
+  void extractDIEs() { extractDIEsIfNeeded(false); }
+
   /// \brief Returns the number of DIEs in the unit. Parses the unit
   /// if necessary.
   unsigned getNumDIEs() {
@@ -271,6 +285,7 @@ private:
 
   /// extractDIEsIfNeeded - Parses a compile unit and indexes its DIEs if it
   /// hasn't already been done. Returns the number of DIEs parsed at this call.
+  /// Concurrent calls are serialized on DieArrayMutex.
   size_t extractDIEsIfNeeded(bool CUDieOnly);
   /// extractDIEsToVector - Appends all parsed DIEs to a vector.
   void extractDIEsToVector(bool AppendCUDie, bool AppendNonCUDIEs,
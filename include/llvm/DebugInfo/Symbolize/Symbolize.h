@@ -36,6 +36,11 @@ public:
     bool RelativeAddresses : 1;
     std::string DefaultArch;
     std::vector<std::string> DsymHints;
+    /// Directory of the persistent symbolization cache, empty to disable it.
+    std::string CachePath;
+    /// Cache pruning policy, see CachePruning.
+    int CachePruningInterval = 1200;          // seconds, -1 to disable pruning.
+    unsigned CacheExpiration = 7 * 24 * 3600; // seconds (1w default).
     Options(FunctionNameKind PrintFunctions = FunctionNameKind::LinkageName,
             bool UseSymbolTable = true, bool Demangle = true,
             bool RelativeAddresses = false, std::string DefaultArch = "")
@@ -55,7 +60,10 @@ public:
                                                 uint64_t ModuleOffset);
   Expected<DIGlobal> symbolizeData(const std::string &ModuleName,
                                    uint64_t ModuleOffset);
-  void flush();
+  /// Release the loaded modules. With a cache path, the results computed
+  /// since they were loaded are first written to the cache, and the first
+  /// error doing so is returned.
+  std::error_code flush();
   static std::string DemangleName(const std::string &Name,
                                   const SymbolizableModule *ModInfo);
 
@@ -71,6 +79,16 @@ private:
   Expected<SymbolizableModule *>
   getOrCreateModuleInfo(const std::string &ModuleName);
 
+  /// Creates the SymbolizableModule for a binary from its debug info.
+  Expected<std::unique_ptr<SymbolizableModule>>
+  createModuleInfo(const std::string &BinaryName, const std::string &ArchName);
+
+  /// Creates the SymbolizableModule for a binary that answers from the cache
+  /// when it can, and reads the debug info otherwise.
+  Expected<std::unique_ptr<SymbolizableModule>>
+  createCachedModuleInfo(const std::string &BinaryName,
+                         const std::string &ArchName);
+
   ObjectFile *lookUpDsymFile(const std::string &Path,
                              const MachOObjectFile *ExeObj,
                              const std::string &ArchName);
@@ -38,6 +38,13 @@ extern template void Calculate<Function, Inverse<BasicBlock *>>(
     DominatorTreeBase<GraphTraits<Inverse<BasicBlock *>>::NodeType> &DT,
     Function &F);
 
+extern template void ApplyUpdates<Function, BasicBlock *>(
+    DominatorTreeBase<GraphTraits<BasicBlock *>::NodeType> &DT, Function &F,
+    ArrayRef<DominatorTreeBase<BasicBlock>::UpdateType> Updates);
+extern template void ApplyUpdates<Function, Inverse<BasicBlock *>>(
+    DominatorTreeBase<GraphTraits<Inverse<BasicBlock *>>::NodeType> &DT,
+    Function &F, ArrayRef<DominatorTreeBase<BasicBlock>::UpdateType> Updates);
+
 typedef DomTreeNodeBase<BasicBlock> DomTreeNode;
 
 class BasicBlockEdge {
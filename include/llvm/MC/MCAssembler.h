@@ -178,9 +178,17 @@ private:
   /// were adjusted.
   bool layoutOnce(MCAsmLayout &Layout);
 
-  /// \brief Perform one layout iteration of the given section and return true
-  /// if any offsets were adjusted.
-  bool layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec);
+  /// \brief Perform one layout iteration of the given section and return the
+  /// first fragment that was relaxed, or null if no offsets were adjusted.
+  ///
+  /// \p StableOrder is the layout order of the first fragment relaxed by the
+  /// previous iteration, nothing before it changed since then. The fragments
+  /// whose relaxation only depends on such fragments are known not to need
+  /// relaxing and are skipped. \p DependencyOrders caches, for each fragment,
+  /// the highest layout order it depends on.
+  MCFragment *layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec,
+                                unsigned StableOrder,
+                                std::vector<unsigned> &DependencyOrders);
 
   bool relaxInstruction(MCAsmLayout &Layout, MCRelaxableFragment &IF);
 
@@ -39,6 +39,11 @@ public:
   virtual void encodeInstruction(const MCInst &Inst, raw_ostream &OS,
                                  SmallVectorImpl<MCFixup> &Fixups,
                                  const MCSubtargetInfo &STI) const = 0;
+
+  /// Returns true if encodeInstruction can be called on several threads at
+  /// once. The only state of the MCContext such an emitter may use, besides
+  /// reading it, is its allocator.
+  virtual bool supportsConcurrentEncoding() const { return false; }
 };
 
 } // End llvm namespace
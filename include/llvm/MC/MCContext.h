@@ -24,6 +24,7 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/raw_ostream.h"
 #include <map>
+#include <mutex>
 #include <tuple>
 #include <vector> // FIXME: Shouldn't be needed.
 
@@ -76,6 +77,10 @@ namespace llvm {
     /// objects.
     BumpPtrAllocator Allocator;
 
+    /// Serializes allocate() while ConcurrentAllocation is set.
+    std::mutex AllocatorMutex;
+    bool ConcurrentAllocation = false;
+
     SpecificBumpPtrAllocator<MCSectionCOFF> COFFAllocator;
     SpecificBumpPtrAllocator<MCSectionELF> ELFAllocator;
     SpecificBumpPtrAllocator<MCSectionMachO> MachOAllocator;
@@ -571,7 +576,16 @@ namespace llvm {
     }
     void setSecureLogUsed(bool Value) { SecureLogUsed = Value; }
 
+    /// Allow allocate() to be called from several threads, for instance by
+    /// code emitters encoding concurrently. The rest of the context is still
+    /// not thread-safe.
+    void setConcurrentAllocation(bool Value) { ConcurrentAllocation = Value; }
+
     void *allocate(unsigned Size, unsigned Align = 8) {
+      if (ConcurrentAllocation) {
+        std::lock_guard<std::mutex> Lock(AllocatorMutex);
+        return Allocator.Allocate(Size, Align);
+      }
       return Allocator.Allocate(Size, Align);
     }
     void deallocate(void *Ptr) {}
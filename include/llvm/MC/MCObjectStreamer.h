@@ -14,6 +14,7 @@
 #include "llvm/MC/MCAssembler.h"
 #include "llvm/MC/MCSection.h"
 #include "llvm/MC/MCStreamer.h"
+#include <vector>
 
 namespace llvm {
 class MCAssembler;
@@ -22,6 +23,7 @@ class MCSubtargetInfo;
 class MCExpr;
 class MCFragment;
 class MCDataFragment;
+class MCRelaxableFragment;
 class MCAsmBackend;
 class raw_ostream;
 class raw_pwrite_stream;
@@ -39,6 +41,8 @@ class MCObjectStreamer : public MCStreamer {
   bool EmitEHFrame;
   bool EmitDebugFrame;
   SmallVector<MCSymbol *, 2> PendingLabels;
+  /// Relaxable fragments whose instruction is encoded by FinishImpl.
+  std::vector<MCRelaxableFragment *> DeferredEncodings;
 
   virtual void EmitInstToData(const MCInst &Inst, const MCSubtargetInfo&) = 0;
   void EmitCFIStartProcImpl(MCDwarfFrameInfo &Frame) override;
@@ -81,6 +85,15 @@ protected:
   /// will be used as a symbol offset within the fragment.
   void flushPendingLabels(MCFragment *F, uint64_t FOffset = 0);
 
+  /// Called once the instruction of the relaxable fragment \p F has been
+  /// encoded. This happens in EmitInstToFragment, or in FinishImpl when
+  /// encoding is done there on several threads.
+  virtual void finishInstFragment(MCRelaxableFragment &F) {}
+
+  /// Encode the instructions of the relaxable fragments created since the
+  /// last call, on up to -mc-encoding-threads threads.
+  void encodeDeferredInstructions();
+
 public:
   void visitUsedSymbol(const MCSymbol &Sym) override;
 
@@ -14,6 +14,7 @@
 #ifndef LLVM_OBJECT_ARCHIVE_H
 #define LLVM_OBJECT_ARCHIVE_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/iterator_range.h"
@@ -22,6 +23,7 @@
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <mutex>
 
 namespace llvm {
 namespace object {
@@ -147,6 +149,7 @@ public:
     const Archive *Parent;
     uint32_t SymbolIndex;
     uint32_t StringIndex; // Extra index to the string.
+    friend class Archive;
 
   public:
     bool operator ==(const Symbol &other) const {
@@ -215,7 +218,8 @@ public:
     return v->isArchive();
   }
 
-  // check if a symbol is in the archive
+  // check if a symbol is in the archive. The first lookup builds a hash index
+  // of the symbol table, later lookups take constant time.
   Expected<Optional<Child>> findSym(StringRef name) const;
 
   bool hasSymbolTable() const;
@@ -237,6 +241,13 @@ private:
   unsigned Format : 3;
   unsigned IsThin : 1;
   mutable std::vector<std::unique_ptr<MemoryBuffer>> ThinBuffers;
+
+  /// Maps the name of each symbol to the symbol and string indices of its
+  /// first occurrence in the symbol table. Names point into the symbol table.
+  /// Built by the first findSym, which may be called from several threads.
+  typedef DenseMap<StringRef, std::pair<uint32_t, uint32_t>> SymbolMapTy;
+  mutable SymbolMapTy SymbolMap;
+  mutable std::once_flag SymbolMapOnce;
 };
 
 }
@@ -19,6 +19,7 @@
 #include "llvm/Analysis/CGSCCPassManager.h"
 #include "llvm/Analysis/LoopPassManager.h"
 #include "llvm/IR/PassManager.h"
+#include <string>
 
 namespace llvm {
 class StringRef;
@@ -33,6 +34,8 @@ class TargetMachine;
 /// construction.
 class PassBuilder {
   TargetMachine *TM;
+  unsigned FunctionPipelineThreads;
+  std::string FunctionPipelineAAText;
 
 public:
   /// \brief LLVM-provided high-level optimization levels.
@@ -121,7 +124,8 @@ public:
     Oz
   };
 
-  explicit PassBuilder(TargetMachine *TM = nullptr) : TM(TM) {}
+  explicit PassBuilder(TargetMachine *TM = nullptr)
+      : TM(TM), FunctionPipelineThreads(1) {}
 
   /// \brief Cross register the analysis managers through their proxies.
   ///
@@ -241,6 +245,21 @@ public:
   /// returns false.
   bool parseAAPipeline(AAManager &AA, StringRef PipelineText);
 
+  /// \brief Run the function pipelines parsed at module level concurrently.
+  ///
+  /// Function pipelines subsequently parsed directly within a module pipeline
+  /// split the module's functions into \p ThreadCount partitions and optimize
+  /// each one on its own thread, in its own LLVMContext, with analyses set up
+  /// from this builder and the textual alias analysis pipeline \p AAPipeline.
+  /// The optimized functions are then merged back into the module. Module and
+  /// CGSCC passes, and the function pipelines nested in CGSCC pipelines, still
+  /// run serially.
+  void setParallelFunctionPipelines(unsigned ThreadCount,
+                                    StringRef AAPipeline) {
+    FunctionPipelineThreads = ThreadCount;
+    FunctionPipelineAAText = AAPipeline;
+  }
+
 private:
   bool parseModulePassName(ModulePassManager &MPM, StringRef Name,
                            bool DebugLogging);
@@ -257,6 +276,9 @@ private:
                               bool VerifyEachPass, bool DebugLogging);
   bool parseModulePassPipeline(ModulePassManager &MPM, StringRef &PipelineText,
                                bool VerifyEachPass, bool DebugLogging);
+  void addFunctionPipeline(ModulePassManager &MPM, FunctionPassManager FPM,
+                           StringRef PipelineText, bool VerifyEachPass,
+                           bool DebugLogging);
 };
 }
 
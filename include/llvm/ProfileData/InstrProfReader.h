@@ -18,6 +18,7 @@
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ProfileData/InstrProf.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/EndianStream.h"
 #include "llvm/Support/LineIterator.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -263,6 +264,16 @@ class InstrProfLookupTrait {
   // for testing purpose.
   support::endianness ValueProfDataEndianness;
 
+  /// Read the hash and the counters of the record at \p D, pointing \p Counts
+  /// to them in place, and advance \p D past the counters. Returns false if
+  /// the data is malformed.
+  bool readCounts(const unsigned char *&D, const unsigned char *const End,
+                  uint64_t N, uint64_t &Hash,
+                  ArrayRef<support::ulittle64_t> &Counts);
+  /// Advance \p D past the value profiling data at \p D.
+  bool skipValueProfilingData(const unsigned char *&D,
+                              const unsigned char *const End);
+
 public:
   InstrProfLookupTrait(IndexedInstrProf::HashT HashType, unsigned FormatVersion)
       : HashType(HashType), FormatVersion(FormatVersion),
@@ -297,6 +308,12 @@ public:
                               const unsigned char *const End);
   data_type ReadData(StringRef K, const unsigned char *D, offset_type N);
 
+  /// Find the counters of the record with hash \p FuncHash in the data \p D
+  /// of length \p N of a key, and point \p Counts to them in place. Returns
+  /// an error if there is no such record or the data is malformed.
+  Error findCounts(const unsigned char *D, offset_type N, uint64_t FuncHash,
+                   ArrayRef<support::ulittle64_t> &Counts);
+
   // Used for testing purpose only.
   void setValueProfDataEndianness(support::endianness Endianness) {
     ValueProfDataEndianness = Endianness;
@@ -310,6 +327,12 @@ struct InstrProfReaderIndexBase {
   // Read all the profile records with the key equal to FuncName
   virtual Error getRecords(StringRef FuncName,
                                      ArrayRef<InstrProfRecord> &Data) = 0;
+  // Point Counts to the counters of the record with the key equal to FuncName
+  // and the given hash, in place.
+  virtual Error getCounts(StringRef FuncName, uint64_t FuncHash,
+                          ArrayRef<support::ulittle64_t> &Counts) = 0;
+  // Append the keys of all the records to Names.
+  virtual void getFuncNames(std::vector<StringRef> &Names) = 0;
   virtual void advanceToNextKey() = 0;
   virtual bool atEnd() const = 0;
   virtual void setValueProfDataEndianness(support::endianness Endianness) = 0;
@@ -339,6 +362,12 @@ public:
   Error getRecords(ArrayRef<InstrProfRecord> &Data) override;
   Error getRecords(StringRef FuncName,
                    ArrayRef<InstrProfRecord> &Data) override;
+  Error getCounts(StringRef FuncName, uint64_t FuncHash,
+                  ArrayRef<support::ulittle64_t> &Counts) override;
+  void getFuncNames(std::vector<StringRef> &Names) override {
+    for (StringRef Name : HashTable->keys())
+      Names.push_back(Name);
+  }
   void advanceToNextKey() override { RecordIterator++; }
   bool atEnd() const override {
     return RecordIterator == HashTable->data_end();
@@ -398,6 +427,24 @@ public:
   Error getFunctionCounts(StringRef FuncName, uint64_t FuncHash,
                           std::vector<uint64_t> &Counts);
 
+  /// Point \p Counts to the counters of the given function, in place in the
+  /// profile data. Unlike getFunctionCounts, nothing is copied or allocated,
+  /// and the (memory mapped) profile is only touched where the function's
+  /// entry is. \p Counts is valid as long as the reader is.
+  Error getFunctionCounts(StringRef FuncName, uint64_t FuncHash,
+                          ArrayRef<support::ulittle64_t> &Counts);
+
+  /// Return all the records of the given function, with any hash. They are
+  /// valid until the next lookup.
+  Error getFunctionRecords(StringRef FuncName,
+                           ArrayRef<InstrProfRecord> &Records);
+
+  /// Append the names of all the functions in the profile to \p Names. The
+  /// names point into the profile data.
+  void getFunctionNames(std::vector<StringRef> &Names) {
+    Index->getFuncNames(Names);
+  }
+
   /// Return the maximum of all known function counts.
   uint64_t getMaximumFunctionCount() { return Summary->getMaxFunctionCount(); }
 
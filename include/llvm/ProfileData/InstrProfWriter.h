@@ -24,12 +24,15 @@
 namespace llvm {
 
 /// Writer for instrumentation based profile data.
+class IndexedInstrProfReader;
 class ProfOStream;
 class InstrProfRecordWriterTrait;
 
 class InstrProfWriter {
 public:
   typedef SmallDenseMap<uint64_t, InstrProfRecord, 1> ProfilingData;
+  /// An indexed profile to merge, with its weight.
+  typedef std::pair<IndexedInstrProfReader *, uint64_t> WeightedInput;
   enum ProfKind { PF_Unknown = 0, PF_FE, PF_IRLevel };
 
 private:
@@ -47,8 +50,20 @@ public:
   /// for this function and the hash and number of counts match, each counter is
   /// summed. Optionally scale counts by \p Weight.
   Error addRecord(InstrProfRecord &&I, uint64_t Weight = 1);
+  /// Add function counts for the given function to \p ProfileDataMap, the
+  /// records of one function, merging them as above.
+  static Error addRecord(ProfilingData &ProfileDataMap, InstrProfRecord &&I,
+                         uint64_t Weight);
   /// Merge existing function counts from the given writer.
   Error mergeRecordsFromWriter(InstrProfWriter &&IPW);
+  /// Merge the indexed profiles \p Inputs and write the result to \c OS,
+  /// without holding all the merged records in memory: only the function
+  /// names are collected up front, and the records of each function are
+  /// looked up in the inputs and merged when its entry is written. Errors
+  /// merging the records of a function are reported to \p Warn with the
+  /// function name. The records added to this writer are ignored.
+  Error writeMerged(raw_fd_ostream &OS, ArrayRef<WeightedInput> Inputs,
+                    function_ref<void(Error, StringRef)> Warn);
   /// Write the profile to \c OS
   void write(raw_fd_ostream &OS);
   /// Write the profile in text format to \c OS
@@ -77,7 +92,10 @@ public:
 
 private:
   bool shouldEncodeData(const ProfilingData &PD);
+  bool hasNonZeroCounts(StringRef Name, ArrayRef<WeightedInput> Inputs);
   void writeImpl(ProfOStream &OS);
+  void writeIndexed(ProfOStream &OS,
+                    function_ref<uint64_t(raw_ostream &)> EmitHashTable);
 };
 
 } // end namespace llvm
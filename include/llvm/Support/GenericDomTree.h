@@ -18,6 +18,7 @@
 #ifndef LLVM_SUPPORT_GENERICDOMTREE_H
 #define LLVM_SUPPORT_GENERICDOMTREE_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/GraphTraits.h"
@@ -27,6 +28,7 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <type_traits>
 
 namespace llvm {
 
@@ -180,6 +182,13 @@ template <class FuncT, class N>
 void Calculate(DominatorTreeBase<typename GraphTraits<N>::NodeType> &DT,
                FuncT &F);
 
+// So is the incremental update routine.
+template <class FuncT, class N>
+void ApplyUpdates(
+    DominatorTreeBase<typename GraphTraits<N>::NodeType> &DT, FuncT &F,
+    ArrayRef<typename DominatorTreeBase<
+        typename GraphTraits<N>::NodeType>::UpdateType> Updates);
+
 /// \brief Core dominator tree base class.
 ///
 /// This class is a generic template over graph nodes. It is instantiated for
@@ -608,6 +617,38 @@ public:
       this->Split<NodeT *, GraphTraits<NodeT *>>(*this, NewBB);
   }
 
+  /// The kinds of CFG changes applyUpdates knows about.
+  enum UpdateKind { Insert, Delete };
+
+  /// A CFG edge From -> To that was inserted or deleted. The edge is always
+  /// given in the direction of the CFG, for post-dominator trees as well.
+  struct UpdateType {
+    UpdateKind Kind;
+    NodeT *From;
+    NodeT *To;
+  };
+
+  /// applyUpdates - Update the tree after the CFG edges in Updates were
+  /// inserted or deleted, instead of recalculating it. The CFG must already
+  /// reflect all of the updates, which may come in any order and may cancel
+  /// each other out. Blocks the updates make unreachable are dropped from the
+  /// tree, so they must not be deleted before the tree is updated; blocks they
+  /// make reachable are added.
+  ///
+  /// Only the subtree of the nearest common dominator of the changed edges is
+  /// recomputed, so a batch of local changes costs time proportional to the
+  /// part of the CFG they affect rather than to the whole function.
+  void applyUpdates(ArrayRef<UpdateType> Updates) {
+    if (Updates.empty())
+      return;
+    auto &F = *Updates.front().From->getParent();
+    typedef typename std::remove_reference<decltype(F)>::type FT;
+    if (this->IsPostDominators)
+      ApplyUpdates<FT, Inverse<NodeT *>>(*this, F, Updates);
+    else
+      ApplyUpdates<FT, NodeT *>(*this, F, Updates);
+  }
+
   /// print - Convert to human readable form
   ///
   void print(raw_ostream &o) const {
@@ -639,6 +680,12 @@ protected:
   friend void
   Calculate(DominatorTreeBase<typename GraphTraits<N>::NodeType> &DT, FuncT &F);
 
+  template <class FuncT, class N>
+  friend void ApplyUpdates(
+      DominatorTreeBase<typename GraphTraits<N>::NodeType> &DT, FuncT &F,
+      ArrayRef<typename DominatorTreeBase<
+          typename GraphTraits<N>::NodeType>::UpdateType> Updates);
+
 
   DomTreeNodeBase<NodeT> *getNodeForBlock(NodeT *BB) {
     if (DomTreeNodeBase<NodeT> *Node = getNode(BB))
@@ -255,8 +255,10 @@ void Calculate(DominatorTreeBase<typename GraphTraits<NodeT>::NodeType>& DT,
            llvm::make_unique<DomTreeNodeBase<typename GraphT::NodeType>>(
                Root, nullptr)).get();
 
-  // Loop over all of the reachable blocks in the function...
-  for (unsigned i = 2; i <= N; ++i) {
+  // Loop over all of the reachable blocks in the function. The first one is
+  // the root, unless the virtual exit was only found to be needed after
+  // numbering the blocks of a single exit, which then still needs its node.
+  for (unsigned i = DT.Vertex[1] == Root ? 2 : 1; i <= N; ++i) {
     typename GraphT::NodeType* W = DT.Vertex[i];
 
     // Don't replace this with 'count', the insertion side effect is important
@@ -286,6 +288,189 @@ void Calculate(DominatorTreeBase<typename GraphTraits<NodeT>::NodeType>& DT,
 
   DT.updateDFSNumbers();
 }
+
+/// Returns the nearest common ancestor of A and B in a dominator tree.
+template <class NodeT>
+DomTreeNodeBase<NodeT> *
+nearestCommonAncestor(DomTreeNodeBase<NodeT> *A, DomTreeNodeBase<NodeT> *B) {
+  SmallPtrSet<DomTreeNodeBase<NodeT> *, 16> AncestorsOfA;
+  for (DomTreeNodeBase<NodeT> *N = A; N; N = N->getIDom())
+    AncestorsOfA.insert(N);
+  while (B && !AncestorsOfA.count(B))
+    B = B->getIDom();
+  return B;
+}
+
+// Let R be the nearest common dominator of the endpoints of the updates that
+// are in the tree. Every path from the root to an updated edge goes through R,
+// so R still dominates the blocks it dominated, as well as the blocks that
+// become reachable. The paths to the other blocks that avoid R are untouched,
+// so their dominators do not change either, unless one of them is reached
+// from a block dominated by R that becomes unreachable, or from a block that
+// becomes reachable. R is raised until that does not happen, then only the
+// blocks it dominates are recomputed, with the iterative algorithm from
+// "A Simple, Fast Dominance Algorithm" by Cooper, Harvey and Kennedy.
+template <class FuncT, class NodeT>
+void ApplyUpdates(
+    DominatorTreeBase<typename GraphTraits<NodeT>::NodeType> &DT, FuncT &F,
+    ArrayRef<typename DominatorTreeBase<
+        typename GraphTraits<NodeT>::NodeType>::UpdateType> Updates) {
+  typedef GraphTraits<NodeT> GraphT;
+  typedef GraphTraits<Inverse<NodeT>> InvTraits;
+  typedef typename GraphT::NodeType BlockT;
+  typedef DomTreeNodeBase<BlockT> TreeNodeT;
+
+  TreeNodeT *R = nullptr;
+  for (const auto &U : Updates) {
+    for (BlockT *BB : {U.From, U.To}) {
+      // The roots of a post-dominator tree are the exits of the function.
+      if (DT.isPostDominator() &&
+          (InvTraits::child_begin(BB) == InvTraits::child_end(BB)) !=
+              is_contained(DT.Roots, BB)) {
+        DT.recalculate(F);
+        return;
+      }
+      if (TreeNodeT *N = DT.getNode(BB))
+        R = R ? nearestCommonAncestor(R, N) : N;
+    }
+  }
+  // Updates between blocks that stay unreachable do not change anything.
+  if (!R)
+    return;
+
+  SmallVector<BlockT *, 32> Subtree;
+  SmallPtrSet<BlockT *, 32> InSubtree;
+  SmallPtrSet<BlockT *, 32> Visited;
+  SmallVector<BlockT *, 32> PostOrder;
+  while (true) {
+    if (R == DT.getRootNode()) {
+      DT.recalculate(F);
+      return;
+    }
+
+    // Collect the blocks R dominated, in preorder.
+    Subtree.clear();
+    InSubtree.clear();
+    SmallVector<TreeNodeT *, 32> Worklist(1, R);
+    while (!Worklist.empty()) {
+      TreeNodeT *N = Worklist.pop_back_val();
+      Subtree.push_back(N->getBlock());
+      InSubtree.insert(N->getBlock());
+      Worklist.append(N->begin(), N->end());
+    }
+
+    // Walk the updated CFG from R through these blocks and the blocks that
+    // were unreachable.
+    Visited.clear();
+    PostOrder.clear();
+    SmallVector<std::pair<BlockT *, typename GraphT::ChildIteratorType>, 32>
+        Stack;
+    Visited.insert(R->getBlock());
+    Stack.push_back(
+        std::make_pair(R->getBlock(), GraphT::child_begin(R->getBlock())));
+    while (!Stack.empty()) {
+      BlockT *BB = Stack.back().first;
+      typename GraphT::ChildIteratorType &It = Stack.back().second;
+      if (It == GraphT::child_end(BB)) {
+        PostOrder.push_back(BB);
+        Stack.pop_back();
+        continue;
+      }
+      BlockT *Succ = *It++;
+      if ((InSubtree.count(Succ) || !DT.getNode(Succ)) &&
+          Visited.insert(Succ).second)
+        Stack.push_back(std::make_pair(Succ, GraphT::child_begin(Succ)));
+    }
+
+    // Raise R over the blocks reached from blocks that become reachable or
+    // unreachable.
+    TreeNodeT *NewR = R;
+    auto RaiseOverSuccessors = [&](BlockT *BB) {
+      for (auto SI = GraphT::child_begin(BB), SE = GraphT::child_end(BB);
+           SI != SE; ++SI)
+        if (!InSubtree.count(*SI))
+          if (TreeNodeT *SuccNode = DT.getNode(*SI))
+            NewR = nearestCommonAncestor(NewR, SuccNode);
+    };
+    for (BlockT *BB : PostOrder)
+      if (!InSubtree.count(BB))
+        RaiseOverSuccessors(BB);
+    for (BlockT *BB : Subtree)
+      if (!Visited.count(BB))
+        RaiseOverSuccessors(BB);
+    if (NewR == R)
+      break;
+    R = NewR;
+  }
+
+  // Compute the immediate dominators of the visited blocks, indexed by their
+  // reverse postorder numbers. R is number 0.
+  unsigned NumBlocks = PostOrder.size();
+  DenseMap<BlockT *, unsigned> RPONumbers;
+  for (unsigned I = 0; I != NumBlocks; ++I)
+    RPONumbers[PostOrder[NumBlocks - 1 - I]] = I;
+  const unsigned Undefined = ~0U;
+  SmallVector<unsigned, 32> IDoms;
+  IDoms.resize(NumBlocks, Undefined);
+  IDoms[0] = 0;
+  auto Intersect = [&](unsigned A, unsigned B) {
+    while (A != B) {
+      while (A > B)
+        A = IDoms[A];
+      while (B > A)
+        B = IDoms[B];
+    }
+    return A;
+  };
+  bool Changed = true;
+  while (Changed) {
+    Changed = false;
+    for (unsigned I = 1; I != NumBlocks; ++I) {
+      BlockT *BB = PostOrder[NumBlocks - 1 - I];
+      unsigned NewIDom = Undefined;
+      for (auto PI = InvTraits::child_begin(BB), PE = InvTraits::child_end(BB);
+           PI != PE; ++PI) {
+        auto It = RPONumbers.find(*PI);
+        if (It == RPONumbers.end() || IDoms[It->second] == Undefined)
+          continue;
+        NewIDom =
+            NewIDom == Undefined ? It->second : Intersect(It->second, NewIDom);
+      }
+      if (NewIDom != IDoms[I]) {
+        IDoms[I] = NewIDom;
+        Changed = true;
+      }
+    }
+  }
+
+  // Move the blocks under their new immediate dominators. Those precede them
+  // in reverse postorder, so they are already in place.
+  for (unsigned I = 1; I != NumBlocks; ++I) {
+    BlockT *BB = PostOrder[NumBlocks - 1 - I];
+    BlockT *IDom = PostOrder[NumBlocks - 1 - IDoms[I]];
+    if (TreeNodeT *N = DT.getNode(BB)) {
+      if (N->getIDom()->getBlock() != IDom)
+        DT.changeImmediateDominator(N, DT.getNode(IDom));
+    } else {
+      DT.addNewBlock(BB, IDom);
+    }
+  }
+
+  // Drop the blocks that became unreachable, children first.
+  for (auto I = Subtree.rbegin(), E = Subtree.rend(); I != E; ++I)
+    if (!Visited.count(*I))
+      DT.eraseNode(*I);
+
+  // Whether a post-dominator tree has a virtual root depends on whether all
+  // blocks reach an exit.
+  if (DT.isPostDominator()) {
+    bool HasVirtualRoot = !DT.getRootNode()->getBlock();
+    unsigned NumTreeBlocks = DT.DomTreeNodes.size() - HasVirtualRoot;
+    if (HasVirtualRoot != (DT.Roots.size() > 1 ||
+                           NumTreeBlocks != GraphTraits<FuncT *>::size(&F)))
+      DT.recalculate(F);
+  }
+}
 }
 
 #endif
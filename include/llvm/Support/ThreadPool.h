@@ -7,7 +7,7 @@
 //
 //===----------------------------------------------------------------------===//
 //
-// This file defines a crude C++11 based thread pool.
+// This file defines a C++11 based work-stealing thread pool.
 //
 //===----------------------------------------------------------------------===//
 
@@ -35,19 +35,29 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <utility>
+#include <vector>
 
 namespace llvm {
 
 /// A ThreadPool for asynchronous parallel execution on a defined number of
 /// threads.
 ///
-/// The pool keeps a vector of threads alive, waiting on a condition variable
-/// for some work to become available.
+/// The pool keeps a vector of threads alive, each owning a deque of tasks.
+/// Tasks submitted from a worker thread are pushed on that worker's deque and
+/// popped in LIFO order by their owner, while idle workers steal the oldest
+/// task from the other deques. Tasks submitted from outside the pool are
+/// distributed round-robin. Workers with nothing to run or steal wait on a
+/// condition variable for some work to become available.
+///
+/// A task may submit subtasks and wait on them with wait(Future): the waiting
+/// worker keeps executing queued tasks until the future is ready, so nested
+/// parallelism does not deadlock the pool, and only blocks when there is
+/// nothing left to run.
 class ThreadPool {
 public:
 #ifndef _MSC_VER
@@ -101,22 +111,53 @@ public:
 #endif
   }
 
-  /// Blocking wait for all the threads to complete and the queue to be empty.
-  /// It is an error to try to add new tasks while blocking on this call.
+  /// Blocking wait for all the threads to complete and the queues to be empty.
+  /// It is an error to try to add new tasks while blocking on this call, and
+  /// to call it from one of the pool's own tasks.
   void wait();
 
+  /// Wait for \p Future, which must come from this pool, to be ready. When
+  /// called from a task running on this pool, the calling worker executes
+  /// other queued tasks while waiting, and blocks only once the queues are
+  /// empty.
+  void wait(const std::shared_future<VoidTy> &Future);
+
+  /// Returns true if the calling thread is one of this pool's workers.
+  bool isWorkerThread() const;
+
 private:
+  /// A deque of tasks owned by one worker. The owner pushes and pops at the
+  /// back, thieves take from the front.
+  struct WorkerQueue {
+    std::mutex Lock;
+    std::deque<PackagedTaskTy> Tasks;
+  };
+
   /// Asynchronous submission of a task to the pool. The returned future can be
   /// used to wait for the task to finish and is *non-blocking* on destruction.
   std::shared_future<VoidTy> asyncImpl(TaskTy F);
 
+  /// Pop a task from the queue of worker \p WorkerID, or steal one from
+  /// another worker. Returns false if every queue is empty.
+  bool popTask(unsigned WorkerID, PackagedTaskTy &Task);
+
+  /// Run one queued task on behalf of worker \p WorkerID, if any. Returns
+  /// false if there was nothing to run.
+  bool runOneTask(unsigned WorkerID);
+
   /// Threads in flight
   std::vector<llvm::thread> Threads;
 
-  /// Tasks waiting for execution in the pool.
-  std::queue<PackagedTaskTy> Tasks;
+  /// Per-worker task queues, there is always at least one.
+  std::vector<std::unique_ptr<WorkerQueue>> Queues;
+
+  /// Queue receiving the next task submitted from outside the pool.
+  std::atomic<unsigned> NextQueue;
 
-  /// Locking and signaling for accessing the Tasks queue.
+  /// Number of tasks sitting in the queues.
+  std::atomic<unsigned> QueuedTasks;
+
+  /// Locking and signaling for idle workers waiting for tasks.
   std::mutex QueueLock;
   std::condition_variable QueueCondition;
 
@@ -124,8 +165,11 @@ private:
   std::mutex CompletionLock;
   std::condition_variable CompletionCondition;
 
-  /// Keep track of the number of thread actually busy
-  std::atomic<unsigned> ActiveThreads;
+  /// Number of tasks submitted and not completed yet, queued or running.
+  std::atomic<unsigned> UnfinishedTasks;
+
+  /// Number of workers blocked in wait(Future) on CompletionCondition.
+  std::atomic<unsigned> WaitingWorkers;
 
 #if LLVM_ENABLE_THREADS // avoids warning for unused variable
   /// Signal for the destruction of the pool, asking thread to exit.
@@ -0,0 +1,94 @@
+//===-- llvm/Support/TimeProfiler.h - Trace Event Profiler ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a lightweight profiler recording nested time spans, which
+// can be written out in the Chrome trace event format and opened in a trace
+// viewer such as chrome://tracing.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_TIMEPROFILER_H
+#define LLVM_SUPPORT_TIMEPROFILER_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+#include <chrono>
+#include <string>
+#include <type_traits>
+
+namespace llvm {
+
+class raw_ostream;
+class TimeProfiler;
+
+/// The profiler of the process, null unless timeTraceProfilerInitialize() was
+/// called.
+extern TimeProfiler *TimeTraceProfilerInstance;
+
+/// Start recording time spans. Spans may be recorded from any thread.
+void timeTraceProfilerInitialize();
+
+/// Stop recording and discard the spans recorded so far.
+void timeTraceProfilerCleanup();
+
+/// Returns true if time spans are being recorded.
+inline bool timeTraceProfilerEnabled() {
+  return TimeTraceProfilerInstance != nullptr;
+}
+
+/// Write the spans recorded so far to \p OS as a JSON trace. Each span becomes
+/// a complete ("X") event carrying the span detail and the change of the heap
+/// usage between its beginning and end.
+void timeTraceProfilerWrite(raw_ostream &OS);
+
+/// Write the spans recorded so far to the file \p Path, returns false and sets
+/// \p ErrorInfo if the file can't be opened.
+bool timeTraceProfilerWrite(StringRef Path, std::string &ErrorInfo);
+
+/// The TimeTraceScope records the time span of its lifetime, named \p Name and
+/// described by \p Detail, typically the pass being run and the IR unit it is
+/// run on. Nested scopes show up as nested spans. Nothing is recorded, and the
+/// detail isn't even materialized, when the profiler isn't enabled.
+class TimeTraceScope {
+  bool Active;
+  std::chrono::steady_clock::time_point Start;
+  size_t StartMemory;
+  std::string Name;
+  std::string Detail;
+
+  TimeTraceScope(const TimeTraceScope &) = delete;
+  void operator=(const TimeTraceScope &) = delete;
+
+  void begin(StringRef Name, StringRef Detail);
+
+public:
+  explicit TimeTraceScope(StringRef Name, StringRef Detail = StringRef())
+      : Active(false) {
+    if (timeTraceProfilerEnabled())
+      begin(Name, Detail);
+  }
+
+  /// Variant taking a callback producing the detail, for details that are
+  /// expensive to compute.
+  template <typename DetailFnTy>
+  TimeTraceScope(StringRef Name, DetailFnTy DetailFn,
+                 typename std::enable_if<
+                     !std::is_convertible<DetailFnTy, StringRef>::value>::type
+                     * = nullptr)
+      : Active(false) {
+    if (timeTraceProfilerEnabled())
+      begin(Name, DetailFn());
+  }
+
+  ~TimeTraceScope();
+};
+
+} // end namespace llvm
+
+#endif
@@ -25,6 +25,8 @@
 
 namespace llvm {
 
+class raw_ostream;
+
 struct TargetRecip {
 public:
   TargetRecip();
@@ -49,6 +51,10 @@ public:
 
   bool operator==(const TargetRecip &Other) const;
 
+  /// Print the settings of every operation, including the ones not
+  /// initialized yet. Equal specifications print the same.
+  void print(raw_ostream &OS) const;
+
 private:
   enum {
     Uninitialized = -1
@@ -131,6 +131,9 @@ public:
   bool RerollLoops;
   bool LoadCombine;
   bool DisableGVNLoadPRE;
+  /// Have GVN and DSE find memory dependencies with MemorySSA instead of
+  /// MemoryDependenceAnalysis.
+  bool UseMemorySSA;
   bool VerifyInput;
   bool VerifyOutput;
   bool MergeFunctions;
@@ -69,9 +69,11 @@ FunctionPass *createDeadCodeEliminationPass();
 //===----------------------------------------------------------------------===//
 //
 // DeadStoreElimination - This pass deletes stores that are post-dominated by
-// must-aliased stores and are not loaded used between the stores.
+// must-aliased stores and are not loaded used between the stores. The stores
+// are matched with MemorySSA rather than MemoryDependenceAnalysis when
+// UseMemorySSA is set.
 //
-FunctionPass *createDeadStoreEliminationPass();
+FunctionPass *createDeadStoreEliminationPass(bool UseMemorySSA = false);
 
 //===----------------------------------------------------------------------===//
 //
@@ -27,7 +27,14 @@ namespace llvm {
 /// only the redundant stores that are local to a single Basic Block.
 class DSEPass : public PassInfoMixin<DSEPass> {
 public:
+  /// When \p UseMemorySSA is set, the stores are matched by walking a
+  /// MemorySSA instead of querying MemoryDependenceAnalysis.
+  explicit DSEPass(bool UseMemorySSA = false) : UseMemorySSA(UseMemorySSA) {}
+
   PreservedAnalyses run(Function &F, AnalysisManager<Function> &FAM);
+
+private:
+  bool UseMemorySSA;
 };
 }
 
@@ -26,6 +26,7 @@
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/PassManager.h"
+#include "llvm/Transforms/Utils/MemorySSA.h"
 
 namespace llvm {
 
@@ -43,6 +44,11 @@ class GVNLegacyPass;
 /// this particular pass here.
 class GVN : public PassInfoMixin<GVN> {
 public:
+  /// When \p UseMemorySSA is set, redundant loads are found by walking a
+  /// MemorySSA built for the function instead of by querying
+  /// MemoryDependenceAnalysis. Load PRE and the elimination of redundant
+  /// readonly calls are not performed in that mode.
+  explicit GVN(bool UseMemorySSA = false) : UseMemorySSA(UseMemorySSA) {}
 
   /// \brief Run the pass over the function.
   PreservedAnalyses run(Function &F, AnalysisManager<Function> &AM);
@@ -110,6 +116,16 @@ private:
   AssumptionCache *AC;
   SetVector<BasicBlock *> DeadBlocks;
 
+  bool UseMemorySSA;
+  /// The MemorySSA of the function being processed when UseMemorySSA is set.
+  /// It is built lazily and dropped whenever GVN changes the CFG.
+  std::unique_ptr<MemorySSA> MSSA;
+
+  /// Loads that were kept so far in the MemorySSA mode, keyed by their
+  /// clobbering access and the value number of their pointer operand.
+  DenseMap<std::pair<const MemoryAccess *, uint32_t>,
+           SmallVector<LoadInst *, 2>> AvailableLoads;
+
   ValueTable VN;
 
   /// A mapping from value numbers to lists of Value*'s that
@@ -186,6 +202,9 @@ private:
 
   // Helper functions of redundant load elimination
   bool processLoad(LoadInst *L);
+  bool processLoadWithMemorySSA(LoadInst *L);
+  MemorySSA &getMemorySSA(Function &F);
+  void invalidateMemorySSA();
   bool processNonLocalLoad(LoadInst *L);
   bool processAssumeIntrinsic(IntrinsicInst *II);
   /// Given a local dependency (Def or Clobber) determine if a value is
@@ -225,8 +244,9 @@ private:
 };
 
 /// Create a legacy GVN pass. This also allows parameterizing whether or not
-/// loads are eliminated by the pass.
-FunctionPass *createGVNPass(bool NoLoads = false);
+/// loads are eliminated by the pass, and whether they are found with
+/// MemorySSA rather than MemoryDependenceAnalysis.
+FunctionPass *createGVNPass(bool NoLoads = false, bool UseMemorySSA = false);
 
 /// \brief A simple and fast domtree-based GVN pass to hoist common expressions
 /// from sibling branches.
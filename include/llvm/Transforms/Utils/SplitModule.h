@@ -26,6 +26,8 @@ class StringRef;
 
 /// Splits the module M into N linkable partitions. The function ModuleCallback
 /// is called N times passing each individual partition as the MPart argument.
+/// The first N - 1 partitions are clones of M, the last one is M itself, with
+/// the definitions of the other partitions turned into declarations.
 ///
 /// FIXME: This function does not deal with the somewhat subtle symbol
 /// visibility issues around module splitting, including (but not limited to):
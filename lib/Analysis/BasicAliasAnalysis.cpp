@@ -51,6 +51,16 @@ static cl::opt<bool> EnableRecPhiAnalysis("basicaa-recphi", cl::Hidden,
 STATISTIC(SearchLimitReached, "Number of times the limit to "
                               "decompose GEPs is reached");
 STATISTIC(SearchTimes, "Number of times a GEP is decomposed");
+STATISTIC(NumQueryCacheHits, "Number of alias queries answered by the cache");
+STATISTIC(NumQueryCacheMisses, "Number of alias queries missing the cache");
+STATISTIC(NumGEPCacheHits, "Number of GEP decompositions found in the cache");
+STATISTIC(NumGEPCacheMisses, "Number of GEP decompositions missing the cache");
+STATISTIC(NumCacheFlushes, "Number of times the alias caches were flushed");
+
+/// Bounds the number of entries of the caches kept across queries. Zero
+/// disables them.
+static cl::opt<unsigned> CacheLimit("basicaa-cache-limit", cl::Hidden,
+                                    cl::init(16384));
 
 /// Cutoff after which to stop analysing a set of phi nodes potentially involved
 /// in a cycle. Because we are analysing 'through' phi nodes, we need to be
@@ -685,6 +695,23 @@ AliasResult BasicAAResult::alias(const MemoryLocation &LocA,
   if (CacheIt != AliasCache.end())
     return CacheIt->second;
 
+  // Answers to earlier queries hold, whatever the phis visited by the query
+  // in progress, if any.
+  bool UseCaches = CacheAcrossQueries && CacheLimit;
+  if (UseCaches) {
+    auto QueryIt = QueryCache.find(LocPair(LocA, LocB));
+    if (QueryIt == QueryCache.end())
+      QueryIt = QueryCache.find(LocPair(LocB, LocA));
+    if (QueryIt != QueryCache.end()) {
+      ++NumQueryCacheHits;
+      return QueryIt->second;
+    }
+    ++NumQueryCacheMisses;
+  }
+
+  // Nested queries may rely on the NoAlias assumptions aliasPHI makes for
+  // the query in progress, only the top-level answers are kept.
+  bool IsTopLevel = AliasCache.empty();
   AliasResult Alias = aliasCheck(LocA.Ptr, LocA.Size, LocA.AATags, LocB.Ptr,
                                  LocB.Size, LocB.AATags);
   // AliasCache rarely has more than 1 or 2 elements, always use
@@ -693,9 +720,70 @@ AliasResult BasicAAResult::alias(const MemoryLocation &LocA,
   // FIXME: This should really be shrink_to_inline_capacity_and_clear().
   AliasCache.shrink_and_clear();
   VisitedPhiBBs.clear();
+
+  if (IsTopLevel && UseCaches) {
+    if (QueryCache.size() >= CacheLimit)
+      invalidateCaches();
+    QueryCache[LocPair(LocA, LocB)] = Alias;
+    trackCachedValue(LocA.Ptr);
+    trackCachedValue(LocB.Ptr);
+  }
   return Alias;
 }
 
+bool BasicAAResult::decomposeGEP(const Value *V, DecomposedGEP &Decomposed) {
+  if (!CacheAcrossQueries || !CacheLimit)
+    return DecomposeGEPExpression(V, Decomposed, DL, &AC, DT);
+
+  auto It = DecomposedGEPs.find(V);
+  if (It != DecomposedGEPs.end()) {
+    ++NumGEPCacheHits;
+    Decomposed = It->second.first;
+    return It->second.second;
+  }
+  ++NumGEPCacheMisses;
+
+  bool MaxLookupReached = DecomposeGEPExpression(V, Decomposed, DL, &AC, DT);
+  if (DecomposedGEPs.size() >= CacheLimit)
+    invalidateCaches();
+  DecomposedGEPs[V] = std::make_pair(Decomposed, MaxLookupReached);
+  trackCachedValue(V);
+  trackCachedValue(Decomposed.Base);
+  for (const VariableGEPIndex &Index : Decomposed.VarIndices)
+    trackCachedValue(Index.V);
+  return MaxLookupReached;
+}
+
+void BasicAAResult::trackCachedValue(const Value *V) {
+  if (CachedValues.insert(V).second)
+    CachedValueHandles.emplace_back(V, this);
+}
+
+void BasicAAResult::invalidateCaches() {
+  if (CachedValues.empty())
+    return;
+  ++NumCacheFlushes;
+  QueryCache.clear();
+  DecomposedGEPs.clear();
+  CachedValues.clear();
+  CachedValueHandles.clear();
+}
+
+bool BasicAAResult::invalidate(Function &, const PreservedAnalyses &PA) {
+  // Passes that preserve BasicAA may still have rewritten the operands of the
+  // values the caches refer to.
+  if (!PA.areAllPreserved())
+    invalidateCaches();
+  return false;
+}
+
+// Both callbacks destroy the handle they are called on, as SCEV's do.
+void BasicAAResult::CachedValueHandle::deleted() { AAR->invalidateCaches(); }
+
+void BasicAAResult::CachedValueHandle::allUsesReplacedWith(Value *) {
+  AAR->invalidateCaches();
+}
+
 /// Checks to see if the specified callsite can clobber the specified memory
 /// object.
 ///
@@ -1021,10 +1109,8 @@ AliasResult BasicAAResult::aliasGEP(const GEPOperator *GEP1, uint64_t V1Size,
                                     const Value *UnderlyingV1,
                                     const Value *UnderlyingV2) {
   DecomposedGEP DecompGEP1, DecompGEP2;
-  bool GEP1MaxLookupReached =
-    DecomposeGEPExpression(GEP1, DecompGEP1, DL, &AC, DT);
-  bool GEP2MaxLookupReached =
-    DecomposeGEPExpression(V2, DecompGEP2, DL, &AC, DT);
+  bool GEP1MaxLookupReached = decomposeGEP(GEP1, DecompGEP1);
+  bool GEP2MaxLookupReached = decomposeGEP(V2, DecompGEP2);
 
   int64_t GEP1BaseOffset = DecompGEP1.StructOffset + DecompGEP1.OtherOffset;
   int64_t GEP2BaseOffset = DecompGEP2.StructOffset + DecompGEP2.OtherOffset;
@@ -1674,7 +1760,8 @@ BasicAAResult BasicAA::run(Function &F, AnalysisManager<Function> &AM) {
                        AM.getResult<TargetLibraryAnalysis>(F),
                        AM.getResult<AssumptionAnalysis>(F),
                        &AM.getResult<DominatorTreeAnalysis>(F),
-                       AM.getCachedResult<LoopAnalysis>(F));
+                       AM.getCachedResult<LoopAnalysis>(F),
+                       /*CacheAcrossQueries=*/true);
 }
 
 BasicAAWrapperPass::BasicAAWrapperPass() : FunctionPass(ID) {
@@ -1702,6 +1789,7 @@ bool BasicAAWrapperPass::runOnFunction(Function &F) {
   auto &DTWP = getAnalysis<DominatorTreeWrapperPass>();
   auto *LIWP = getAnalysisIfAvailable<LoopInfoWrapperPass>();
 
+  // No caching across queries, see the class comment.
   Result.reset(new BasicAAResult(F.getParent()->getDataLayout(), TLIWP.getTLI(),
                                  ACT.getAssumptionCache(F), &DTWP.getDomTree(),
                                  LIWP ? &LIWP->getLoopInfo() : nullptr));
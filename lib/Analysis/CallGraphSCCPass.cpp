@@ -26,6 +26,7 @@
 #include "llvm/IR/OptBisect.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 using namespace llvm;
@@ -124,6 +125,16 @@ bool CGPassManager::RunPassOnSCC(Pass *P, CallGraphSCC &CurSCC,
 
     {
       TimeRegion PassTimer(getPassTimer(CGSP));
+      TimeTraceScope TraceScope(CGSP->getPassName(), [&] {
+        std::string Detail;
+        for (CallGraphNode *CGN : CurSCC) {
+          if (!Detail.empty())
+            Detail += ", ";
+          Function *F = CGN->getFunction();
+          Detail += F ? F->getName() : "<external node>";
+        }
+        return Detail;
+      });
       Changed = CGSP->runOnSCC(CurSCC);
     }
     
@@ -15,6 +15,7 @@
 #include "llvm/Analysis/LazyValueInfo.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AssumptionCache.h"
 #include "llvm/Analysis/ConstantFolding.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
@@ -29,6 +30,7 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/PatternMatch.h"
 #include "llvm/IR/ValueHandle.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 #include <map>
@@ -38,6 +40,30 @@ using namespace PatternMatch;
 
 #define DEBUG_TYPE "lazy-value-info"
 
+STATISTIC(NumCacheEvictions, "Number of values evicted from the cache");
+STATISTIC(PeakCacheSize, "Peak number of lattice values in the cache");
+STATISTIC(NumQueryBudgetExhausted,
+          "Number of queries that ran out of budget");
+STATISTIC(NumDominatorFastPath,
+          "Number of queries answered from dominating conditions");
+
+static cl::opt<unsigned> CacheLimit(
+    "lvi-cache-limit", cl::Hidden, cl::init(1000000),
+    cl::desc("Maximum number of lattice values kept in the cache, the least "
+             "recently used values are evicted beyond that (0 = no limit)"));
+
+static cl::opt<unsigned> QueryBudget(
+    "lvi-query-budget", cl::Hidden, cl::init(0),
+    cl::desc("Maximum number of block values computed for a single query "
+             "before giving up on it, its degraded answer is cached for the "
+             "rest of the pass (0 = no limit)"));
+
+static cl::opt<bool> EnableDominatorFastPath(
+    "lvi-dominator-fast-path", cl::Hidden, cl::init(false),
+    cl::desc("Answer block value queries from the conditions of the "
+             "dominating edges when they constrain the value, instead of "
+             "propagating through the CFG"));
+
 char LazyValueInfoWrapperPass::ID = 0;
 INITIALIZE_PASS_BEGIN(LazyValueInfoWrapperPass, "lazy-value-info",
                 "Lazy Value Information Analysis", false, true)
@@ -382,13 +408,14 @@ namespace {
   /// This is the cache kept by LazyValueInfo which
   /// maintains information about queries across the clients' queries.
   class LazyValueInfoCache {
-    /// This is all of the cached block information for exactly one Value*.
-    /// The entries are sorted by the BasicBlock* of the
-    /// entries, allowing us to do a lookup with a binary search.
+    /// This is all of the cached block information for exactly one Value*,
+    /// along with the last query that used it.
     /// Over-defined lattice values are recorded in OverDefinedCache to reduce
     /// memory overhead.
-    typedef SmallDenseMap<AssertingVH<BasicBlock>, LVILatticeVal, 4>
-        ValueCacheEntryTy;
+    struct ValueCacheEntryTy {
+      SmallDenseMap<AssertingVH<BasicBlock>, LVILatticeVal, 4> BlockVals;
+      unsigned LastUse = 0;
+    };
 
     /// This is all of the cached information for all values,
     /// mapped from Value* to key information.
@@ -404,6 +431,12 @@ namespace {
     /// don't spend time removing unused blocks from our caches.
     DenseSet<AssertingVH<BasicBlock> > SeenBlocks;
 
+    /// The number of lattice values in ValueCache and OverDefinedCache.
+    unsigned NumCachedVals = 0;
+
+    /// Numbers the top-level queries, to find the least recently used values.
+    unsigned CurrentQuery = 0;
+
     /// This stack holds the state of the value solver during a query.
     /// It basically emulates the callstack of the naive
     /// recursive value lookup process.
@@ -435,12 +468,21 @@ namespace {
 
       // Insert over-defined values into their own cache to reduce memory
       // overhead.
-      if (Result.isOverdefined())
-        OverDefinedCache[BB].insert(Val);
-      else
-        lookup(Val)[BB] = Result;
+      bool Inserted;
+      if (Result.isOverdefined()) {
+        Inserted = OverDefinedCache[BB].insert(Val).second;
+      } else {
+        auto I = lookup(Val).BlockVals.insert({BB, Result});
+        Inserted = I.second;
+        if (!Inserted)
+          I.first->second = Result;
+      }
+      if (Inserted && ++NumCachedVals > PeakCacheSize)
+        PeakCacheSize = NumCachedVals;
     }
 
+    void evictLeastRecentlyUsed();
+
   LVILatticeVal getBlockValue(Value *Val, BasicBlock *BB);
   bool getEdgeValue(Value *V, BasicBlock *F, BasicBlock *T,
                     LVILatticeVal &Result, Instruction *CxtI = nullptr);
@@ -460,11 +502,14 @@ namespace {
                            BasicBlock *BB);
   void intersectAssumeBlockValueConstantRange(Value *Val, LVILatticeVal &BBLV,
                                               Instruction *BBI);
+  LVILatticeVal getValueFromDominatingConditions(Value *Val, BasicBlock *BB);
 
   void solve();
 
   ValueCacheEntryTy &lookup(Value *V) {
-    return ValueCache[LVIValueHandle(V, this)];
+    ValueCacheEntryTy &Entry = ValueCache[LVIValueHandle(V, this)];
+    Entry.LastUse = CurrentQuery;
+    return Entry;
   }
 
     bool isOverdefined(Value *V, BasicBlock *BB) const {
@@ -485,14 +530,15 @@ namespace {
       if (I == ValueCache.end())
         return false;
 
-      return I->second.count(BB);
+      I->second.LastUse = CurrentQuery;
+      return I->second.BlockVals.count(BB);
     }
 
     LVILatticeVal getCachedValueInfo(Value *V, BasicBlock *BB) {
       if (isOverdefined(V, BB))
         return LVILatticeVal::getOverdefined();
 
-      return lookup(V)[BB];
+      return lookup(V).BlockVals.lookup(BB);
     }
 
   public:
@@ -524,6 +570,7 @@ namespace {
       SeenBlocks.clear();
       ValueCache.clear();
       OverDefinedCache.clear();
+      NumCachedVals = 0;
     }
 
     LazyValueInfoCache(AssumptionCache *AC, const DataLayout &DL,
@@ -536,14 +583,18 @@ void LVIValueHandle::deleted() {
   SmallVector<AssertingVH<BasicBlock>, 4> ToErase;
   for (auto &I : Parent->OverDefinedCache) {
     SmallPtrSetImpl<Value *> &ValueSet = I.second;
-    if (ValueSet.count(getValPtr()))
-      ValueSet.erase(getValPtr());
+    if (ValueSet.erase(getValPtr()))
+      --Parent->NumCachedVals;
     if (ValueSet.empty())
       ToErase.push_back(I.first);
   }
   for (auto &BB : ToErase)
     Parent->OverDefinedCache.erase(BB);
 
+  auto I = Parent->ValueCache.find(*this);
+  if (I != Parent->ValueCache.end())
+    Parent->NumCachedVals -= I->second.BlockVals.size();
+
   // This erasure deallocates *this, so it MUST happen after we're done
   // using any and all members of *this.
   Parent->ValueCache.erase(*this);
@@ -557,15 +608,81 @@ void LazyValueInfoCache::eraseBlock(BasicBlock *BB) {
   SeenBlocks.erase(I);
 
   auto ODI = OverDefinedCache.find(BB);
-  if (ODI != OverDefinedCache.end())
+  if (ODI != OverDefinedCache.end()) {
+    NumCachedVals -= ODI->second.size();
     OverDefinedCache.erase(ODI);
+  }
 
   for (auto &I : ValueCache)
-    I.second.erase(BB);
+    NumCachedVals -= I.second.BlockVals.erase(BB);
+}
+
+/// Bring the cache back under its limit by evicting the values used the least
+/// recently, down to three quarters of the limit so that the next queries
+/// don't evict again right away. Values only known to be overdefined have no
+/// ValueCache entry to timestamp them and go first.
+void LazyValueInfoCache::evictLeastRecentlyUsed() {
+  if (!CacheLimit || NumCachedVals <= CacheLimit)
+    return;
+
+  DenseMap<Value *, unsigned> NumVals;
+  for (auto &I : OverDefinedCache)
+    for (Value *V : I.second)
+      ++NumVals[V];
+  std::vector<std::pair<unsigned, Value *>> ByLastUse;
+  for (auto &I : ValueCache) {
+    NumVals[I.first] += I.second.BlockVals.size();
+    ByLastUse.push_back(std::make_pair(I.second.LastUse, (Value *)I.first));
+  }
+  for (auto &I : NumVals)
+    if (!ValueCache.count(LVIValueHandle(I.first, this)))
+      ByLastUse.push_back(std::make_pair(0U, I.first));
+  std::sort(ByLastUse.begin(), ByLastUse.end());
+
+  SmallPtrSet<Value *, 32> Evicted;
+  unsigned Target = CacheLimit - CacheLimit / 4;
+  for (auto &I : ByLastUse) {
+    if (NumCachedVals <= Target)
+      break;
+    Evicted.insert(I.second);
+    NumCachedVals -= NumVals[I.second];
+  }
+  NumCacheEvictions += Evicted.size();
+
+  SmallVector<AssertingVH<BasicBlock>, 4> ToErase;
+  for (auto &I : OverDefinedCache) {
+    for (Value *V : Evicted)
+      I.second.erase(V);
+    if (I.second.empty())
+      ToErase.push_back(I.first);
+  }
+  for (auto &BB : ToErase)
+    OverDefinedCache.erase(BB);
+  for (Value *V : Evicted)
+    ValueCache.erase(LVIValueHandle(V, this));
 }
 
 void LazyValueInfoCache::solve() {
+  // Every query starts from a single block value.
+  assert(BlockValueStack.size() == 1 && "Query with several starting points?");
+  std::pair<BasicBlock *, Value *> Start = BlockValueStack.top();
+
+  unsigned NumSolved = 0;
   while (!BlockValueStack.empty()) {
+    if (QueryBudget && ++NumSolved > QueryBudget) {
+      // Give up on the query, answering it with what the dominating
+      // conditions say. The other values on the stack aren't needed by
+      // anything and are left out of the cache.
+      DEBUG(dbgs() << "Giving up on " << *Start.second << " in "
+                   << Start.first->getName() << ", the query is too deep\n");
+      ++NumQueryBudgetExhausted;
+      insertResult(Start.second, Start.first,
+                   getValueFromDominatingConditions(Start.second, Start.first));
+      BlockValueStack = std::stack<std::pair<BasicBlock *, Value *>>();
+      BlockValueSet.clear();
+      return;
+    }
+
     std::pair<BasicBlock*, Value*> &e = BlockValueStack.top();
     assert(BlockValueSet.count(e) && "Stack value should be in BlockValueSet!");
 
@@ -1313,18 +1430,59 @@ bool LazyValueInfoCache::getEdgeValue(Value *Val, BasicBlock *BBFrom,
   return true;
 }
 
+/// \brief Compute what the branch conditions on the way to BB say about Val,
+/// without looking at any other block value.
+///
+/// This follows the chain of unique predecessors up from BB: each of them
+/// dominates BB and the edges between them are taken by every path reaching
+/// BB, so the conditions of all these edges hold in BB. The dominator tree
+/// isn't used for this as passes like jump threading don't keep it up to date
+/// while they query LVI.
+LVILatticeVal
+LazyValueInfoCache::getValueFromDominatingConditions(Value *Val,
+                                                     BasicBlock *BB) {
+  BasicBlock *DefBB = nullptr;
+  if (auto *I = dyn_cast<Instruction>(Val))
+    DefBB = I->getParent();
+
+  LVILatticeVal Result = LVILatticeVal::getOverdefined();
+  SmallPtrSet<BasicBlock *, 8> Visited;
+  for (BasicBlock *Succ = BB; Succ != DefBB && Visited.insert(Succ).second;) {
+    BasicBlock *Pred = Succ->getUniquePredecessor();
+    if (!Pred)
+      break;
+    LVILatticeVal EdgeResult;
+    if (getEdgeValueLocal(Val, Pred, Succ, EdgeResult))
+      Result = intersect(Result, EdgeResult);
+    Succ = Pred;
+  }
+  return Result;
+}
+
 LVILatticeVal LazyValueInfoCache::getValueInBlock(Value *V, BasicBlock *BB,
                                                   Instruction *CxtI) {
   DEBUG(dbgs() << "LVI Getting block end value " << *V << " at '"
         << BB->getName() << "'\n");
 
   assert(BlockValueStack.empty() && BlockValueSet.empty());
+  ++CurrentQuery;
+  if (EnableDominatorFastPath && !hasBlockValue(V, BB)) {
+    LVILatticeVal Result = getValueFromDominatingConditions(V, BB);
+    if (!Result.isOverdefined()) {
+      ++NumDominatorFastPath;
+      intersectAssumeBlockValueConstantRange(V, Result, CxtI);
+      DEBUG(dbgs() << "  Result = " << Result << " (dominating conditions)\n");
+      return Result;
+    }
+  }
+
   if (!hasBlockValue(V, BB)) {
     pushBlockValue(std::make_pair(BB, V)); 
     solve();
   }
   LVILatticeVal Result = getBlockValue(V, BB);
   intersectAssumeBlockValueConstantRange(V, Result, CxtI);
+  evictLeastRecentlyUsed();
 
   DEBUG(dbgs() << "  Result = " << Result << "\n");
   return Result;
@@ -1352,13 +1510,29 @@ getValueOnEdge(Value *V, BasicBlock *FromBB, BasicBlock *ToBB,
   DEBUG(dbgs() << "LVI Getting edge value " << *V << " from '"
         << FromBB->getName() << "' to '" << ToBB->getName() << "'\n");
 
+  ++CurrentQuery;
   LVILatticeVal Result;
+  if (EnableDominatorFastPath && !isa<Constant>(V) &&
+      !hasBlockValue(V, FromBB)) {
+    Result = getValueFromDominatingConditions(V, FromBB);
+    LVILatticeVal EdgeResult;
+    if (getEdgeValueLocal(V, FromBB, ToBB, EdgeResult))
+      Result = intersect(Result, EdgeResult);
+    if (!Result.isOverdefined()) {
+      ++NumDominatorFastPath;
+      intersectAssumeBlockValueConstantRange(V, Result, CxtI);
+      DEBUG(dbgs() << "  Result = " << Result << " (dominating conditions)\n");
+      return Result;
+    }
+  }
+
   if (!getEdgeValue(V, FromBB, ToBB, Result, CxtI)) {
     solve();
     bool WasFastQuery = getEdgeValue(V, FromBB, ToBB, Result, CxtI);
     (void)WasFastQuery;
     assert(WasFastQuery && "More work to do after problem solved?");
   }
+  evictLeastRecentlyUsed();
 
   DEBUG(dbgs() << "  Result = " << Result << "\n");
   return Result;
@@ -1406,6 +1580,7 @@ void LazyValueInfoCache::threadEdge(BasicBlock *PredBB, BasicBlock *OldSucc,
         continue;
 
       ValueSet.erase(V);
+      --NumCachedVals;
       if (ValueSet.empty())
         OverDefinedCache.erase(OI);
 
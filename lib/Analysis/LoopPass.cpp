@@ -20,6 +20,7 @@
 #include "llvm/IR/OptBisect.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 using namespace llvm;
@@ -194,6 +195,11 @@ bool LPPassManager::runOnFunction(Function &F) {
       {
         PassManagerPrettyStackEntry X(P, *CurrentLoop->getHeader());
         TimeRegion PassTimer(getPassTimer(P));
+        TimeTraceScope TraceScope(P->getPassName(), [&] {
+          BasicBlock *Header = CurrentLoop->getHeader();
+          return (Header->getParent()->getName() + ":" + Header->getName())
+              .str();
+        });
 
         Changed |= P->runOnLoop(CurrentLoop, *this);
       }
@@ -59,6 +59,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/ADT/EquivalenceClasses.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallPtrSet.h"
@@ -103,6 +104,8 @@ STATISTIC(NumTripCountsNotComputed,
           "Number of loops without predictable loop counts");
 STATISTIC(NumBruteForceTripCountsComputed,
           "Number of loops with trip counts computed by force");
+STATISTIC(NumFoldingBudgetsExhausted,
+          "Number of functions that ran out of folding budget");
 
 static cl::opt<unsigned>
 MaxBruteForceIterations("scalar-evolution-max-iterations", cl::ReallyHidden,
@@ -111,6 +114,12 @@ MaxBruteForceIterations("scalar-evolution-max-iterations", cl::ReallyHidden,
                                  "derived loop"),
                         cl::init(100));
 
+static cl::opt<unsigned>
+MaxFoldingWork("scalar-evolution-max-folding-work", cl::Hidden,
+               cl::desc("Maximum number of values SCEV analyzes and of sums "
+                        "and products it tries to fold in a function"),
+               cl::init(1000000));
+
 // FIXME: Enable this with EXPENSIVE_CHECKS when the test suite is clean.
 static cl::opt<bool>
 VerifySCEV("verify-scev",
@@ -451,10 +460,18 @@ namespace {
 /// SCEVComplexityCompare - Return true if the complexity of the LHS is less
 /// than the complexity of the RHS.  This comparator is used to canonicalize
 /// expressions.
+///
+/// Distinct expressions can compare equal, and proving that takes a walk over
+/// both of them.  The pairs found equal are remembered in EqCache, so that the
+/// walk is not repeated for the subexpressions they share; without it,
+/// comparing two expression DAGs takes time exponential in their depth.
 class SCEVComplexityCompare {
   const LoopInfo *const LI;
+  EquivalenceClasses<const SCEV *> &EqCache;
 public:
-  explicit SCEVComplexityCompare(const LoopInfo *li) : LI(li) {}
+  SCEVComplexityCompare(const LoopInfo *li,
+                        EquivalenceClasses<const SCEV *> &EqCache)
+      : LI(li), EqCache(EqCache) {}
 
   // Return true or false if LHS is less than, or at least RHS, respectively.
   bool operator()(const SCEV *LHS, const SCEV *RHS) const {
@@ -474,6 +491,20 @@ public:
     if (LType != RType)
       return (int)LType - (int)RType;
 
+    auto Leader = EqCache.findLeader(LHS);
+    if (Leader != EqCache.member_end() && Leader == EqCache.findLeader(RHS))
+      return 0;
+
+    int Result = compareSameType(LHS, RHS);
+    if (Result == 0)
+      EqCache.unionSets(LHS, RHS);
+    return Result;
+  }
+
+private:
+  int compareSameType(const SCEV *LHS, const SCEV *RHS) const {
+    unsigned LType = LHS->getSCEVType();
+
     // Aside from the getSCEVType() ordering, the particular ordering
     // isn't very important except that it's beneficial to be consistent,
     // so that (a + b) and (b + a) don't end up as different expressions.
@@ -635,17 +666,20 @@ public:
 static void GroupByComplexity(SmallVectorImpl<const SCEV *> &Ops,
                               LoopInfo *LI) {
   if (Ops.size() < 2) return;  // Noop
+
+  EquivalenceClasses<const SCEV *> EqCache;
   if (Ops.size() == 2) {
     // This is the common case, which also happens to be trivially simple.
     // Special case it.
     const SCEV *&LHS = Ops[0], *&RHS = Ops[1];
-    if (SCEVComplexityCompare(LI)(RHS, LHS))
+    if (SCEVComplexityCompare(LI, EqCache)(RHS, LHS))
       std::swap(LHS, RHS);
     return;
   }
 
   // Do the rough sort by complexity.
-  std::stable_sort(Ops.begin(), Ops.end(), SCEVComplexityCompare(LI));
+  std::stable_sort(Ops.begin(), Ops.end(),
+                   SCEVComplexityCompare(LI, EqCache));
 
   // Now that we are sorted by complexity, group elements of the same
   // complexity.  Note that this is, at worst, N^2, but the vector is likely to
@@ -2018,6 +2052,13 @@ StrengthenNoWrapFlags(ScalarEvolution *SE, SCEVTypes Type,
   return Flags;
 }
 
+/// Returns true if one of \p Ops is a constant or an add recurrence.
+static bool hasConstantOrAddRec(ArrayRef<const SCEV *> Ops) {
+  return any_of(Ops, [](const SCEV *Op) {
+    return isa<SCEVConstant>(Op) || isa<SCEVAddRecExpr>(Op);
+  });
+}
+
 /// Get a canonical add expression, or something simpler if possible.
 const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
                                         SCEV::NoWrapFlags Flags) {
@@ -2059,6 +2100,13 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
     if (Ops.size() == 1) return Ops[0];
   }
 
+  // Past the budget, keep the operands as they are. Sums involving constants
+  // or add recurrences are still folded: users rely on e.g. evaluating an add
+  // recurrence at a constant iteration giving a constant, or on the sum of an
+  // add recurrence and a loop invariant being an add recurrence.
+  if (CreatingSCEV && !hasConstantOrAddRec(Ops) && !consumeFoldingBudget())
+    return getOrCreateAddExpr(Ops, Flags);
+
   // Okay, check to see if the same value occurs in the operand list more than
   // once.  If so, merge them together into an multiply expression.  Since we
   // sorted the list, these values are required to be adjacent.
@@ -2361,6 +2409,12 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
 
   // Okay, it looks like we really DO need an add expr.  Check to see if we
   // already have one, otherwise create a new one.
+  return getOrCreateAddExpr(Ops, Flags);
+}
+
+const SCEV *
+ScalarEvolution::getOrCreateAddExpr(SmallVectorImpl<const SCEV *> &Ops,
+                                    SCEV::NoWrapFlags Flags) {
   FoldingSetNodeID ID;
   ID.AddInteger(scAddExpr);
   for (unsigned i = 0, e = Ops.size(); i != e; ++i)
@@ -2448,6 +2502,11 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
 
   Flags = StrengthenNoWrapFlags(this, scMulExpr, Ops, Flags);
 
+  // As for sums, products involving constants or add recurrences are always
+  // folded.
+  if (CreatingSCEV && !hasConstantOrAddRec(Ops) && !consumeFoldingBudget())
+    return getOrCreateMulExpr(Ops, Flags);
+
   // If there are any constants, fold them together.
   unsigned Idx = 0;
   if (const SCEVConstant *LHSC = dyn_cast<SCEVConstant>(Ops[0])) {
@@ -2651,6 +2710,12 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
 
   // Okay, it looks like we really DO need an mul expr.  Check to see if we
   // already have one, otherwise create a new one.
+  return getOrCreateMulExpr(Ops, Flags);
+}
+
+const SCEV *
+ScalarEvolution::getOrCreateMulExpr(SmallVectorImpl<const SCEV *> &Ops,
+                                    SCEV::NoWrapFlags Flags) {
   FoldingSetNodeID ID;
   ID.AddInteger(scMulExpr);
   for (unsigned i = 0, e = Ops.size(); i != e; ++i)
@@ -4985,6 +5050,12 @@ const SCEV *ScalarEvolution::createSCEV(Value *V) {
   else if (!isa<ConstantExpr>(V))
     return getUnknown(V);
 
+  // Past the budget, treat every new value as opaque. The SCEVUnknown is
+  // cached like any other result, so later queries get the same answer.
+  if (!consumeFoldingBudget())
+    return getUnknown(V);
+  SaveAndRestore<bool> Creating(CreatingSCEV, true);
+
   Operator *U = cast<Operator>(V);
   if (auto BO = MatchBinaryOp(U, DT)) {
     switch (BO->Opcode) {
@@ -5847,17 +5918,46 @@ ScalarEvolution::computeExitLimitFromCond(const Loop *L,
                                           BasicBlock *FBB,
                                           bool ControlsExit,
                                           bool AllowPredicates) {
+  ExitLimitCacheTy Cache;
+  return computeExitLimitFromCondCached(Cache, L, ExitCond, TBB, FBB,
+                                        ControlsExit, AllowPredicates);
+}
+
+ScalarEvolution::ExitLimit
+ScalarEvolution::computeExitLimitFromCondCached(ExitLimitCacheTy &Cache,
+                                                const Loop *L, Value *ExitCond,
+                                                BasicBlock *TBB,
+                                                BasicBlock *FBB,
+                                                bool ControlsExit,
+                                                bool AllowPredicates) {
+  PointerIntPair<Value *, 1, bool> Key(ExitCond, ControlsExit);
+  auto I = Cache.find(Key);
+  if (I != Cache.end())
+    return I->second;
+
+  ExitLimit EL = computeExitLimitFromCondImpl(Cache, L, ExitCond, TBB, FBB,
+                                              ControlsExit, AllowPredicates);
+  Cache.insert(std::make_pair(Key, EL));
+  return EL;
+}
+
+ScalarEvolution::ExitLimit
+ScalarEvolution::computeExitLimitFromCondImpl(ExitLimitCacheTy &Cache,
+                                              const Loop *L, Value *ExitCond,
+                                              BasicBlock *TBB, BasicBlock *FBB,
+                                              bool ControlsExit,
+                                              bool AllowPredicates) {
   // Check if the controlling expression for this loop is an And or Or.
   if (BinaryOperator *BO = dyn_cast<BinaryOperator>(ExitCond)) {
     if (BO->getOpcode() == Instruction::And) {
       // Recurse on the operands of the and.
       bool EitherMayExit = L->contains(TBB);
-      ExitLimit EL0 = computeExitLimitFromCond(L, BO->getOperand(0), TBB, FBB,
-                                               ControlsExit && !EitherMayExit,
-                                               AllowPredicates);
-      ExitLimit EL1 = computeExitLimitFromCond(L, BO->getOperand(1), TBB, FBB,
-                                               ControlsExit && !EitherMayExit,
-                                               AllowPredicates);
+      ExitLimit EL0 = computeExitLimitFromCondCached(
+          Cache, L, BO->getOperand(0), TBB, FBB, ControlsExit && !EitherMayExit,
+          AllowPredicates);
+      ExitLimit EL1 = computeExitLimitFromCondCached(
+          Cache, L, BO->getOperand(1), TBB, FBB, ControlsExit && !EitherMayExit,
+          AllowPredicates);
       const SCEV *BECount = getCouldNotCompute();
       const SCEV *MaxBECount = getCouldNotCompute();
       if (EitherMayExit) {
@@ -5900,12 +6000,12 @@ ScalarEvolution::computeExitLimitFromCond(const Loop *L,
     if (BO->getOpcode() == Instruction::Or) {
       // Recurse on the operands of the or.
       bool EitherMayExit = L->contains(FBB);
-      ExitLimit EL0 = computeExitLimitFromCond(L, BO->getOperand(0), TBB, FBB,
-                                               ControlsExit && !EitherMayExit,
-                                               AllowPredicates);
-      ExitLimit EL1 = computeExitLimitFromCond(L, BO->getOperand(1), TBB, FBB,
-                                               ControlsExit && !EitherMayExit,
-                                               AllowPredicates);
+      ExitLimit EL0 = computeExitLimitFromCondCached(
+          Cache, L, BO->getOperand(0), TBB, FBB, ControlsExit && !EitherMayExit,
+          AllowPredicates);
+      ExitLimit EL1 = computeExitLimitFromCondCached(
+          Cache, L, BO->getOperand(1), TBB, FBB, ControlsExit && !EitherMayExit,
+          AllowPredicates);
       const SCEV *BECount = getCouldNotCompute();
       const SCEV *MaxBECount = getCouldNotCompute();
       if (EitherMayExit) {
@@ -8087,6 +8187,20 @@ bool ScalarEvolution::isImpliedCond(ICmpInst::Predicate Pred,
                                     const SCEV *LHS, const SCEV *RHS,
                                     Value *FoundCondValue,
                                     bool Inverse) {
+  SmallPtrSet<Value *, 8> Visited;
+  return isImpliedCond(Pred, LHS, RHS, FoundCondValue, Inverse, Visited);
+}
+
+bool ScalarEvolution::isImpliedCond(ICmpInst::Predicate Pred,
+                                    const SCEV *LHS, const SCEV *RHS,
+                                    Value *FoundCondValue,
+                                    bool Inverse,
+                                    SmallPtrSetImpl<Value *> &Visited) {
+  // Any condition tried before didn't imply the predicate, or the search would
+  // have stopped there.
+  if (!Visited.insert(FoundCondValue).second)
+    return false;
+
   MarkPendingLoopPredicate Mark(FoundCondValue, PendingLoopPredicates);
   if (Mark.Pending)
     return false;
@@ -8095,12 +8209,16 @@ bool ScalarEvolution::isImpliedCond(ICmpInst::Predicate Pred,
   if (BinaryOperator *BO = dyn_cast<BinaryOperator>(FoundCondValue)) {
     if (BO->getOpcode() == Instruction::And) {
       if (!Inverse)
-        return isImpliedCond(Pred, LHS, RHS, BO->getOperand(0), Inverse) ||
-               isImpliedCond(Pred, LHS, RHS, BO->getOperand(1), Inverse);
+        return isImpliedCond(Pred, LHS, RHS, BO->getOperand(0), Inverse,
+                             Visited) ||
+               isImpliedCond(Pred, LHS, RHS, BO->getOperand(1), Inverse,
+                             Visited);
     } else if (BO->getOpcode() == Instruction::Or) {
       if (Inverse)
-        return isImpliedCond(Pred, LHS, RHS, BO->getOperand(0), Inverse) ||
-               isImpliedCond(Pred, LHS, RHS, BO->getOperand(1), Inverse);
+        return isImpliedCond(Pred, LHS, RHS, BO->getOperand(0), Inverse,
+                             Visited) ||
+               isImpliedCond(Pred, LHS, RHS, BO->getOperand(1), Inverse,
+                             Visited);
     }
   }
 
@@ -9493,13 +9611,26 @@ ScalarEvolution::SCEVCallbackVH::SCEVCallbackVH(Value *V, ScalarEvolution *se)
 //                   ScalarEvolution Class Implementation
 //===----------------------------------------------------------------------===//
 
+bool ScalarEvolution::consumeFoldingBudget() {
+  if (!FoldingBudget)
+    return false;
+  if (--FoldingBudget == 0) {
+    ++NumFoldingBudgetsExhausted;
+    DEBUG(dbgs() << "SCEV: folding budget exhausted in " << F.getName()
+                 << "\n");
+  }
+  return true;
+}
+
 ScalarEvolution::ScalarEvolution(Function &F, TargetLibraryInfo &TLI,
                                  AssumptionCache &AC, DominatorTree &DT,
                                  LoopInfo &LI)
     : F(F), TLI(TLI), AC(AC), DT(DT), LI(LI),
       CouldNotCompute(new SCEVCouldNotCompute()),
       WalkingBEDominatingConds(false), ProvingSplitPredicate(false),
-      ValuesAtScopes(64), LoopDispositions(64), BlockDispositions(64),
+      FoldingBudget(MaxFoldingWork), CreatingSCEV(false), ValuesAtScopes(64),
+      LoopDispositions(64),
+      BlockDispositions(64),
       FirstUnknown(nullptr) {
 
   // To use guards for proving predicates, we need to scan every instruction in
@@ -9522,6 +9653,7 @@ ScalarEvolution::ScalarEvolution(ScalarEvolution &&Arg)
       LI(Arg.LI), CouldNotCompute(std::move(Arg.CouldNotCompute)),
       ValueExprMap(std::move(Arg.ValueExprMap)),
       WalkingBEDominatingConds(false), ProvingSplitPredicate(false),
+      FoldingBudget(Arg.FoldingBudget), CreatingSCEV(false),
       BackedgeTakenCounts(std::move(Arg.BackedgeTakenCounts)),
       PredicatedBackedgeTakenCounts(
           std::move(Arg.PredicatedBackedgeTakenCounts)),
@@ -28,15 +28,27 @@
 #include "llvm/IR/Operator.h"
 #include "llvm/IR/UseListOrder.h"
 #include "llvm/IR/ValueSymbolTable.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/SHA1.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cctype>
 #include <map>
 using namespace llvm;
 
+static cl::opt<unsigned>
+    IndexThreshold("bitcode-mdindex-threshold", cl::Hidden, cl::init(25),
+                   cl::desc("Number of metadatas above which we emit an index "
+                            "to enable lazy-loading"));
+
+static cl::opt<unsigned>
+    WriterThreads("bitcode-writer-threads", cl::Hidden, cl::init(1),
+                  cl::desc("Number of threads encoding the function blocks"));
+
 namespace {
 /// These are manifest constants used by the bitcode writer. They do not need to
 /// be kept in sync with the reader, but need to be consistent within this file.
@@ -163,6 +175,13 @@ public:
   }
 
 private:
+  /// Constructs a ModuleBitcodeWriter encoding function blocks of the module
+  /// of \p Parent into \p Buffer, with a copy of its value enumeration.
+  ModuleBitcodeWriter(const ModuleBitcodeWriter &Parent,
+                      SmallVectorImpl<char> &Buffer)
+      : BitcodeWriter(Buffer), M(Parent.M), VE(Parent.VE), Index(nullptr),
+        GenerateHash(false), GlobalValueId(0) {}
+
   /// Main entry point for writing a module to bitcode, invoked by
   /// BitcodeWriter::write() after it writes the header.
   void writeBlocks() override;
@@ -248,7 +267,9 @@ private:
   void writeMetadataStrings(ArrayRef<const Metadata *> Strings,
                             SmallVectorImpl<uint64_t> &Record);
   void writeMetadataRecords(ArrayRef<const Metadata *> MDs,
-                            SmallVectorImpl<uint64_t> &Record);
+                            SmallVectorImpl<uint64_t> &Record,
+                            std::vector<unsigned> *MDAbbrevs = nullptr,
+                            std::vector<uint64_t> *IndexPos = nullptr);
   void writeModuleMetadata();
   void writeFunctionMetadata(const Function &F);
   void writeFunctionMetadataAttachment(const Function &F);
@@ -276,6 +297,10 @@ private:
   void
   writeFunction(const Function &F,
                 DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex);
+  void
+  writeFunctions(DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex);
+  void writeDetachedFunctions(ArrayRef<const Function *> Functions,
+                              std::vector<StringRef> &Blocks);
   void writeBlockInfo();
   void writePerModuleFunctionSummaryRecord(SmallVector<uint64_t, 64> &NameVals,
                                            GlobalValueSummary *Summary,
@@ -1846,8 +1871,22 @@ void ModuleBitcodeWriter::writeMetadataStrings(
   Record.clear();
 }
 
+namespace {
+/// The MDNode abbreviations that can be created up front, indexing the vector
+/// of abbreviations given to writeMetadataRecords().
+enum MetadataAbbrev : unsigned {
+#define HANDLE_MDNODE_LEAF(CLASS) CLASS##AbbrevID,
+#include "llvm/IR/Metadata.def"
+  LastPlusOne
+};
+} // end anonymous namespace
+
+/// Write the records of \p MDs. The MDNode abbreviations are created on first
+/// use unless \p MDAbbrevs is given. The bit position of each record is added
+/// to \p IndexPos if given.
 void ModuleBitcodeWriter::writeMetadataRecords(
-    ArrayRef<const Metadata *> MDs, SmallVectorImpl<uint64_t> &Record) {
+    ArrayRef<const Metadata *> MDs, SmallVectorImpl<uint64_t> &Record,
+    std::vector<unsigned> *MDAbbrevs, std::vector<uint64_t> *IndexPos) {
   if (MDs.empty())
     return;
 
@@ -1856,6 +1895,8 @@ void ModuleBitcodeWriter::writeMetadataRecords(
 #include "llvm/IR/Metadata.def"
 
   for (const Metadata *MD : MDs) {
+    if (IndexPos)
+      IndexPos->push_back(Stream.GetCurrentBitNo());
     if (const MDNode *N = dyn_cast<MDNode>(MD)) {
       assert(N->isResolved() && "Expected forward references to be resolved");
 
@@ -1864,7 +1905,11 @@ void ModuleBitcodeWriter::writeMetadataRecords(
         llvm_unreachable("Invalid MDNode subclass");
 #define HANDLE_MDNODE_LEAF(CLASS)                                              \
   case Metadata::CLASS##Kind:                                                  \
-    write##CLASS(cast<CLASS>(N), Record, CLASS##Abbrev);                       \
+    if (MDAbbrevs)                                                             \
+      write##CLASS(cast<CLASS>(N), Record,                                     \
+                   (*MDAbbrevs)[MetadataAbbrev::CLASS##AbbrevID]);             \
+    else                                                                       \
+      write##CLASS(cast<CLASS>(N), Record, CLASS##Abbrev);                     \
     continue;
 #include "llvm/IR/Metadata.def"
       }
@@ -1877,10 +1922,59 @@ void ModuleBitcodeWriter::writeModuleMetadata() {
   if (!VE.hasMDs() && M.named_metadata_empty())
     return;
 
-  Stream.EnterSubblock(bitc::METADATA_BLOCK_ID, 3);
+  // Large blocks get an index of the bit position of each node record, so
+  // that the reader can load the nodes on demand. The reader jumps in the
+  // middle of the block to do so, so the abbreviations are all emitted before
+  // the records, which takes more than the 3 bits abbreviation IDs otherwise
+  // fit in. The index itself comes after the records, and its offset is
+  // backpatched in a fixed size record emitted before them.
+  bool EmitIndex = VE.getNonMDStrings().size() > IndexThreshold;
+  Stream.EnterSubblock(bitc::METADATA_BLOCK_ID, EmitIndex ? 4 : 3);
   SmallVector<uint64_t, 64> Record;
   writeMetadataStrings(VE.getMDStrings(), Record);
-  writeMetadataRecords(VE.getNonMDStrings(), Record);
+
+  uint64_t IndexOffsetRecordBitPos = 0, IndexOffset = 0;
+  if (!EmitIndex) {
+    writeMetadataRecords(VE.getNonMDStrings(), Record);
+  } else {
+    std::vector<unsigned> MDAbbrevs(MetadataAbbrev::LastPlusOne);
+    MDAbbrevs[MetadataAbbrev::DILocationAbbrevID] = createDILocationAbbrev();
+    MDAbbrevs[MetadataAbbrev::GenericDINodeAbbrevID] =
+        createGenericDINodeAbbrev();
+
+    BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+    Abbv->Add(BitCodeAbbrevOp(bitc::METADATA_INDEX_OFFSET));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
+    unsigned OffsetAbbrev = Stream.EmitAbbrev(Abbv);
+
+    Abbv = new BitCodeAbbrev();
+    Abbv->Add(BitCodeAbbrevOp(bitc::METADATA_INDEX));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
+    unsigned IndexAbbrev = Stream.EmitAbbrev(Abbv);
+
+    // The offset of the index is relative to the end of this record.
+    uint64_t Vals[] = {0, 0};
+    Stream.EmitRecord(bitc::METADATA_INDEX_OFFSET, Vals, OffsetAbbrev);
+    IndexOffsetRecordBitPos = Stream.GetCurrentBitNo();
+
+    std::vector<uint64_t> IndexPos;
+    IndexPos.reserve(VE.getNonMDStrings().size());
+    writeMetadataRecords(VE.getNonMDStrings(), Record, &MDAbbrevs, &IndexPos);
+
+    IndexOffset = Stream.GetCurrentBitNo() - IndexOffsetRecordBitPos;
+
+    // Delta encode the positions, starting from the end of the offset record.
+    uint64_t PreviousPos = IndexOffsetRecordBitPos;
+    for (uint64_t &Pos : IndexPos) {
+      uint64_t Delta = Pos - PreviousPos;
+      PreviousPos = Pos;
+      Pos = Delta;
+    }
+    Stream.EmitRecord(bitc::METADATA_INDEX, IndexPos, IndexAbbrev);
+  }
+
   writeNamedMetadata(Record);
 
   auto AddDeclAttachedMetadata = [&](const GlobalObject &GO) {
@@ -1899,6 +1993,12 @@ void ModuleBitcodeWriter::writeModuleMetadata() {
       AddDeclAttachedMetadata(GV);
 
   Stream.ExitBlock();
+
+  // Only backpatch the offset once the block is flushed to the buffer.
+  if (IndexOffset) {
+    Stream.BackpatchWord(IndexOffsetRecordBitPos - 64, uint32_t(IndexOffset));
+    Stream.BackpatchWord(IndexOffsetRecordBitPos - 32, IndexOffset >> 32);
+  }
 }
 
 void ModuleBitcodeWriter::writeFunctionMetadata(const Function &F) {
@@ -3008,6 +3108,112 @@ void ModuleBitcodeWriter::writeFunction(
   Stream.ExitBlock();
 }
 
+/// Emit the function bodies to the module stream, encoding them on
+/// -bitcode-writer-threads threads.
+///
+/// Function blocks start on a word boundary and don't refer to their position
+/// in the stream, and the value enumeration is restored after each of them,
+/// so they can be encoded independently into a buffer per thread and copied
+/// to the stream in module order. This gives the same bits as encoding them
+/// in place; their offsets are recorded for the module-level VST as they are
+/// copied.
+void ModuleBitcodeWriter::writeFunctions(
+    DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex) {
+  std::vector<const Function *> Defs;
+  for (const Function &F : M)
+    if (!F.isDeclaration())
+      Defs.push_back(&F);
+
+  // The use-list orders are a stack popped in module order, they are only
+  // ever written serially.
+  unsigned NumThreads = std::min<size_t>(WriterThreads, Defs.size());
+  if (NumThreads < 2 || VE.shouldPreserveUseListOrder()) {
+    for (const Function *F : Defs)
+      writeFunction(*F, FunctionToBitcodeIndex);
+    return;
+  }
+  assert((Stream.GetCurrentBitNo() & 31) == 0 &&
+         "function block not 32-bit aligned");
+
+  // Balance the threads by instruction count, biggest functions first, and
+  // keep the functions of each thread in module order.
+  std::vector<std::pair<size_t, unsigned>> BySize;
+  for (unsigned I = 0, E = Defs.size(); I != E; ++I) {
+    size_t Size = 0;
+    for (const BasicBlock &BB : *Defs[I])
+      Size += BB.size();
+    BySize.push_back(std::make_pair(Size, I));
+  }
+  std::stable_sort(BySize.begin(), BySize.end(),
+                   [](const std::pair<size_t, unsigned> &LHS,
+                      const std::pair<size_t, unsigned> &RHS) {
+                     return LHS.first > RHS.first;
+                   });
+  std::vector<unsigned> ThreadOf(Defs.size());
+  std::vector<size_t> ThreadSize(NumThreads);
+  for (const auto &Entry : BySize) {
+    unsigned Smallest =
+        std::min_element(ThreadSize.begin(), ThreadSize.end()) -
+        ThreadSize.begin();
+    ThreadSize[Smallest] += Entry.first;
+    ThreadOf[Entry.second] = Smallest;
+  }
+  std::vector<std::vector<const Function *>> Assigned(NumThreads);
+  for (unsigned I = 0, E = Defs.size(); I != E; ++I)
+    Assigned[ThreadOf[I]].push_back(Defs[I]);
+
+  // The writers, and their copy of the value enumeration, are created here to
+  // keep the threads from sharing anything but the read-only IR.
+  std::vector<SmallVector<char, 0>> Buffers(NumThreads);
+  std::vector<std::unique_ptr<ModuleBitcodeWriter>> Writers;
+  for (auto &Buffer : Buffers)
+    Writers.emplace_back(new ModuleBitcodeWriter(*this, Buffer));
+
+  std::vector<std::vector<StringRef>> Blocks(NumThreads);
+  {
+    ThreadPool Pool(NumThreads);
+    for (unsigned T = 0; T != NumThreads; ++T)
+      Pool.async([&, T] {
+        Writers[T]->writeDetachedFunctions(Assigned[T], Blocks[T]);
+      });
+    Pool.wait();
+  }
+
+  std::vector<unsigned> NextBlock(NumThreads);
+  for (unsigned I = 0, E = Defs.size(); I != E; ++I) {
+    unsigned T = ThreadOf[I];
+    FunctionToBitcodeIndex[Defs[I]] = Stream.GetCurrentBitNo();
+    Stream.emitBlob(Blocks[T][NextBlock[T]++], /*ShouldEmitSize=*/false);
+  }
+}
+
+/// Encode the blocks of \p Functions into the buffer of this writer, as
+/// they would be encoded in the module block, and return their bytes in
+/// \p Blocks.
+void ModuleBitcodeWriter::writeDetachedFunctions(
+    ArrayRef<const Function *> Functions, std::vector<StringRef> &Blocks) {
+  // Register the same abbreviations, and use the same abbrev ID width, as the
+  // module stream. Only the function blocks themselves are returned.
+  writeBlockInfo();
+  Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
+
+  DenseMap<const Function *, uint64_t> FunctionToBitcodeIndex;
+  std::vector<std::pair<size_t, size_t>> Ranges;
+  for (const Function *F : Functions) {
+    size_t Begin = Buffer.size();
+    writeFunction(*F, FunctionToBitcodeIndex);
+    assert(Stream.GetCurrentBitNo() == Buffer.size() * 8 &&
+           "function block not 32-bit aligned");
+    Ranges.push_back(std::make_pair(Begin, Buffer.size()));
+  }
+  Stream.ExitBlock();
+
+  // The buffer doesn't move anymore.
+  for (const auto &Range : Ranges)
+    Blocks.push_back(StringRef(Buffer.data() + Range.first,
+                               Range.second - Range.first));
+}
+
 // Emit blockinfo, which defines the standard abbreviations etc.
 void ModuleBitcodeWriter::writeBlockInfo() {
   // We only want to emit block info records for blocks that have multiple
@@ -3688,9 +3894,7 @@ void ModuleBitcodeWriter::writeModule() {
 
   // Emit function bodies.
   DenseMap<const Function *, uint64_t> FunctionToBitcodeIndex;
-  for (Module::const_iterator F = M.begin(), E = M.end(); F != E; ++F)
-    if (!F->isDeclaration())
-      writeFunction(*F, FunctionToBitcodeIndex);
+  writeFunctions(FunctionToBitcodeIndex);
 
   // Need to write after the above call to WriteFunction which populates
   // the summary information in the index.
@@ -620,7 +620,7 @@ UserValue::addDefsFromCopies(LiveInterval *LI, unsigned LocNo,
     if (!I.valid() || I.value() != LocNo)
       continue;
 
-    if (!LIS.hasInterval(DstReg))
+    if (MRI.reg_nodbg_empty(DstReg))
       continue;
     LiveInterval *DstLI = &LIS.getInterval(DstReg);
     const VNInfo *DstVNI = DstLI->getVNInfoAt(Idx.getRegSlot());
@@ -685,7 +685,7 @@ UserValue::computeIntervals(MachineRegisterInfo &MRI,
     if (TargetRegisterInfo::isVirtualRegister(Loc.getReg())) {
       LiveInterval *LI = nullptr;
       const VNInfo *VNI = nullptr;
-      if (LIS.hasInterval(Loc.getReg())) {
+      if (!MRI.reg_nodbg_empty(Loc.getReg())) {
         LI = &LIS.getInterval(Loc.getReg());
         VNI = LI->getVNInfoAt(Idx);
       }
@@ -17,6 +17,7 @@
 #include "llvm/CodeGen/LiveIntervalAnalysis.h"
 #include "LiveRangeCalc.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/CodeGen/LiveVariables.h"
 #include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
@@ -40,6 +41,8 @@ using namespace llvm;
 
 #define DEBUG_TYPE "regalloc"
 
+STATISTIC(NumIntervalsComputed, "Number of virtual register intervals computed");
+
 char LiveIntervals::ID = 0;
 char &llvm::LiveIntervalsID = LiveIntervals::ID;
 INITIALIZE_PASS_BEGIN(LiveIntervals, "liveintervals",
@@ -58,6 +61,11 @@ static cl::opt<bool> EnablePrecomputePhysRegs(
 static bool EnablePrecomputePhysRegs = false;
 #endif // NDEBUG
 
+static cl::opt<bool> EnableLazyLiveIntervals(
+  "lazy-live-intervals", cl::Hidden,
+  cl::desc("Compute the live interval of a virtual register when it is first "
+           "queried rather than for all virtual registers up front."));
+
 static cl::opt<bool> EnableSubRegLiveness(
   "enable-subreg-liveness", cl::Hidden, cl::init(true),
   cl::desc("Enable subregister liveness tracking."));
@@ -83,7 +91,7 @@ void LiveIntervals::getAnalysisUsage(AnalysisUsage &AU) const {
 }
 
 LiveIntervals::LiveIntervals() : MachineFunctionPass(ID),
-  DomTree(nullptr), LRCalc(nullptr) {
+  DomTree(nullptr), LRCalc(nullptr), Lazy(false) {
   initializeLiveIntervalsPass(*PassRegistry::getPassRegistry());
 }
 
@@ -128,7 +136,12 @@ bool LiveIntervals::runOnMachineFunction(MachineFunction &fn) {
   // Allocate space for all virtual registers.
   VirtRegIntervals.resize(MRI->getNumVirtRegs());
 
-  computeVirtRegs();
+  // In lazy mode, getInterval() computes the intervals as they are needed.
+  // The intervals of the registers no pass looks at before they are deleted
+  // are never computed.
+  Lazy = EnableLazyLiveIntervals;
+  if (!Lazy)
+    computeVirtRegs();
   computeRegMasks();
   computeLiveInRegUnits();
 
@@ -192,6 +205,7 @@ void LiveIntervals::computeVirtRegInterval(LiveInterval &LI) {
   LRCalc->reset(MF, getSlotIndexes(), DomTree, &getVNInfoAllocator());
   LRCalc->calculate(LI, MRI->shouldTrackSubRegLiveness(LI.reg));
   computeDeadValues(LI, nullptr);
+  ++NumIntervalsComputed;
 }
 
 void LiveIntervals::computeVirtRegs() {
@@ -951,6 +965,11 @@ public:
       if (!Reg)
         continue;
       if (TargetRegisterInfo::isVirtualRegister(Reg)) {
+        // In lazy mode, an interval no pass has queried yet will be computed
+        // from the final positions. Computing it here would start from NewIdx
+        // and then apply the move a second time.
+        if (LIS.isLazy() && !LIS.hasInterval(Reg))
+          continue;
         LiveInterval &LI = LIS.getInterval(Reg);
         if (LI.hasSubRanges()) {
           unsigned SubReg = MO.getSubReg();
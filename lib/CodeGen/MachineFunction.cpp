@@ -52,6 +52,12 @@ static cl::opt<unsigned>
                       cl::desc("Force the alignment of all functions."),
                       cl::init(0), cl::Hidden);
 
+static cl::opt<bool>
+    ArenaInstrStorage("machine-instr-arena", cl::Hidden,
+                      cl::desc("Allocate machine instructions and their "
+                               "operands in creation order, without reusing "
+                               "the memory of deleted instructions."));
+
 void MachineFunctionInitializer::anchor() {}
 
 void MachineFunctionProperties::print(raw_ostream &ROS, bool OnlySet) const {
@@ -99,7 +105,7 @@ static inline unsigned getFnStackAlignment(const TargetSubtargetInfo *STI,
 MachineFunction::MachineFunction(const Function *F, const TargetMachine &TM,
                                  unsigned FunctionNum, MachineModuleInfo &mmi)
     : Fn(F), Target(TM), STI(TM.getSubtargetImpl(*F)), Ctx(mmi.getContext()),
-      MMI(mmi) {
+      MMI(mmi), ArenaStorage(ArenaInstrStorage) {
   // Assume the function starts in SSA form with correct liveness.
   Properties.set(MachineFunctionProperties::Property::IsSSA);
   Properties.set(MachineFunctionProperties::Property::TracksLiveness);
@@ -250,16 +256,20 @@ void MachineFunction::RenumberBlocks(MachineBasicBlock *MBB) {
 MachineInstr *MachineFunction::CreateMachineInstr(const MCInstrDesc &MCID,
                                                   const DebugLoc &DL,
                                                   bool NoImp) {
-  return new (InstructionRecycler.Allocate<MachineInstr>(Allocator))
-    MachineInstr(*this, MCID, DL, NoImp);
+  return new (allocateMachineInstr()) MachineInstr(*this, MCID, DL, NoImp);
 }
 
 /// Create a new MachineInstr which is a copy of the 'Orig' instruction,
 /// identical in all ways except the instruction has no parent, prev, or next.
 MachineInstr *
 MachineFunction::CloneMachineInstr(const MachineInstr *Orig) {
-  return new (InstructionRecycler.Allocate<MachineInstr>(Allocator))
-             MachineInstr(*this, *Orig);
+  return new (allocateMachineInstr()) MachineInstr(*this, *Orig);
+}
+
+void *MachineFunction::allocateMachineInstr() {
+  if (ArenaStorage)
+    return Allocator.Allocate<MachineInstr>();
+  return InstructionRecycler.Allocate<MachineInstr>(Allocator);
 }
 
 /// Delete the given MachineInstr.
@@ -275,7 +285,8 @@ MachineFunction::DeleteMachineInstr(MachineInstr *MI) {
   // Don't call ~MachineInstr() which must be trivial anyway because
   // ~MachineFunction drops whole lists of MachineInstrs wihout calling their
   // destructors.
-  InstructionRecycler.Deallocate(Allocator, MI);
+  if (!ArenaStorage)
+    InstructionRecycler.Deallocate(Allocator, MI);
 }
 
 /// Allocate a new MachineBasicBlock. Use this instead of
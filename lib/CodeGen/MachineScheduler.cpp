@@ -14,6 +14,7 @@
 
 #include "llvm/CodeGen/MachineScheduler.h"
 #include "llvm/ADT/PriorityQueue.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/CodeGen/LiveIntervalAnalysis.h"
 #include "llvm/CodeGen/MachineDominators.h"
@@ -35,6 +36,9 @@ using namespace llvm;
 
 #define DEBUG_TYPE "misched"
 
+STATISTIC(NumWindowedRegions,
+          "Number of regions over the budget scheduled in windows");
+
 namespace llvm {
 cl::opt<bool> ForceTopDown("misched-topdown", cl::Hidden,
                            cl::desc("Force top-down list scheduling"));
@@ -70,6 +74,16 @@ static bool ViewMISchedDAGs = false;
 static cl::opt<unsigned> ReadyListLimit("misched-limit", cl::Hidden,
   cl::desc("Limit ready list to N instructions"), cl::init(256));
 
+/// Building the DAG of a region is quadratic in its size, regions over this
+/// many instructions are scheduled as a sequence of smaller regions.
+static cl::opt<unsigned> RegionBudget("misched-region-budget", cl::Hidden,
+  cl::desc("Schedule regions over N instructions in windows"),
+  cl::init(4096));
+
+static cl::opt<unsigned> RegionWindow("misched-region-window", cl::Hidden,
+  cl::desc("Number of instructions in the windows of regions over the "
+           "budget"), cl::init(1024));
+
 static cl::opt<bool> EnableRegPressure("misched-regpressure", cl::Hidden,
   cl::desc("Enable register pressure scheduling."), cl::init(true));
 
@@ -444,12 +458,18 @@ void MachineSchedulerBase::scheduleRegions(ScheduleDAGInstrs &Scheduler,
     //
     // MBB::size() uses instr_iterator to count. Here we need a bundle to count
     // as a single instruction.
+    //
+    // Regions over the budget are scheduled bottom-up in windows, each with a
+    // DAG of its own, so that the time spent in them stays linear. A window
+    // ends right above the previous one rather than at a boundary.
+    bool InWindowedRegion = false;
     for(MachineBasicBlock::iterator RegionEnd = MBB->end();
         RegionEnd != MBB->begin(); RegionEnd = Scheduler.begin()) {
 
       // Avoid decrementing RegionEnd for blocks with no terminator.
-      if (RegionEnd != MBB->end() ||
-          isSchedBoundary(&*std::prev(RegionEnd), &*MBB, MF, TII)) {
+      if (!InWindowedRegion &&
+          (RegionEnd != MBB->end() ||
+           isSchedBoundary(&*std::prev(RegionEnd), &*MBB, MF, TII))) {
         --RegionEnd;
       }
 
@@ -462,7 +482,29 @@ void MachineSchedulerBase::scheduleRegions(ScheduleDAGInstrs &Scheduler,
           break;
         if (!I->isDebugValue())
           ++NumRegionInstrs;
+        if (InWindowedRegion && NumRegionInstrs > RegionWindow)
+          break;
+      }
+
+      if (!InWindowedRegion && RegionWindow &&
+          NumRegionInstrs > std::max<unsigned>(RegionBudget, RegionWindow)) {
+        ++NumWindowedRegions;
+        DEBUG(dbgs() << "Scheduling a region of " << NumRegionInstrs
+                     << " instructions in windows\n");
+        InWindowedRegion = true;
+        NumRegionInstrs = 0;
+        for (I = RegionEnd; ; --I) {
+          if (!I->isDebugValue())
+            ++NumRegionInstrs;
+          if (NumRegionInstrs > RegionWindow)
+            break;
+        }
       }
+      // The last window of a region ends at its top boundary.
+      if (InWindowedRegion &&
+          (I == MBB->begin() ||
+           isSchedBoundary(&*std::prev(I), &*MBB, MF, TII)))
+        InWindowedRegion = false;
       // Notify the scheduler of the region, even if we may skip scheduling
       // it. Perhaps it still needs to be bundled.
       Scheduler.enterRegion(&*MBB, I, RegionEnd, NumRegionInstrs);
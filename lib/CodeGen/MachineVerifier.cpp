@@ -1241,7 +1241,7 @@ void MachineVerifier::checkLiveness(const MachineOperand *MO, unsigned MONum) {
               report_context(UseIdx);
             }
           }
-        } else {
+        } else if (!LiveInts->isLazy()) {
           report("Virtual register has no live interval", MO, MONum);
         }
       }
@@ -1332,7 +1332,7 @@ void MachineVerifier::checkLiveness(const MachineOperand *MO, unsigned MONum) {
               checkLivenessAtDef(MO, MONum, DefIdx, SR, Reg, SR.LaneMask);
             }
           }
-        } else {
+        } else if (!LiveInts->isLazy()) {
           report("Virtual register has no Live interval", MO, MONum);
         }
       }
@@ -1562,6 +1562,9 @@ void MachineVerifier::verifyLiveIntervals() {
       continue;
 
     if (!LiveInts->hasInterval(Reg)) {
+      // Lazily computed intervals may not have been queried yet.
+      if (LiveInts->isLazy())
+        continue;
       report("Missing live interval for virtual register", MF);
       errs() << PrintReg(Reg, TRI) << " still has defs or uses\n";
       continue;
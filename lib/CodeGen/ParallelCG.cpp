@@ -52,12 +52,24 @@ std::unique_ptr<Module> llvm::splitCodeGen(
   // Create ThreadPool in nested scope so that threads will be joined
   // on destruction.
   {
-    ThreadPool CodegenThreadPool(OSs.size());
+    ThreadPool CodegenThreadPool(OSs.size() - 1);
     int ThreadCount = 0;
 
     SplitModule(
         std::move(M), OSs.size(),
         [&](std::unique_ptr<Module> MPart) {
+          // The last partition is M itself, left to the original context once
+          // the other partitions are serialized. Generate its code on this
+          // thread while the others are being generated.
+          if (ThreadCount == int(OSs.size()) - 1) {
+            if (!BCOSs.empty()) {
+              WriteBitcodeToFile(MPart.get(), *BCOSs[ThreadCount]);
+              BCOSs[ThreadCount]->flush();
+            }
+            codegen(MPart.get(), *OSs[ThreadCount], TMFactory, FileType);
+            return;
+          }
+
           // We want to clone the module in a new context to multi-thread the
           // codegen. We do it by serializing partition modules to bitcode
           // (while still on the main thread, in order to avoid data races) and
@@ -55,6 +55,8 @@ using namespace llvm;
 STATISTIC(NumGlobalSplits, "Number of split global live ranges");
 STATISTIC(NumLocalSplits,  "Number of split local live ranges");
 STATISTIC(NumEvicted,      "Number of interferences evicted");
+STATISTIC(NumSplitBudgetExhausted,
+          "Number of functions that exhausted their splitting budget");
 
 static cl::opt<SplitEditor::ComplementSpillMode> SplitSpillMode(
     "split-spill-mode", cl::Hidden,
@@ -95,6 +97,18 @@ static cl::opt<bool> EnableDeferredSpilling(
              "variable because of other evicted variables."),
     cl::init(false));
 
+static cl::opt<unsigned> HugeFunctionVRegs(
+    "regalloc-huge-function-vregs", cl::Hidden,
+    cl::desc("Number of virtual registers above which a function is "
+             "allocated under the splitting budget"),
+    cl::init(50000));
+
+static cl::opt<unsigned> SplitBudget(
+    "regalloc-split-budget", cl::Hidden,
+    cl::desc("Number of live range splitting attempts in a huge function "
+             "before the remaining live ranges are spilled instead"),
+    cl::init(20000));
+
 // FIXME: Find a good default for this flag and remove the flag.
 static cl::opt<unsigned>
 CSRFirstTimeCost("regalloc-csr-first-time-cost",
@@ -314,6 +328,11 @@ class RAGreedy : public MachineFunctionPass,
   /// Set of broken hints that may be reconciled later because of eviction.
   SmallSetVector<LiveInterval *, 8> SetOfBrokenHints;
 
+  /// Number of splitting attempts left in the current function, ~0u if the
+  /// function isn't under a budget.
+  unsigned RemainingSplitBudget;
+  bool SplitBudgetExhausted;
+
 public:
   RAGreedy();
 
@@ -1955,6 +1974,22 @@ unsigned RAGreedy::trySplit(LiveInterval &VirtReg, AllocationOrder &Order,
   if (getStage(VirtReg) >= RS_Spill)
     return 0;
 
+  // SplitKit and the interference cache make splitting super-linear in the
+  // size of the function. Once a huge function has spent its budget, the
+  // remaining live ranges are spilled around their uses, as the basic
+  // allocator does.
+  if (RemainingSplitBudget != ~0u) {
+    if (!RemainingSplitBudget) {
+      if (!SplitBudgetExhausted) {
+        SplitBudgetExhausted = true;
+        ++NumSplitBudgetExhausted;
+        DEBUG(dbgs() << "Splitting budget exhausted, spilling from now on\n");
+      }
+      return 0;
+    }
+    --RemainingSplitBudget;
+  }
+
   // Local intervals are handled separately.
   if (LIS->intervalIsInOneMBB(VirtReg)) {
     NamedRegionTimer T("Local Splitting", TimerGroupName, TimePassesIsEnabled);
@@ -2609,6 +2644,9 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   IntfCache.init(MF, Matrix->getLiveUnions(), Indexes, LIS, TRI);
   GlobalCand.resize(32);  // This will grow as needed.
   SetOfBrokenHints.clear();
+  RemainingSplitBudget =
+      MRI->getNumVirtRegs() > HugeFunctionVRegs ? SplitBudget : ~0u;
+  SplitBudgetExhausted = false;
 
   allocatePhysRegs();
   tryHintsRecoloring();
@@ -375,7 +375,9 @@ bool RenameIndependentSubregs::runOnMachineFunction(MachineFunction &MF) {
   bool Changed = false;
   for (size_t I = 0, E = MRI->getNumVirtRegs(); I < E; ++I) {
     unsigned Reg = TargetRegisterInfo::index2VirtReg(I);
-    if (!LIS->hasInterval(Reg))
+    // Only registers with subregister liveness can have subranges. Don't
+    // compute the other intervals if they are computed lazily.
+    if (!MRI->shouldTrackSubRegLiveness(Reg) || MRI->reg_nodbg_empty(Reg))
       continue;
     LiveInterval &LI = LIS->getInterval(Reg);
     if (!LI.hasSubRanges())
@@ -49,6 +49,7 @@ STATISTIC(PostIndexedNodes, "Number of post-indexed nodes created");
 STATISTIC(OpsNarrowed     , "Number of load/op/store narrowed");
 STATISTIC(LdStFP2Int      , "Number of fp load/store pairs transformed to int");
 STATISTIC(SlicedLoads, "Number of load sliced");
+STATISTIC(NodesSkipped, "Number of unchanged nodes not revisited");
 
 namespace {
   static cl::opt<bool>
@@ -82,6 +83,16 @@ namespace {
     MaySplitLoadIndex("combiner-split-load-index", cl::Hidden, cl::init(true),
                       cl::desc("DAG combiner may split indexing from loads"));
 
+  /// Nodes in which a combine found nothing to do are remembered until they
+  /// or their neighbours change, and later combines of the same block don't
+  /// revisit them. This makes the later combines proportional to the changes
+  /// made by legalization, at the price of missing the combines that only
+  /// become possible because of the level of the later combine.
+  static cl::opt<bool>
+    CombinerIncremental("combiner-incremental", cl::Hidden, cl::init(false),
+                        cl::desc("Only revisit the DAG nodes created or "
+                                 "modified since the previous combine"));
+
 //------------------------------ DAGCombiner ---------------------------------//
 
   class DAGCombiner {
@@ -1246,9 +1257,15 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
   LegalOperations = Level >= AfterLegalizeVectorOps;
   LegalTypes = Level >= AfterLegalizeTypes;
 
-  // Add all the dag nodes to the worklist.
-  for (SDNode &Node : DAG.allnodes())
+  // Add all the dag nodes to the worklist, but the ones a previous combine
+  // settled when combining incrementally.
+  for (SDNode &Node : DAG.allnodes()) {
+    if (CombinerIncremental && DAG.isCombineSettled(&Node)) {
+      ++NodesSkipped;
+      continue;
+    }
     AddToWorklist(&Node);
+  }
 
   // Create a dummy node (which is not added to allnodes), that adds a reference
   // to the root node, preventing it from being deleted, and tracking any
@@ -1297,13 +1314,17 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
     // won't repeatedly process the same operand.
     CombinedNodes.insert(N);
     for (const SDValue &ChildN : N->op_values())
-      if (!CombinedNodes.count(ChildN.getNode()))
+      if (!CombinedNodes.count(ChildN.getNode()) &&
+          !(CombinerIncremental && DAG.isCombineSettled(ChildN.getNode())))
         AddToWorklist(ChildN.getNode());
 
     SDValue RV = combine(N);
 
-    if (!RV.getNode())
+    if (!RV.getNode()) {
+      if (CombinerIncremental)
+        DAG.setCombineSettled(N);
       continue;
+    }
 
     ++NodesCombined;
 
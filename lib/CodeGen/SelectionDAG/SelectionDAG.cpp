@@ -654,7 +654,25 @@ void SDDbgInfo::erase(const SDNode *Node) {
   DbgValMap.erase(I);
 }
 
+/// Drop the combiner marks of the nodes whose combines may be affected by a
+/// modification or the deletion of \p N: N itself, its users, which may now
+/// match other patterns, and its operands, which may lose a use.
+void SelectionDAG::unsettleCombineAround(SDNode *N) {
+  if (CombineSettledNodes.empty())
+    return;
+  CombineSettledNodes.erase(N);
+  for (SDNode *User : N->uses())
+    CombineSettledNodes.erase(User);
+  for (const SDValue &Op : N->op_values())
+    CombineSettledNodes.erase(Op.getNode());
+}
+
 void SelectionDAG::DeallocateNode(SDNode *N) {
+  // The memory of N may be reused by a new node, which must not inherit its
+  // combiner mark.
+  if (!CombineSettledNodes.empty())
+    CombineSettledNodes.erase(N);
+
   // If we have operands, deallocate them.
   removeOperands(N);
 
@@ -715,8 +733,10 @@ static void VerifySDNode(SDNode *N) {
 /// verification and other common operations when a new node is allocated.
 void SelectionDAG::InsertNode(SDNode *N) {
   AllNodes.push_back(N);
-#ifndef NDEBUG
+#ifdef LLVM_ENABLE_ABI_BREAKING_CHECKS
   N->PersistentId = NextPersistentId++;
+#endif
+#ifndef NDEBUG
   VerifySDNode(N);
 #endif
 }
@@ -726,6 +746,9 @@ void SelectionDAG::InsertNode(SDNode *N) {
 /// the node.  We don't want future request for structurally identical nodes
 /// to return N anymore.
 bool SelectionDAG::RemoveNodeFromCSEMaps(SDNode *N) {
+  // Nodes are removed from the CSE maps before being modified or deleted.
+  unsettleCombineAround(N);
+
   bool Erased = false;
   switch (N->getOpcode()) {
   case ISD::HANDLENODE: return false;  // noop.
@@ -909,9 +932,7 @@ void SelectionDAG::allnodes_clear() {
   AllNodes.remove(AllNodes.begin());
   while (!AllNodes.empty())
     DeallocateNode(&AllNodes.front());
-#ifndef NDEBUG
   NextPersistentId = 0;
-#endif
 }
 
 SDNode *SelectionDAG::GetBinarySDNode(unsigned Opcode, const SDLoc &DL,
@@ -979,9 +1000,9 @@ SDNode *SelectionDAG::FindNodeOrInsertPos(const FoldingSetNodeID &ID,
 
 void SelectionDAG::clear() {
   allnodes_clear();
-  OperandRecycler.clear(OperandAllocator);
-  OperandAllocator.Reset();
+  NodeDataAllocator.Reset();
   CSEMap.clear();
+  CombineSettledNodes.clear();
 
   ExtendedValueTypeNodes.clear();
   ExternalSymbols.clear();
@@ -1627,8 +1648,8 @@ SDValue SelectionDAG::getVectorShuffle(EVT VT, const SDLoc &dl, SDValue N1,
 
   // Allocate the mask array for the node out of the BumpPtrAllocator, since
   // SDNode doesn't have access to it.  This memory will be "leaked" when
-  // the node is deallocated, but recovered when the NodeAllocator is released.
-  int *MaskAlloc = OperandAllocator.Allocate<int>(NElts);
+  // the node is deallocated, but recovered when the DAG is cleared.
+  int *MaskAlloc = NodeDataAllocator.Allocate<int>(NElts);
   std::copy(MaskVec.begin(), MaskVec.end(), MaskAlloc);
 
   auto *N = newSDNode<ShuffleVectorSDNode>(VT, dl.getIROrder(),
@@ -371,7 +371,7 @@ const char *SDNode::getIndexedModeName(ISD::MemIndexedMode AM) {
 
 static Printable PrintNodeId(const SDNode &Node) {
   return Printable([&Node](raw_ostream &OS) {
-#ifndef NDEBUG
+#ifdef LLVM_ENABLE_ABI_BREAKING_CHECKS
     OS << 't' << Node.PersistentId;
 #else
     OS << (const void*)&Node;
@@ -48,6 +48,7 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
@@ -73,6 +74,11 @@ STATISTIC(NumEntryBlocks, "Number of entry blocks encountered");
 STATISTIC(NumFastIselFailLowerArguments,
           "Number of entry blocks where fast isel failed to lower arguments");
 
+static cl::opt<bool>
+ReportISelThroughput("isel-report-throughput", cl::Hidden,
+          cl::desc("Report the number of IR instructions selected per second "
+                   "and how many of them fast-isel left to SelectionDAG"));
+
 #ifndef NDEBUG
 static cl::opt<bool>
 EnableFastISelVerbose2("fast-isel-verbose2", cl::Hidden,
@@ -359,7 +365,7 @@ SelectionDAGISel::SelectionDAGISel(TargetMachine &tm,
   SDB(new SelectionDAGBuilder(*CurDAG, *FuncInfo, OL)),
   GFI(),
   OptLevel(OL),
-  DAGSize(0) {
+  DAGSize(0), NumInstsSelected(0), NumInstsFellBack(0), SelectionTime(0) {
     initializeGCModuleInfoPass(*PassRegistry::getPassRegistry());
     initializeBranchProbabilityInfoWrapperPassPass(
         *PassRegistry::getPassRegistry());
@@ -374,6 +380,22 @@ SelectionDAGISel::~SelectionDAGISel() {
   delete FuncInfo;
 }
 
+bool SelectionDAGISel::doFinalization(Module &M) {
+  if (ReportISelThroughput) {
+    double Throughput = SelectionTime > 0 ? NumInstsSelected / SelectionTime : 0;
+    errs() << "isel: selected " << NumInstsSelected << " instructions in "
+           << format("%.3f", SelectionTime) << "s ("
+           << format("%.0f", Throughput) << " instructions/s)";
+    if (TM.Options.EnableFastISel)
+      errs() << ", " << NumInstsFellBack
+             << " left by fast-isel to SelectionDAG";
+    errs() << '\n';
+    NumInstsSelected = NumInstsFellBack = 0;
+    SelectionTime = 0;
+  }
+  return MachineFunctionPass::doFinalization(M);
+}
+
 void SelectionDAGISel::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.addRequired<AAResultsWrapperPass>();
   AU.addRequired<GCModuleInfo>();
@@ -497,7 +519,16 @@ bool SelectionDAGISel::runOnMachineFunction(MachineFunction &mf) {
     // This performs initialization so lowering for SplitCSR will be correct.
     TLI->initializeSplitCSR(EntryMBB);
 
-  SelectAllBasicBlocks(Fn);
+  if (ReportISelThroughput) {
+    TimeRecord Start = TimeRecord::getCurrentTime(/*Start=*/true);
+    SelectAllBasicBlocks(Fn);
+    SelectionTime += TimeRecord::getCurrentTime(/*Start=*/false).getWallTime() -
+                     Start.getWallTime();
+    for (const BasicBlock &BB : Fn)
+      NumInstsSelected += BB.size();
+  } else {
+    SelectAllBasicBlocks(Fn);
+  }
 
   // If the first basic block in the function has live ins that need to be
   // copied into vregs, emit the copies into the top of the block before
@@ -1429,6 +1460,7 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
           // selection may have handled the call, input args, etc.
           unsigned RemainingNow = std::distance(Begin, BI);
           NumFastIselFailures += NumFastIselRemaining - RemainingNow;
+          NumInstsFellBack += NumFastIselRemaining - RemainingNow;
           NumFastIselRemaining = RemainingNow;
           continue;
         }
@@ -1451,6 +1483,7 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
           report_fatal_error("FastISel didn't select the entire block");
 
         NumFastIselFailures += NumFastIselRemaining;
+        NumInstsFellBack += NumFastIselRemaining;
         break;
       }
 
@@ -20,6 +20,7 @@
 #include "llvm/Support/ELF.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 using namespace llvm;
@@ -339,11 +340,10 @@ const DWARFDebugLocDWO *DWARFContext::getDebugLocDWO() {
 }
 
 const DWARFDebugAranges *DWARFContext::getDebugAranges() {
-  if (Aranges)
-    return Aranges.get();
-
-  Aranges.reset(new DWARFDebugAranges());
-  Aranges->generate(this);
+  std::call_once(ArangesOnce, [this] {
+    Aranges.reset(new DWARFDebugAranges());
+    Aranges->generate(this);
+  });
   return Aranges.get();
 }
 
@@ -413,6 +413,19 @@ DWARFContext::getLineTableForUnit(DWARFUnit *U) {
   return Line->getOrParseLineTable(lineData, stmtOffset);
 }
 
+void DWARFContext::extractCompileUnitDIEs() {
+  parseCompileUnits();
+  if (NumThreads == 1 || CUs.size() < 2) {
+    for (const auto &CU : CUs)
+      CU->extractDIEs();
+    return;
+  }
+  ThreadPool Pool(std::min<size_t>(NumThreads, CUs.size()));
+  for (const auto &CU : CUs)
+    Pool.async([&CU] { CU->extractDIEs(); });
+  Pool.wait();
+}
+
 void DWARFContext::parseCompileUnits() {
   CUs.parse(*this, getInfoSection());
 }
@@ -12,6 +12,7 @@
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugArangeSet.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -47,17 +48,32 @@ void DWARFDebugAranges::generate(DWARFContext *CTX) {
   // Generate aranges from DIEs: even if .debug_aranges section is present,
   // it may describe only a small subset of compilation units, so we need to
   // manually build aranges for the rest of them.
-  for (const auto &CU : CTX->compile_units()) {
-    uint32_t CUOffset = CU->getOffset();
-    if (ParsedCUOffsets.insert(CUOffset).second) {
-      DWARFAddressRangesVector CURanges;
-      CU->collectAddressRanges(CURanges);
-      for (const auto &R : CURanges) {
-        appendRange(CUOffset, R.first, R.second);
-      }
-    }
+  std::vector<DWARFCompileUnit *> MissingCUs;
+  for (const auto &CU : CTX->compile_units())
+    if (ParsedCUOffsets.insert(CU->getOffset()).second)
+      MissingCUs.push_back(CU.get());
+
+  // Collecting the ranges of a unit may require extracting all its DIEs, so
+  // spread the units over a thread pool when allowed to. Each unit only
+  // touches its own DIEs and ranges, which are appended in unit order below
+  // to keep the result deterministic.
+  std::vector<DWARFAddressRangesVector> CURanges(MissingCUs.size());
+  unsigned NumThreads =
+      std::min<size_t>(CTX->getNumThreads(), MissingCUs.size());
+  if (NumThreads > 1) {
+    ThreadPool Pool(NumThreads);
+    for (size_t I = 0, E = MissingCUs.size(); I != E; ++I)
+      Pool.async([&, I] { MissingCUs[I]->collectAddressRanges(CURanges[I]); });
+    Pool.wait();
+  } else {
+    for (size_t I = 0, E = MissingCUs.size(); I != E; ++I)
+      MissingCUs[I]->collectAddressRanges(CURanges[I]);
   }
 
+  for (size_t I = 0, E = MissingCUs.size(); I != E; ++I)
+    for (const auto &R : CURanges[I])
+      appendRange(MissingCUs[I]->getOffset(), R.first, R.second);
+
   construct();
 }
 
@@ -237,6 +237,7 @@ void DWARFUnit::extractDIEsToVector(
 }
 
 size_t DWARFUnit::extractDIEsIfNeeded(bool CUDieOnly) {
+  std::lock_guard<std::recursive_mutex> Lock(DieArrayMutex);
   if ((CUDieOnly && DieArray.size() > 0) ||
       DieArray.size() > 1)
     return 0; // Already parsed.
@@ -247,6 +248,11 @@ size_t DWARFUnit::extractDIEsIfNeeded(bool CUDieOnly) {
   if (DieArray.empty())
     return 0;
 
+  // extractDIEsToVector reserves memory based on an average DIE size, give
+  // back what was over-estimated since the array lives as long as the unit.
+  if (!CUDieOnly)
+    DieArray.shrink_to_fit();
+
   // If CU DIE was just parsed, copy several attribute values from it.
   if (!HasCUDie) {
     uint64_t BaseAddr =
@@ -315,6 +321,7 @@ bool DWARFUnit::parseDWO() {
 }
 
 void DWARFUnit::clearDIEs(bool KeepCUDie) {
+  std::lock_guard<std::recursive_mutex> Lock(DieArrayMutex);
   if (DieArray.size() > (unsigned)KeepCUDie) {
     // std::vectors never get any smaller when resized to a smaller size,
     // or when clear() or erase() are called, the size will report that it
@@ -0,0 +1,435 @@
+//===-- CachedSymbolizableModule.cpp --------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Implementation of CachedSymbolizableModule class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "CachedSymbolizableModule.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Object/ELFObjectFile.h"
+#include "llvm/Object/MachO.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace llvm {
+namespace symbolize {
+
+using namespace object;
+using namespace support;
+
+// An entry is laid out as follows, all integers being little endian:
+//   Header:  "LLVMSYMC", u32 Version, u32 NumResults, u32 IsWin32,
+//            u64 PreferredBase
+//   Index:   NumResults x (u64 Address, u32 Key, u32 Offset, u32 Size),
+//            sorted by (Address, Key)
+//   Results: the encoded results, Offset is relative to the end of the index.
+//            Entries whose results would not fit in 4GB are not written.
+static const char Magic[] = {'L', 'L', 'V', 'M', 'S', 'Y', 'M', 'C'};
+static const uint32_t Version = 1;
+static const size_t HeaderSize = sizeof(Magic) + 3 * 4 + 8;
+static const size_t IndexEntrySize = 8 + 3 * 4;
+
+namespace {
+enum QueryKind { QK_Code = 1, QK_InlinedCode = 2, QK_Data = 3 };
+}
+
+// The key of a query encodes everything besides the address that the result
+// depends on.
+static uint32_t getQueryKey(QueryKind Kind,
+                            FunctionNameKind FNKind = FunctionNameKind::None,
+                            bool UseSymbolTable = false) {
+  return (Kind << 8) | (static_cast<uint32_t>(FNKind) << 1) | UseSymbolTable;
+}
+
+static void writeString(endian::Writer<little> &W, StringRef S) {
+  W.write<uint32_t>(S.size());
+  W.OS << S;
+}
+
+static void writeLineInfo(endian::Writer<little> &W, const DILineInfo &Info) {
+  writeString(W, Info.FileName);
+  writeString(W, Info.FunctionName);
+  W.write<uint32_t>(Info.Line);
+  W.write<uint32_t>(Info.Column);
+}
+
+namespace {
+/// Decodes a result, stopping at the first read past its end.
+class ResultReader {
+  StringRef Data;
+  bool Failed = false;
+
+public:
+  ResultReader(StringRef Data) : Data(Data) {}
+  bool failed() const { return Failed; }
+
+  uint32_t readU32() {
+    if (Data.size() < 4) {
+      Failed = true;
+      return 0;
+    }
+    uint32_t V = endian::read32le(Data.data());
+    Data = Data.drop_front(4);
+    return V;
+  }
+  uint64_t readU64() {
+    uint64_t Lo = readU32();
+    return Lo | (uint64_t(readU32()) << 32);
+  }
+  std::string readString() {
+    uint32_t Size = readU32();
+    if (Data.size() < Size) {
+      Failed = true;
+      return std::string();
+    }
+    std::string S = Data.substr(0, Size);
+    Data = Data.drop_front(Size);
+    return S;
+  }
+  DILineInfo readLineInfo() {
+    DILineInfo Info;
+    Info.FileName = readString();
+    Info.FunctionName = readString();
+    Info.Line = readU32();
+    Info.Column = readU32();
+    return Info;
+  }
+};
+}
+
+/// Returns the GNU build ID of an ELF object, or an empty string.
+static StringRef getELFBuildID(const ELFObjectFileBase *Obj) {
+  for (const SectionRef &Section : Obj->sections()) {
+    StringRef Notes;
+    if (ELFSectionRef(Section).getType() != ELF::SHT_NOTE ||
+        Section.getContents(Notes))
+      continue;
+    // Each note is namesz, descsz and type, followed by the name and the
+    // descriptor, both padded to 4 bytes.
+    auto Read32 = [&](const char *P) {
+      return Obj->isLittleEndian() ? endian::read32le(P)
+                                   : endian::read32be(P);
+    };
+    while (Notes.size() >= 12) {
+      uint64_t NameSize = Read32(Notes.data());
+      uint64_t DescSize = Read32(Notes.data() + 4);
+      uint32_t Type = Read32(Notes.data() + 8);
+      uint64_t DescStart = 12 + alignTo(NameSize, 4);
+      uint64_t NoteSize = DescStart + alignTo(DescSize, 4);
+      if (NoteSize > Notes.size())
+        break;
+      if (Type == ELF::NT_GNU_BUILD_ID &&
+          Notes.substr(12, NameSize) == StringRef("GNU", 4))
+        return Notes.substr(DescStart, DescSize);
+      Notes = Notes.drop_front(NoteSize);
+    }
+  }
+  return StringRef();
+}
+
+/// Appends what identifies the contents of \p Obj to \p Hasher: the build ID
+/// or UUID the linker stamped it with, or else the hash of the whole object.
+static void hashObjectIdentity(MD5 &Hasher, const ObjectFile *Obj) {
+  StringRef ID;
+  if (auto *ELFObj = dyn_cast<ELFObjectFileBase>(Obj))
+    ID = getELFBuildID(ELFObj);
+  else if (auto *MachOObj = dyn_cast<MachOObjectFile>(Obj)) {
+    ArrayRef<uint8_t> UUID = MachOObj->getUuid();
+    ID = StringRef(reinterpret_cast<const char *>(UUID.data()), UUID.size());
+  }
+  if (!ID.empty()) {
+    Hasher.update("id");
+    Hasher.update(ID);
+  } else {
+    MD5 ContentHasher;
+    ContentHasher.update(Obj->getData());
+    MD5::MD5Result ContentHash;
+    ContentHasher.final(ContentHash);
+    Hasher.update("md5");
+    Hasher.update(ContentHash);
+  }
+  Hasher.update(StringRef("\0", 1));
+}
+
+Expected<std::unique_ptr<CachedSymbolizableModule>>
+CachedSymbolizableModule::create(StringRef CacheDir, const ObjectFile *Binary,
+                                 const ObjectFile *DebugObj,
+                                 LoaderTy Loader) {
+  std::unique_ptr<CachedSymbolizableModule> Cached(
+      new CachedSymbolizableModule(std::move(Loader)));
+
+  // Name the entry after the contents of the binary and of the object holding
+  // its debug info, which is a separate file for dSYM bundles and debuglinks.
+  // The same binary found under another path shares the entry, and a rebuilt
+  // binary or debug object gets a fresh one.
+  MD5 Hasher;
+  hashObjectIdentity(Hasher, Binary);
+  if (DebugObj != Binary)
+    hashObjectIdentity(Hasher, DebugObj);
+  MD5::MD5Result Hash;
+  Hasher.final(Hash);
+  SmallString<32> HashStr;
+  MD5::stringifyResult(Hash, HashStr);
+
+  SmallString<128> EntryPath(CacheDir);
+  sys::path::append(EntryPath, "llvmsym-" + HashStr);
+  Cached->EntryPath = EntryPath.str();
+  if (Cached->readEntry())
+    return std::move(Cached);
+
+  // Without an entry every query will need the real module, load it now so
+  // that errors are reported like for uncached modules.
+  return loadEagerly(std::move(Cached));
+}
+
+Expected<std::unique_ptr<CachedSymbolizableModule>>
+CachedSymbolizableModule::loadEagerly(
+    std::unique_ptr<CachedSymbolizableModule> Cached) {
+  auto ModuleOrErr = Cached->Loader();
+  if (!ModuleOrErr)
+    return ModuleOrErr.takeError();
+  Cached->Module = std::move(*ModuleOrErr);
+  Cached->Loader = nullptr;
+  Cached->IsWin32 = Cached->Module->isWin32Module();
+  Cached->PreferredBase = Cached->Module->getModulePreferredBase();
+  return std::move(Cached);
+}
+
+bool CachedSymbolizableModule::readEntry() {
+  auto EntryOrErr = MemoryBuffer::getFile(EntryPath, /*FileSize=*/-1,
+                                          /*RequiresNullTerminator=*/false);
+  if (!EntryOrErr)
+    return false;
+  StringRef Data = (*EntryOrErr)->getBuffer();
+  if (Data.size() < HeaderSize ||
+      !Data.startswith(StringRef(Magic, sizeof(Magic))))
+    return false;
+  const char *P = Data.data() + sizeof(Magic);
+  if (endian::read32le(P) != Version)
+    return false;
+  uint32_t NumResults = endian::read32le(P + 4);
+  if (Data.size() < HeaderSize + uint64_t(NumResults) * IndexEntrySize)
+    return false;
+  IsWin32 = endian::read32le(P + 8);
+  PreferredBase = endian::read64le(P + 12);
+  Entry = std::move(*EntryOrErr);
+  return true;
+}
+
+const SymbolizableModule *CachedSymbolizableModule::getModule() const {
+  if (Loader) {
+    auto ModuleOrErr = Loader();
+    if (ModuleOrErr)
+      Module = std::move(*ModuleOrErr);
+    else
+      consumeError(ModuleOrErr.takeError());
+    Loader = nullptr;
+  }
+  return Module.get();
+}
+
+bool CachedSymbolizableModule::lookup(uint64_t Address, uint32_t Key,
+                                      StringRef &Result) const {
+  auto I = NewResults.find(std::make_pair(Address, Key));
+  if (I != NewResults.end()) {
+    Result = I->second;
+    return true;
+  }
+  if (!Entry)
+    return false;
+
+  // Binary search the sorted index of the mapped entry.
+  StringRef Data = Entry->getBuffer();
+  uint32_t NumResults = endian::read32le(Data.data() + sizeof(Magic) + 4);
+  const char *Index = Data.data() + HeaderSize;
+  uint64_t ResultsStart = HeaderSize + uint64_t(NumResults) * IndexEntrySize;
+  auto Compare = [&](uint32_t N) {
+    const char *E = Index + N * IndexEntrySize;
+    uint64_t EntryAddress = endian::read64le(E);
+    if (EntryAddress != Address)
+      return EntryAddress < Address ? -1 : 1;
+    uint32_t EntryKey = endian::read32le(E + 8);
+    if (EntryKey != Key)
+      return EntryKey < Key ? -1 : 1;
+    return 0;
+  };
+  uint32_t Low = 0, High = NumResults;
+  while (Low < High) {
+    uint32_t Mid = Low + (High - Low) / 2;
+    int Cmp = Compare(Mid);
+    if (Cmp == 0) {
+      const char *E = Index + Mid * IndexEntrySize;
+      uint64_t Offset = ResultsStart + endian::read32le(E + 12);
+      uint32_t Size = endian::read32le(E + 16);
+      if (Offset + Size > Data.size())
+        return false;
+      Result = Data.substr(Offset, Size);
+      return true;
+    }
+    if (Cmp < 0)
+      Low = Mid + 1;
+    else
+      High = Mid;
+  }
+  return false;
+}
+
+DILineInfo CachedSymbolizableModule::symbolizeCode(uint64_t ModuleOffset,
+                                                   FunctionNameKind FNKind,
+                                                   bool UseSymbolTable) const {
+  uint32_t Key = getQueryKey(QK_Code, FNKind, UseSymbolTable);
+  StringRef Encoded;
+  if (lookup(ModuleOffset, Key, Encoded)) {
+    ResultReader R(Encoded);
+    DILineInfo Info = R.readLineInfo();
+    if (!R.failed())
+      return Info;
+  }
+
+  const SymbolizableModule *M = getModule();
+  if (!M)
+    return DILineInfo();
+  DILineInfo Info = M->symbolizeCode(ModuleOffset, FNKind, UseSymbolTable);
+  std::string &Result = NewResults[std::make_pair(ModuleOffset, Key)];
+  raw_string_ostream OS(Result);
+  endian::Writer<little> W(OS);
+  writeLineInfo(W, Info);
+  return Info;
+}
+
+DIInliningInfo
+CachedSymbolizableModule::symbolizeInlinedCode(uint64_t ModuleOffset,
+                                               FunctionNameKind FNKind,
+                                               bool UseSymbolTable) const {
+  uint32_t Key = getQueryKey(QK_InlinedCode, FNKind, UseSymbolTable);
+  StringRef Encoded;
+  if (lookup(ModuleOffset, Key, Encoded)) {
+    ResultReader R(Encoded);
+    DIInliningInfo InlinedContext;
+    for (uint32_t I = 0, E = R.readU32(); I != E && !R.failed(); ++I)
+      InlinedContext.addFrame(R.readLineInfo());
+    if (!R.failed())
+      return InlinedContext;
+  }
+
+  const SymbolizableModule *M = getModule();
+  if (!M)
+    return DIInliningInfo();
+  DIInliningInfo InlinedContext =
+      M->symbolizeInlinedCode(ModuleOffset, FNKind, UseSymbolTable);
+  std::string &Result = NewResults[std::make_pair(ModuleOffset, Key)];
+  raw_string_ostream OS(Result);
+  endian::Writer<little> W(OS);
+  W.write<uint32_t>(InlinedContext.getNumberOfFrames());
+  for (uint32_t I = 0, E = InlinedContext.getNumberOfFrames(); I != E; ++I)
+    writeLineInfo(W, InlinedContext.getFrame(I));
+  return InlinedContext;
+}
+
+DIGlobal CachedSymbolizableModule::symbolizeData(uint64_t ModuleOffset) const {
+  uint32_t Key = getQueryKey(QK_Data);
+  StringRef Encoded;
+  if (lookup(ModuleOffset, Key, Encoded)) {
+    ResultReader R(Encoded);
+    DIGlobal Global;
+    Global.Name = R.readString();
+    Global.Start = R.readU64();
+    Global.Size = R.readU64();
+    if (!R.failed())
+      return Global;
+  }
+
+  const SymbolizableModule *M = getModule();
+  if (!M)
+    return DIGlobal();
+  DIGlobal Global = M->symbolizeData(ModuleOffset);
+  std::string &Result = NewResults[std::make_pair(ModuleOffset, Key)];
+  raw_string_ostream OS(Result);
+  endian::Writer<little> W(OS);
+  writeString(W, Global.Name);
+  W.write<uint64_t>(Global.Start);
+  W.write<uint64_t>(Global.Size);
+  return Global;
+}
+
+std::error_code CachedSymbolizableModule::save() {
+  if (EntryPath.empty() || NewResults.empty())
+    return std::error_code();
+
+  // Merge the mapped results with the new ones, the latter are never already
+  // in the mapped entry since lookups hit it first.
+  std::map<std::pair<uint64_t, uint32_t>, StringRef> Results;
+  if (Entry) {
+    StringRef Data = Entry->getBuffer();
+    uint32_t NumResults = endian::read32le(Data.data() + sizeof(Magic) + 4);
+    uint64_t ResultsStart = HeaderSize + uint64_t(NumResults) * IndexEntrySize;
+    for (uint32_t N = 0; N != NumResults; ++N) {
+      const char *E = Data.data() + HeaderSize + N * IndexEntrySize;
+      uint64_t Offset = ResultsStart + endian::read32le(E + 12);
+      uint32_t Size = endian::read32le(E + 16);
+      if (Offset + Size > Data.size())
+        continue;
+      Results[std::make_pair(endian::read64le(E), endian::read32le(E + 8))] =
+          Data.substr(Offset, Size);
+    }
+  }
+  for (const auto &R : NewResults)
+    Results[R.first] = R.second;
+
+  // The index stores 32-bit offsets into the results.
+  uint64_t ResultsSize = 0;
+  for (const auto &R : Results)
+    ResultsSize += R.second.size();
+  if (ResultsSize > UINT32_MAX)
+    return make_error_code(errc::file_too_large);
+
+  // Write to a temporary and rename it over the entry, so that concurrent
+  // symbolizers only ever see complete entries.
+  SmallString<128> TempPath;
+  int TempFD;
+  if (std::error_code EC = sys::fs::createUniqueFile(
+          EntryPath + ".tmp%%%%%%", TempFD, TempPath))
+    return EC;
+  {
+    raw_fd_ostream OS(TempFD, /*shouldClose=*/true);
+    endian::Writer<little> W(OS);
+    OS.write(Magic, sizeof(Magic));
+    W.write<uint32_t>(Version);
+    W.write<uint32_t>(Results.size());
+    W.write<uint32_t>(IsWin32);
+    W.write<uint64_t>(PreferredBase);
+    uint32_t Offset = 0;
+    for (const auto &R : Results) {
+      W.write<uint64_t>(R.first.first);
+      W.write<uint32_t>(R.first.second);
+      W.write<uint32_t>(Offset);
+      W.write<uint32_t>(R.second.size());
+      Offset += R.second.size();
+    }
+    for (const auto &R : Results)
+      OS << R.second;
+  }
+  if (std::error_code EC = sys::fs::rename(TempPath, EntryPath)) {
+    sys::fs::remove(TempPath);
+    return EC;
+  }
+  NewResults.clear();
+  Entry.reset();
+  readEntry();
+  return std::error_code();
+}
+
+} // namespace symbolize
+} // namespace llvm
@@ -0,0 +1,94 @@
+//===-- CachedSymbolizableModule.h ------------------------------ C++ -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the CachedSymbolizableModule class, which answers
+// symbolization queries from a persistent on-disk table.
+//
+//===----------------------------------------------------------------------===//
+#ifndef LLVM_LIB_DEBUGINFO_SYMBOLIZE_CACHEDSYMBOLIZABLEMODULE_H
+#define LLVM_LIB_DEBUGINFO_SYMBOLIZE_CACHEDSYMBOLIZABLEMODULE_H
+
+#include "llvm/DebugInfo/Symbolize/SymbolizableModule.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <functional>
+#include <map>
+
+namespace llvm {
+namespace symbolize {
+
+/// A SymbolizableModule backed by a cache entry on disk.
+///
+/// The entry of a binary is named after its build ID or UUID and that of its
+/// debug object, or the hash of their contents when they have none, so a
+/// rebuilt binary gets a fresh entry. It holds a
+/// sorted table mapping (address, query kind) to the result previously
+/// computed from the debug info, and is memory mapped when the module is
+/// created. Queries hitting the table are answered without opening the binary;
+/// on a miss, the real module is created through the loader, the result is
+/// computed from it and recorded, and save() writes the merged table back.
+class CachedSymbolizableModule : public SymbolizableModule {
+public:
+  typedef std::function<Expected<std::unique_ptr<SymbolizableModule>>()>
+      LoaderTy;
+
+  /// Create the module caching the symbolization of \p Binary, whose debug
+  /// info is in \p DebugObj, in \p CacheDir. If no entry exists yet, the real
+  /// module is loaded right away and loading errors are returned.
+  static Expected<std::unique_ptr<CachedSymbolizableModule>>
+  create(StringRef CacheDir, const object::ObjectFile *Binary,
+         const object::ObjectFile *DebugObj, LoaderTy Loader);
+
+  DILineInfo symbolizeCode(uint64_t ModuleOffset, FunctionNameKind FNKind,
+                           bool UseSymbolTable) const override;
+  DIInliningInfo symbolizeInlinedCode(uint64_t ModuleOffset,
+                                      FunctionNameKind FNKind,
+                                      bool UseSymbolTable) const override;
+  DIGlobal symbolizeData(uint64_t ModuleOffset) const override;
+  bool isWin32Module() const override { return IsWin32; }
+  uint64_t getModulePreferredBase() const override { return PreferredBase; }
+
+  /// Write the cache entry back if new results were computed since it was
+  /// read. Fails with errc::file_too_large rather than write an entry whose
+  /// results exceed 4GB.
+  std::error_code save();
+
+private:
+  CachedSymbolizableModule(LoaderTy Loader) : Loader(std::move(Loader)) {}
+
+  /// Load the real module right away, returning loading errors.
+  static Expected<std::unique_ptr<CachedSymbolizableModule>>
+  loadEagerly(std::unique_ptr<CachedSymbolizableModule> Cached);
+
+  /// Map the existing entry, returns false if there is no valid one.
+  bool readEntry();
+
+  /// Returns the real module, loading it on first use. Returns null if
+  /// loading failed.
+  const SymbolizableModule *getModule() const;
+
+  /// Returns the encoded result for \p Key from the mapped table, or from the
+  /// results computed during this run.
+  bool lookup(uint64_t Address, uint32_t Key, StringRef &Result) const;
+
+  std::string EntryPath;
+  std::unique_ptr<MemoryBuffer> Entry;
+  bool IsWin32 = false;
+  uint64_t PreferredBase = 0;
+
+  mutable LoaderTy Loader;
+  mutable std::unique_ptr<SymbolizableModule> Module;
+  mutable std::map<std::pair<uint64_t, uint32_t>, std::string> NewResults;
+};
+
+} // namespace symbolize
+} // namespace llvm
+
+#endif // LLVM_LIB_DEBUGINFO_SYMBOLIZE_CACHEDSYMBOLIZABLEMODULE_H
@@ -13,6 +13,7 @@
 
 #include "llvm/DebugInfo/Symbolize/Symbolize.h"
 
+#include "CachedSymbolizableModule.h"
 #include "SymbolizableObjectFile.h"
 
 #include "llvm/ADT/STLExtras.h"
@@ -25,6 +26,7 @@
 #include "llvm/Object/MachO.h"
 #include "llvm/Object/MachOUniversal.h"
 #include "llvm/Support/COFF.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/Compression.h"
 #include "llvm/Support/DataExtractor.h"
@@ -131,11 +133,29 @@ Expected<DIGlobal> LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
   return Global;
 }
 
-void LLVMSymbolizer::flush() {
+std::error_code LLVMSymbolizer::flush() {
+  std::error_code Result;
+  if (!Opts.CachePath.empty()) {
+    // Every module is a CachedSymbolizableModule when caching is enabled.
+    for (auto &M : Modules)
+      if (M.second)
+        if (std::error_code EC =
+                static_cast<CachedSymbolizableModule *>(M.second.get())
+                    ->save())
+          if (!Result)
+            Result = EC;
+    // Only prune once the entries are known to be written.
+    if (!Result)
+      CachePruning(Opts.CachePath)
+          .setPruningInterval(Opts.CachePruningInterval)
+          .setEntryExpiration(Opts.CacheExpiration)
+          .prune();
+  }
   ObjectForUBPathAndArch.clear();
   BinaryForPath.clear();
   ObjectPairForPathArch.clear();
   Modules.clear();
+  return Result;
 }
 
 namespace {
@@ -378,11 +398,45 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
       ArchName = ArchStr;
     }
   }
+
+  Expected<std::unique_ptr<SymbolizableModule>> SymModOrErr =
+      Opts.CachePath.empty() ? createModuleInfo(BinaryName, ArchName)
+                             : createCachedModuleInfo(BinaryName, ArchName);
+  if (!SymModOrErr) {
+    Modules.insert(
+        std::make_pair(ModuleName, std::unique_ptr<SymbolizableModule>()));
+    return SymModOrErr.takeError();
+  }
+  auto InsertResult =
+      Modules.insert(std::make_pair(ModuleName, std::move(*SymModOrErr)));
+  assert(InsertResult.second);
+  return InsertResult.first->second.get();
+}
+
+Expected<std::unique_ptr<SymbolizableModule>>
+LLVMSymbolizer::createCachedModuleInfo(const std::string &BinaryName,
+                                       const std::string &ArchName) {
+  // The binary and its debug object are only mapped to identify them, their
+  // debug info is only read if the cache can't answer.
+  auto ObjectsOrErr = getOrCreateObjectPair(BinaryName, ArchName);
+  if (!ObjectsOrErr)
+    return ObjectsOrErr.takeError();
+  auto CachedOrErr = CachedSymbolizableModule::create(
+      Opts.CachePath, ObjectsOrErr->first, ObjectsOrErr->second,
+      [this, BinaryName, ArchName] {
+        return createModuleInfo(BinaryName, ArchName);
+      });
+  if (!CachedOrErr)
+    return CachedOrErr.takeError();
+  return std::move(*CachedOrErr);
+}
+
+Expected<std::unique_ptr<SymbolizableModule>>
+LLVMSymbolizer::createModuleInfo(const std::string &BinaryName,
+                                 const std::string &ArchName) {
   auto ObjectsOrErr = getOrCreateObjectPair(BinaryName, ArchName);
   if (!ObjectsOrErr) {
     // Failed to find valid object file.
-    Modules.insert(
-        std::make_pair(ModuleName, std::unique_ptr<SymbolizableModule>()));
     return ObjectsOrErr.takeError();
   }
   ObjectPair Objects = ObjectsOrErr.get();
@@ -398,11 +452,8 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
       using namespace pdb;
       std::unique_ptr<IPDBSession> Session;
       if (auto Err = loadDataForEXE(PDB_ReaderType::DIA,
-                                    Objects.first->getFileName(), Session)) {
-        Modules.insert(
-            std::make_pair(ModuleName, std::unique_ptr<SymbolizableModule>()));
+                                    Objects.first->getFileName(), Session))
         return std::move(Err);
-      }
       Context.reset(new PDBContext(*CoffObject, std::move(Session)));
     }
   }
@@ -411,15 +462,9 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
   assert(Context);
   auto InfoOrErr =
       SymbolizableObjectFile::create(Objects.first, std::move(Context));
-  std::unique_ptr<SymbolizableModule> SymMod;
-  if (InfoOrErr)
-    SymMod = std::move(InfoOrErr.get());
-  auto InsertResult =
-      Modules.insert(std::make_pair(ModuleName, std::move(SymMod)));
-  assert(InsertResult.second);
   if (auto EC = InfoOrErr.getError())
     return errorCodeToError(EC);
-  return InsertResult.first->second.get();
+  return std::move(InfoOrErr.get());
 }
 
 namespace {
@@ -69,6 +69,13 @@ template void llvm::Calculate<Function, Inverse<BasicBlock *>>(
     DominatorTreeBase<GraphTraits<Inverse<BasicBlock *>>::NodeType> &DT,
     Function &F);
 
+template void llvm::ApplyUpdates<Function, BasicBlock *>(
+    DominatorTreeBase<GraphTraits<BasicBlock *>::NodeType> &DT, Function &F,
+    ArrayRef<DominatorTreeBase<BasicBlock>::UpdateType> Updates);
+template void llvm::ApplyUpdates<Function, Inverse<BasicBlock *>>(
+    DominatorTreeBase<GraphTraits<Inverse<BasicBlock *>>::NodeType> &DT,
+    Function &F, ArrayRef<DominatorTreeBase<BasicBlock>::UpdateType> Updates);
+
 // dominates - Return true if Def dominates a use in User. This performs
 // the special checks necessary if Def and User are in the same basic block.
 // Note that Def doesn't dominate a use in Def itself!
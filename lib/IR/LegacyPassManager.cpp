@@ -23,6 +23,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/TimeValue.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
@@ -1306,6 +1307,7 @@ bool BBPassManager::runOnFunction(Function &F) {
         // If the pass crashes, remember this.
         PassManagerPrettyStackEntry X(BP, *I);
         TimeRegion PassTimer(getPassTimer(BP));
+        TimeTraceScope TraceScope(BP->getPassName(), I->getName());
 
         LocalChanged |= BP->runOnBasicBlock(*I);
       }
@@ -1522,6 +1524,7 @@ bool FPPassManager::runOnFunction(Function &F) {
     {
       PassManagerPrettyStackEntry X(FP, F);
       TimeRegion PassTimer(getPassTimer(FP));
+      TimeTraceScope TraceScope(FP->getPassName(), F.getName());
 
       LocalChanged |= FP->runOnFunction(F);
     }
@@ -1599,6 +1602,7 @@ MPPassManager::runOnModule(Module &M) {
     {
       PassManagerPrettyStackEntry X(MP, M);
       TimeRegion PassTimer(getPassTimer(MP));
+      TimeTraceScope TraceScope(MP->getPassName(), M.getModuleIdentifier());
 
       LocalChanged |= MP->runOnModule(M);
     }
@@ -42,6 +42,7 @@
 #include "llvm/Support/SHA1.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_sha1_ostream.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/FunctionImport.h"
@@ -56,6 +57,9 @@ using namespace llvm;
 
 #define DEBUG_TYPE "thinlto"
 
+STATISTIC(NumCodeGenCacheHits,
+          "Number of modules whose optimized IR was found in the cache");
+
 namespace llvm {
 // Flags -discard-value-names, defined in LTOCodeGenerator.cpp
 extern cl::opt<bool> LTODiscardValueNames;
@@ -215,6 +219,63 @@ std::unique_ptr<MemoryBuffer> codegenModule(Module &TheModule,
   return make_unique<ObjectMemoryBuffer>(std::move(OutputBuffer));
 }
 
+/// Hash every target option the generated object depends on, i.e. all of
+/// them but PrintMachineCode.
+static void hashTargetOptions(raw_ostream &Hasher,
+                              const TargetOptions &Options) {
+  std::initializer_list<unsigned> Flags = {
+      Options.LessPreciseFPMADOption,
+      Options.UnsafeFPMath,
+      Options.NoInfsFPMath,
+      Options.NoNaNsFPMath,
+      Options.HonorSignDependentRoundingFPMathOption,
+      Options.NoZerosInBSS,
+      Options.GuaranteedTailCallOpt,
+      Options.StackAlignmentOverride,
+      Options.StackSymbolOrdering,
+      Options.EnableFastISel,
+      Options.UseInitArray,
+      Options.DisableIntegratedAS,
+      Options.CompressDebugSections,
+      Options.RelaxELFRelocations,
+      Options.FunctionSections,
+      Options.DataSections,
+      Options.UniqueSectionNames,
+      Options.TrapUnreachable,
+      Options.EmulatedTLS,
+      Options.EnableIPRA,
+      unsigned(Options.FloatABIType),
+      unsigned(Options.AllowFPOpFusion),
+      unsigned(Options.JTType),
+      unsigned(Options.ThreadModel),
+      unsigned(Options.EABIVersion),
+      unsigned(Options.DebuggerTuning),
+      unsigned(Options.ExceptionModel)};
+  for (unsigned Flag : Flags)
+    Hasher << Flag << '\0';
+  Options.Reciprocals.print(Hasher);
+  Hasher << '\0';
+
+  const MCTargetOptions &MCOptions = Options.MCOptions;
+  std::initializer_list<unsigned> MCFlags = {
+      MCOptions.SanitizeAddress,
+      MCOptions.MCRelaxAll,
+      MCOptions.MCNoExecStack,
+      MCOptions.MCFatalWarnings,
+      MCOptions.MCNoWarn,
+      MCOptions.MCSaveTempLabels,
+      MCOptions.MCUseDwarfDirectory,
+      MCOptions.MCIncrementalLinkerCompatible,
+      MCOptions.ShowMCEncoding,
+      MCOptions.ShowMCInst,
+      MCOptions.AsmVerbose,
+      MCOptions.PreserveAsmComments,
+      unsigned(MCOptions.DwarfVersion)};
+  for (unsigned Flag : MCFlags)
+    Hasher << Flag << '\0';
+  Hasher << MCOptions.ABIName << '\0';
+}
+
 /// Manage caching for a single Module.
 class ModuleCacheEntry {
   SmallString<128> EntryPath;
@@ -229,14 +290,16 @@ public:
       const FunctionImporter::ExportSetTy &ExportList,
       const std::map<GlobalValue::GUID, GlobalValue::LinkageTypes> &ResolvedODR,
       const GVSummaryMapTy &DefinedFunctions,
-      const DenseSet<GlobalValue::GUID> &PreservedSymbols) {
+      const DenseSet<GlobalValue::GUID> &PreservedSymbols,
+      const TargetMachineBuilder &TMBuilder) {
     if (CachePath.empty())
       return;
 
     // Compute the unique hash for this entry
     // This is based on the current compiler version, the module itself, the
     // export list, the hash for every single module in the import list, the
-    // list of ResolvedODR for the module, and the list of preserved symbols.
+    // list of ResolvedODR for the module, the list of preserved symbols, and
+    // the target configuration.
 
     SHA1 Hasher;
 
@@ -274,9 +337,47 @@ public:
             ArrayRef<uint8_t>((const uint8_t *)&Entry, sizeof(GlobalValue::GUID)));
     }
 
+    // Include the target configuration.
+    SmallString<256> TargetConfig;
+    raw_svector_ostream OS(TargetConfig);
+    OS << TMBuilder.TheTriple.str() << '\0' << TMBuilder.MCpu << '\0'
+       << TMBuilder.MAttr << '\0'
+       << (TMBuilder.RelocModel ? int(*TMBuilder.RelocModel) : -1) << '\0'
+       << unsigned(TMBuilder.CGOptLevel) << '\0';
+    hashTargetOptions(OS, TMBuilder.Options);
+    Hasher.update(TargetConfig);
+
     sys::path::append(EntryPath, CachePath, toHex(Hasher.result()));
   }
 
+  // Create a cache entry for the code generated from an optimized module. The
+  // hash covers the optimized IR itself and the target configuration, so that
+  // inputs which changed but optimize to the same IR (e.g. an edit to a
+  // function that isn't imported nor inlined anywhere in this module) reuse
+  // the object file instead of running codegen again.
+  ModuleCacheEntry(StringRef CachePath, const Module &OptimizedModule,
+                   const TargetMachine &TM) {
+    if (CachePath.empty())
+      return;
+
+    raw_sha1_ostream Hasher;
+    Hasher << "codegen" << '\0' << LLVM_VERSION_STRING << '\0';
+#ifdef HAVE_LLVM_REVISION
+    Hasher << LLVM_REVISION << '\0';
+#endif
+    Hasher << TM.getTargetTriple().str() << '\0' << TM.getTargetCPU() << '\0'
+           << TM.getTargetFeatureString() << '\0'
+           << unsigned(TM.getRelocationModel()) << '\0'
+           << unsigned(TM.getCodeModel()) << '\0' << unsigned(TM.getOptLevel())
+           << '\0';
+    hashTargetOptions(Hasher, TM.Options);
+    // Bitcode is a stable serialization of the IR, stream it into the hash
+    // rather than into a buffer.
+    WriteBitcodeToFile(&OptimizedModule, Hasher);
+
+    sys::path::append(EntryPath, CachePath, toHex(Hasher.sha1()));
+  }
+
   // Access the path to this entry in the cache.
   StringRef getEntryPath() { return EntryPath; }
 
@@ -383,7 +484,21 @@ ProcessThinLTOModule(Module &TheModule, ModuleSummaryIndex &Index,
     return make_unique<ObjectMemoryBuffer>(std::move(OutputBuffer));
   }
 
-  return codegenModule(TheModule, TM);
+  // The optimized module may be identical to one we already generated code
+  // for, even though the input module or its imports changed.
+  ModuleCacheEntry CodeGenCacheEntry(CacheOptions.Path, TheModule, TM);
+  {
+    auto ErrOrBuffer = CodeGenCacheEntry.tryLoadingBuffer();
+    DEBUG(dbgs() << "CodeGen cache " << (ErrOrBuffer ? "hit" : "miss") << " '"
+                 << CodeGenCacheEntry.getEntryPath() << "' for buffer " << count
+                 << "\n");
+    if (ErrOrBuffer) {
+      ++NumCodeGenCacheHits;
+      return std::move(ErrOrBuffer.get());
+    }
+  }
+
+  return CodeGenCacheEntry.write(codegenModule(TheModule, TM));
 }
 
 /// Resolve LinkOnce/Weak symbols. Record resolutions in the \p ResolvedODR map
@@ -669,7 +784,7 @@ std::unique_ptr<MemoryBuffer> ThinLTOCodeGenerator::codegen(Module &TheModule) {
 void ThinLTOCodeGenerator::run() {
   if (CodeGenOnly) {
     // Perform only parallel codegen and return.
-    ThreadPool Pool;
+    ThreadPool Pool(ThreadCount);
     assert(ProducedBinaries.empty() && "The generator should not be reused");
     ProducedBinaries.resize(Modules.size());
     int count = 0;
@@ -784,7 +899,8 @@ void ThinLTOCodeGenerator::run() {
         ModuleCacheEntry CacheEntry(CacheOptions.Path, *Index, ModuleIdentifier,
                                     ImportLists[ModuleIdentifier], ExportList,
                                     ResolvedODR[ModuleIdentifier],
-                                    DefinedFunctions, GUIDPreservedSymbols);
+                                    DefinedFunctions, GUIDPreservedSymbols,
+                                    TMBuilder);
 
         {
           auto ErrOrBuffer = CacheEntry.tryLoadingBuffer();
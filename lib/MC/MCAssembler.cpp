@@ -55,6 +55,9 @@ STATISTIC(FragmentLayouts, "Number of fragment layouts");
 STATISTIC(ObjectBytes, "Number of emitted object file bytes");
 STATISTIC(RelaxationSteps, "Number of assembler layout and relaxation steps");
 STATISTIC(RelaxedInstructions, "Number of relaxed instructions");
+STATISTIC(SkippedRelaxationChecks,
+          "Number of relaxation checks skipped because nothing they depend "
+          "on changed");
 }
 }
 
@@ -847,7 +850,73 @@ bool MCAssembler::relaxCVDefRange(MCAsmLayout &Layout,
   return OldSize != F.getContents().size();
 }
 
-bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec) {
+/// Raise \p MaxOrder to the highest layout order of the fragments of \p Sec
+/// the value of \p Expr depends on. Returns false if that can't be determined.
+static bool getDependencyOrder(const MCExpr &Expr, const MCSection &Sec,
+                               unsigned &MaxOrder) {
+  switch (Expr.getKind()) {
+  case MCExpr::Constant:
+    return true;
+  case MCExpr::Unary:
+    return getDependencyOrder(*cast<MCUnaryExpr>(Expr).getSubExpr(), Sec,
+                              MaxOrder);
+  case MCExpr::Binary: {
+    const MCBinaryExpr &BE = cast<MCBinaryExpr>(Expr);
+    return getDependencyOrder(*BE.getLHS(), Sec, MaxOrder) &&
+           getDependencyOrder(*BE.getRHS(), Sec, MaxOrder);
+  }
+  case MCExpr::SymbolRef: {
+    const MCSymbol &Sym = cast<MCSymbolRefExpr>(Expr).getSymbol();
+    if (Sym.isVariable())
+      return false;
+    // Offsets are relative to the section, the fragments of other sections
+    // don't move while this one is laid out.
+    const MCFragment *F = Sym.getFragment(/*SetUsed=*/false);
+    if (F && F->getParent() == &Sec)
+      MaxOrder = std::max(MaxOrder, F->getLayoutOrder());
+    return true;
+  }
+  case MCExpr::Target:
+    return false;
+  }
+  llvm_unreachable("Invalid assembly expression kind!");
+}
+
+/// Return the highest layout order of the fragments of its section whose
+/// offsets decide whether \p F needs relaxing, ~0U if unknown.
+static unsigned getDependencyOrder(const MCFragment &F) {
+  const MCSection &Sec = *F.getParent();
+  unsigned MaxOrder = F.getLayoutOrder();
+  bool Known;
+  switch (F.getKind()) {
+  case MCFragment::FT_Relaxable:
+    Known = true;
+    for (const MCFixup &Fixup : cast<MCRelaxableFragment>(F).getFixups())
+      Known &= getDependencyOrder(*Fixup.getValue(), Sec, MaxOrder);
+    break;
+  case MCFragment::FT_Dwarf:
+    Known = getDependencyOrder(cast<MCDwarfLineAddrFragment>(F).getAddrDelta(),
+                               Sec, MaxOrder);
+    break;
+  case MCFragment::FT_DwarfFrame:
+    Known = getDependencyOrder(
+        cast<MCDwarfCallFrameFragment>(F).getAddrDelta(), Sec, MaxOrder);
+    break;
+  case MCFragment::FT_LEB:
+    Known = getDependencyOrder(cast<MCLEBFragment>(F).getValue(), Sec,
+                               MaxOrder);
+    break;
+  default:
+    Known = false;
+    break;
+  }
+  return Known ? MaxOrder : ~0U;
+}
+
+MCFragment *
+MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec,
+                               unsigned StableOrder,
+                               std::vector<unsigned> &DependencyOrders) {
   // Holds the first fragment which needed relaxing during this layout. It will
   // remain NULL if none were relaxed.
   // When a fragment is relaxed, all the fragments following it should get
@@ -856,6 +925,19 @@ bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec) {
 
   // Attempt to relax all the fragments in the section.
   for (MCSection::iterator I = Sec.begin(), IE = Sec.end(); I != IE; ++I) {
+    // A fragment that only depends on fragments which didn't move since the
+    // previous iteration was found not to need relaxing by that iteration, and
+    // still doesn't.
+    if (I->getLayoutOrder() < StableOrder) {
+      if (DependencyOrders.empty())
+        for (const MCFragment &F : Sec)
+          DependencyOrders.push_back(getDependencyOrder(F));
+      if (DependencyOrders[I->getLayoutOrder()] < StableOrder) {
+        ++stats::SkippedRelaxationChecks;
+        continue;
+      }
+    }
+
     // Check if this is a fragment that needs relaxation.
     bool RelaxedFrag = false;
     switch(I->getKind()) {
@@ -889,11 +971,9 @@ bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec) {
     if (RelaxedFrag && !FirstRelaxedFragment)
       FirstRelaxedFragment = &*I;
   }
-  if (FirstRelaxedFragment) {
+  if (FirstRelaxedFragment)
     Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
-    return true;
-  }
-  return false;
+  return FirstRelaxedFragment;
 }
 
 bool MCAssembler::layoutOnce(MCAsmLayout &Layout) {
@@ -902,8 +982,16 @@ bool MCAssembler::layoutOnce(MCAsmLayout &Layout) {
   bool WasRelaxed = false;
   for (iterator it = begin(), ie = end(); it != ie; ++it) {
     MCSection &Sec = *it;
-    while (layoutSectionOnce(Layout, Sec))
+    // Only the fragments following the first one relaxed by an iteration can
+    // move, the next iteration only reconsiders the fragments depending on
+    // them.
+    unsigned StableOrder = 0;
+    std::vector<unsigned> DependencyOrders;
+    while (MCFragment *Relaxed =
+               layoutSectionOnce(Layout, Sec, StableOrder, DependencyOrders)) {
       WasRelaxed = true;
+      StableOrder = Relaxed->getLayoutOrder();
+    }
   }
 
   return WasRelaxed;
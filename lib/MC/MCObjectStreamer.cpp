@@ -19,11 +19,18 @@
 #include "llvm/MC/MCObjectWriter.h"
 #include "llvm/MC/MCSection.h"
 #include "llvm/MC/MCSymbol.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
 using namespace llvm;
 
+static cl::opt<unsigned> EncodingThreads(
+    "mc-encoding-threads", cl::Hidden, cl::init(1),
+    cl::desc("Number of threads encoding the instructions that may need "
+             "relaxation, once the object file is complete"));
+
 MCObjectStreamer::MCObjectStreamer(MCContext &Context, MCAsmBackend &TAB,
                                    raw_pwrite_stream &OS,
                                    MCCodeEmitter *Emitter_)
@@ -75,6 +82,7 @@ void MCObjectStreamer::reset() {
   EmitEHFrame = true;
   EmitDebugFrame = false;
   PendingLabels.clear();
+  DeferredEncodings.clear();
   MCStreamer::reset();
 }
 
@@ -263,6 +271,15 @@ void MCObjectStreamer::EmitInstruction(const MCInst &Inst,
   EmitInstToFragment(Inst, STI);
 }
 
+static void encodeInstToFragment(const MCCodeEmitter &Emitter,
+                                 MCRelaxableFragment &IF) {
+  SmallString<128> Code;
+  raw_svector_ostream VecOS(Code);
+  Emitter.encodeInstruction(IF.getInst(), VecOS, IF.getFixups(),
+                            IF.getSubtargetInfo());
+  IF.getContents().append(Code.begin(), Code.end());
+}
+
 void MCObjectStreamer::EmitInstToFragment(const MCInst &Inst,
                                           const MCSubtargetInfo &STI) {
   if (getAssembler().getRelaxAll() && getAssembler().isBundlingEnabled())
@@ -273,11 +290,46 @@ void MCObjectStreamer::EmitInstToFragment(const MCInst &Inst,
   MCRelaxableFragment *IF = new MCRelaxableFragment(Inst, STI);
   insert(IF);
 
-  SmallString<128> Code;
-  raw_svector_ostream VecOS(Code);
-  getAssembler().getEmitter().encodeInstruction(Inst, VecOS, IF->getFixups(),
-                                                STI);
-  IF->getContents().append(Code.begin(), Code.end());
+  // Nothing depends on the encoding of a relaxable fragment until layout, and
+  // labels can't point inside it, so its encoding can be deferred to
+  // FinishImpl and done there concurrently with the others.
+  if (EncodingThreads > 1 && !getAssembler().isBundlingEnabled() &&
+      getAssembler().getEmitter().supportsConcurrentEncoding()) {
+    DeferredEncodings.push_back(IF);
+    return;
+  }
+
+  encodeInstToFragment(getAssembler().getEmitter(), *IF);
+  finishInstFragment(*IF);
+}
+
+void MCObjectStreamer::encodeDeferredInstructions() {
+  if (DeferredEncodings.empty())
+    return;
+
+  // Each thread encodes a contiguous range of fragments into their own
+  // contents and fixups, so the result doesn't depend on the schedule.
+  const MCCodeEmitter &Emitter = getAssembler().getEmitter();
+  size_t NumFragments = DeferredEncodings.size();
+  unsigned NumThreads = std::min<size_t>(EncodingThreads, NumFragments);
+  size_t ChunkSize = (NumFragments + NumThreads - 1) / NumThreads;
+  getContext().setConcurrentAllocation(true);
+  {
+    ThreadPool Pool(NumThreads);
+    for (size_t Begin = 0; Begin < NumFragments; Begin += ChunkSize) {
+      size_t End = std::min(Begin + ChunkSize, NumFragments);
+      Pool.async([&, Begin, End] {
+        for (size_t I = Begin; I != End; ++I)
+          encodeInstToFragment(Emitter, *DeferredEncodings[I]);
+      });
+    }
+    Pool.wait();
+  }
+  getContext().setConcurrentAllocation(false);
+
+  for (MCRelaxableFragment *IF : DeferredEncodings)
+    finishInstFragment(*IF);
+  DeferredEncodings.clear();
 }
 
 #ifndef NDEBUG
@@ -535,6 +587,8 @@ void MCObjectStreamer::emitFill(const MCExpr &NumValues, int64_t Size,
 }
 
 void MCObjectStreamer::FinishImpl() {
+  encodeDeferredInstructions();
+
   // If we are generating dwarf for assembly source files dump out the sections.
   if (getContext().getGenDwarfForAssembly())
     MCGenDwarfInfo::Emit(this);
@@ -678,19 +678,24 @@ uint32_t Archive::getNumberOfSymbols() const {
 }
 
 Expected<Optional<Archive::Child>> Archive::findSym(StringRef name) const {
-  Archive::symbol_iterator bs = symbol_begin();
-  Archive::symbol_iterator es = symbol_end();
-
-  for (; bs != es; ++bs) {
-    StringRef SymName = bs->getName();
-    if (SymName == name) {
-      if (auto MemberOrErr = bs->getMember())
-        return Child(*MemberOrErr);
-      else
-        return errorCodeToError(MemberOrErr.getError());
-    }
-  }
-  return Optional<Child>();
+  // Index the symbol table on first use: linkers probe archives for every
+  // undefined symbol, which would otherwise scan the whole table each time.
+  std::call_once(SymbolMapOnce, [this] {
+    SymbolMap.reserve(getNumberOfSymbols());
+    for (Archive::symbol_iterator bs = symbol_begin(), es = symbol_end();
+         bs != es; ++bs)
+      SymbolMap.insert(std::make_pair(
+          bs->getName(), std::make_pair(bs->SymbolIndex, bs->StringIndex)));
+  });
+
+  auto I = SymbolMap.find(name);
+  if (I == SymbolMap.end())
+    return Optional<Child>();
+  Symbol Sym(this, I->second.first, I->second.second);
+  if (auto MemberOrErr = Sym.getMember())
+    return Child(*MemberOrErr);
+  else
+    return errorCodeToError(MemberOrErr.getError());
 }
 
 bool Archive::hasSymbolTable() const { return !SymbolTable.empty(); }
@@ -0,0 +1,310 @@
+//===- ParallelFunctionPipeline.cpp - Concurrent function pipelines -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+///
+/// This file implements the module pass running a function pipeline
+/// concurrently on the functions of a module.
+///
+//===----------------------------------------------------------------------===//
+
+#include "ParallelFunctionPipeline.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Linker/IRMover.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <algorithm>
+
+using namespace llvm;
+
+/// Returns true if \p M can be split into partitions optimized in their own
+/// context and merged back.
+static bool canSplitModule(const Module &M) {
+  // The debug info metadata of the partitions would be duplicated by the
+  // merge, and ifuncs aren't handled by module cloning.
+  if (M.getNamedMetadata("llvm.dbg.cu") || !M.ifunc_empty())
+    return false;
+  // Deleting the original bodies would break blockaddress constants.
+  for (const Function &F : M)
+    for (const BasicBlock &BB : F)
+      if (BB.hasAddressTaken())
+        return false;
+  return true;
+}
+
+/// Call \p Fn on every global value of \p M.
+static void forEachGlobalValue(Module &M,
+                               function_ref<void(GlobalValue &)> Fn) {
+  for (Function &F : M)
+    Fn(F);
+  for (GlobalVariable &GV : M.globals())
+    Fn(GV);
+  for (GlobalAlias &GA : M.aliases())
+    Fn(GA);
+}
+
+/// Assign the function definitions \p Defs to \p NumPartitions partitions of
+/// roughly equal size, biggest functions first.
+static DenseMap<const Function *, unsigned>
+partitionFunctions(ArrayRef<Function *> Defs, unsigned NumPartitions) {
+  std::vector<std::pair<size_t, const Function *>> BySize;
+  for (const Function *F : Defs) {
+    size_t Size = 0;
+    for (const BasicBlock &BB : *F)
+      Size += BB.size();
+    BySize.push_back(std::make_pair(Size, F));
+  }
+  std::stable_sort(BySize.begin(), BySize.end(),
+                   [](const std::pair<size_t, const Function *> &LHS,
+                      const std::pair<size_t, const Function *> &RHS) {
+                     return LHS.first > RHS.first;
+                   });
+
+  DenseMap<const Function *, unsigned> PartitionOf;
+  std::vector<size_t> PartitionSize(NumPartitions);
+  for (const auto &Entry : BySize) {
+    unsigned Smallest =
+        std::min_element(PartitionSize.begin(), PartitionSize.end()) -
+        PartitionSize.begin();
+    PartitionSize[Smallest] += Entry.first;
+    PartitionOf[Entry.second] = Smallest;
+  }
+  return PartitionOf;
+}
+
+/// Optimize the partition in the bitcode \p Input in a context of its own and
+/// write the result to \p Output.
+static void optimizePartition(StringRef Input, SmallVectorImpl<char> &Output,
+                              TargetMachine *TM, StringRef PipelineText,
+                              StringRef AAPipelineText, bool VerifyEachPass,
+                              bool DebugLogging) {
+  LLVMContext Ctx;
+  ErrorOr<std::unique_ptr<Module>> MOrErr = parseBitcodeFile(
+      MemoryBufferRef(Input, "<function-partition>"), Ctx);
+  if (!MOrErr)
+    report_fatal_error("Failed to read function partition");
+  Module &M = **MOrErr;
+
+  // Both pipelines were already parsed successfully in the original context.
+  PassBuilder PB(TM);
+  AAManager AA;
+  if (!PB.parseAAPipeline(AA, AAPipelineText))
+    llvm_unreachable("Unable to parse AA pipeline");
+
+  LoopAnalysisManager LAM(DebugLogging);
+  FunctionAnalysisManager FAM(DebugLogging);
+  CGSCCAnalysisManager CGAM(DebugLogging);
+  ModuleAnalysisManager MAM(DebugLogging);
+  FAM.registerPass([&] { return std::move(AA); });
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  ModulePassManager MPM(DebugLogging);
+  if (!PB.parsePassPipeline(MPM, ("function(" + PipelineText + ")").str(),
+                            VerifyEachPass, DebugLogging))
+    llvm_unreachable("Unable to parse function pipeline");
+  MPM.run(M, MAM);
+
+  // Only the function bodies are merged back, drop the module level state the
+  // merge would otherwise duplicate.
+  while (!M.named_metadata_empty())
+    M.eraseNamedMetadata(&*M.named_metadata_begin());
+  M.setModuleInlineAsm("");
+
+  raw_svector_ostream OS(Output);
+  WriteBitcodeToFile(&M, OS);
+}
+
+/// Carry the changes the function pipeline of \p Partition made to its copies
+/// of the global variables over to the variables of \p M. Function passes only
+/// ever raise the alignment of the variables they access, as instcombine does
+/// to match the alignment of the loads and stores it rewrites, and the
+/// rewritten accesses rely on it.
+static void mergeGlobalVariables(Module &M, const Module &Partition) {
+  for (const GlobalVariable &PGV : Partition.globals()) {
+    GlobalVariable *GV = M.getGlobalVariable(PGV.getName(), true);
+    if (GV && PGV.getAlignment() > GV->getAlignment())
+      GV->setAlignment(PGV.getAlignment());
+  }
+}
+
+/// Sort \p List, a list of globals of \p M, by the position of their name in
+/// \p Order. Globals created since \p Order was recorded are kept last.
+template <typename GlobalListTy>
+static void restoreOrder(Module &M, GlobalListTy &List,
+                         ArrayRef<std::string> Order) {
+  typedef typename GlobalListTy::value_type GlobalTy;
+  DenseMap<const GlobalValue *, unsigned> Position;
+  for (unsigned I = 0, E = Order.size(); I != E; ++I)
+    Position[M.getNamedValue(Order[I])] = I;
+  auto getPosition = [&](const GlobalValue *GV) {
+    auto It = Position.find(GV);
+    return It == Position.end() ? Order.size() : It->second;
+  };
+
+  std::vector<GlobalTy *> Globals;
+  for (GlobalTy &GV : List)
+    Globals.push_back(&GV);
+  std::stable_sort(Globals.begin(), Globals.end(),
+                   [&](const GlobalTy *LHS, const GlobalTy *RHS) {
+                     return getPosition(LHS) < getPosition(RHS);
+                   });
+  for (GlobalTy *GV : Globals)
+    List.splice(List.end(), List, GV->getIterator());
+}
+
+PreservedAnalyses ParallelFunctionPipelinePass::run(Module &M,
+                                                    ModuleAnalysisManager &AM) {
+  std::vector<Function *> Defs;
+  for (Function &F : M)
+    if (!F.isDeclaration())
+      Defs.push_back(&F);
+  if (Defs.size() < 2 || !canSplitModule(M))
+    return SerialPipeline.run(M, AM);
+
+  unsigned NumPartitions = std::min<size_t>(ThreadCount, Defs.size());
+  DenseMap<const Function *, unsigned> PartitionOf =
+      partitionFunctions(Defs, NumPartitions);
+
+  // The partitions are merged back by name, and the merge only resolves
+  // references to non-local values, so name every global and temporarily
+  // give the local ones external linkage. Remember how to undo this, and the
+  // order of the globals, which the merge doesn't preserve.
+  struct LocalValue {
+    GlobalValue::LinkageTypes Linkage;
+    GlobalValue::VisibilityTypes Visibility;
+  };
+  StringMap<LocalValue> Locals;
+  std::vector<std::string> Unnamed, FunctionOrder, VariableOrder;
+  forEachGlobalValue(M, [&](GlobalValue &GV) {
+    if (!GV.hasName()) {
+      GV.setName("__llvm_unnamed");
+      Unnamed.push_back(GV.getName());
+    }
+    if (GV.hasLocalLinkage())
+      Locals[GV.getName()] = {GV.getLinkage(), GV.getVisibility()};
+  });
+  for (const Function &F : M)
+    FunctionOrder.push_back(F.getName());
+  for (const GlobalVariable &GV : M.globals())
+    VariableOrder.push_back(GV.getName());
+
+  // Clone the partitions, each with the definitions of its functions and of
+  // every global variable, so that loads of constants still fold. Aliases
+  // must point to definitions, and calls through them should still resolve,
+  // so every partition also gets the aliases and a copy of the functions they
+  // point to. Only the copy of the partition owning such a function is merged
+  // back. Like for parallel code generation, the clones are moved to their
+  // own context through bitcode, written here on the main thread to avoid
+  // data races.
+  SmallPtrSet<const GlobalObject *, 8> AliasedObjects;
+  for (const GlobalAlias &GA : M.aliases())
+    if (const GlobalObject *Base = GA.getBaseObject())
+      AliasedObjects.insert(Base);
+  std::vector<SmallString<0>> Inputs(NumPartitions);
+  for (unsigned P = 0; P != NumPartitions; ++P) {
+    ValueToValueMapTy VMap;
+    std::unique_ptr<Module> Partition =
+        CloneModule(&M, VMap, [&](const GlobalValue *GV) {
+          if (const Function *F = dyn_cast<Function>(GV))
+            return PartitionOf.lookup(F) == P || AliasedObjects.count(F);
+          return isa<GlobalVariable>(GV) || isa<GlobalAlias>(GV);
+        });
+    forEachGlobalValue(*Partition, [](GlobalValue &GV) {
+      if (auto *GO = dyn_cast<GlobalObject>(&GV))
+        if (GO->isDeclaration())
+          GO->setComdat(nullptr);
+    });
+    raw_svector_ostream OS(Inputs[P]);
+    WriteBitcodeToFile(Partition.get(), OS);
+  }
+
+  for (Function *F : Defs)
+    F->deleteBody();
+  forEachGlobalValue(M, [](GlobalValue &GV) {
+    if (GV.hasLocalLinkage())
+      GV.setLinkage(GlobalValue::ExternalLinkage);
+  });
+
+  // Each thread gets its own target machine, created here as well.
+  std::vector<std::unique_ptr<TargetMachine>> TMs(NumPartitions);
+  if (TM)
+    for (auto &PartitionTM : TMs)
+      PartitionTM.reset(TM->getTarget().createTargetMachine(
+          TM->getTargetTriple().str(), TM->getTargetCPU(),
+          TM->getTargetFeatureString(), TM->Options, TM->getRelocationModel(),
+          TM->getCodeModel(), TM->getOptLevel()));
+
+  // The pass managers log to dbgs(), which isn't synchronized, so partitions
+  // whose pipelines log are optimized one at a time.
+  std::vector<SmallString<0>> Outputs(NumPartitions);
+  {
+    ThreadPool Pool(DebugLogging ? 1 : NumPartitions);
+    for (unsigned P = 0; P != NumPartitions; ++P)
+      Pool.async([&, P] {
+        optimizePartition(Inputs[P], Outputs[P], TMs[P].get(), PipelineText,
+                          AAPipelineText, VerifyEachPass, DebugLogging);
+      });
+    Pool.wait();
+  }
+
+  // Move the optimized bodies back, replacing the declarations left in place
+  // of the original ones, along with the alignment they need of the variables.
+  IRMover Mover(M);
+  for (unsigned P = 0; P != NumPartitions; ++P) {
+    ErrorOr<std::unique_ptr<Module>> MOrErr = parseBitcodeFile(
+        MemoryBufferRef(Outputs[P], "<function-partition>"), M.getContext());
+    if (!MOrErr)
+      report_fatal_error("Failed to read optimized function partition");
+    std::unique_ptr<Module> Partition = std::move(*MOrErr);
+    mergeGlobalVariables(M, *Partition);
+
+    // Locals created by the pipeline, such as new constant pools, are linked
+    // in with their users under a fresh name.
+    std::vector<GlobalValue *> ValuesToLink;
+    forEachGlobalValue(*Partition, [&](GlobalValue &GV) {
+      if (GV.hasLocalLinkage() && Locals.count(GV.getName()))
+        GV.setLinkage(GlobalValue::ExternalLinkage);
+    });
+    for (Function &F : *Partition)
+      if (!F.isDeclaration() &&
+          PartitionOf.lookup(M.getFunction(F.getName())) == P)
+        ValuesToLink.push_back(&F);
+    if (Error E = Mover.move(std::move(Partition), ValuesToLink,
+                             [](GlobalValue &, IRMover::ValueAdder) {}))
+      report_fatal_error(toString(std::move(E)));
+  }
+
+  for (const auto &Local : Locals) {
+    GlobalValue *GV = M.getNamedValue(Local.getKey());
+    GV->setLinkage(Local.getValue().Linkage);
+    GV->setVisibility(Local.getValue().Visibility);
+  }
+
+  // The merged functions were appended, restore the original order.
+  restoreOrder(M, M.getFunctionList(), FunctionOrder);
+  restoreOrder(M, M.getGlobalList(), VariableOrder);
+
+  for (const std::string &Name : Unnamed)
+    M.getNamedValue(Name)->setName("");
+
+  return PreservedAnalyses::none();
+}
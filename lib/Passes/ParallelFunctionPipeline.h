@@ -0,0 +1,63 @@
+//===- ParallelFunctionPipeline.h - Concurrent function pipelines -*- C++ -*-=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+///
+/// This file declares the module pass the PassBuilder uses to run a function
+/// pipeline concurrently on the functions of a module.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIB_PASSES_PARALLELFUNCTIONPIPELINE_H
+#define LLVM_LIB_PASSES_PARALLELFUNCTIONPIPELINE_H
+
+#include "llvm/IR/PassManager.h"
+#include <string>
+
+namespace llvm {
+class TargetMachine;
+
+/// \brief Runs a function pipeline on the functions of a module concurrently.
+///
+/// The uniqued state of an LLVMContext (constants, types, metadata and the use
+/// lists of globals) can't be shared between threads, so, as for parallel
+/// code generation, the functions are split into balanced partitions which
+/// are cloned into their own context and optimized there, each on its own
+/// thread, by a pipeline rebuilt from its textual description. The optimized
+/// bodies are then moved back into the module, preserving the linkage, names
+/// and order of its globals.
+///
+/// Modules for which this split is unsafe or useless (fewer than two function
+/// definitions, debug info, ifuncs or blockaddress constants) are optimized
+/// serially by the equivalent in-context pipeline.
+class ParallelFunctionPipelinePass
+    : public PassInfoMixin<ParallelFunctionPipelinePass> {
+public:
+  ParallelFunctionPipelinePass(
+      ModuleToFunctionPassAdaptor<FunctionPassManager> SerialPipeline,
+      StringRef PipelineText, StringRef AAPipelineText, unsigned ThreadCount,
+      TargetMachine *TM, bool VerifyEachPass, bool DebugLogging)
+      : SerialPipeline(std::move(SerialPipeline)), PipelineText(PipelineText),
+        AAPipelineText(AAPipelineText), ThreadCount(ThreadCount), TM(TM),
+        VerifyEachPass(VerifyEachPass), DebugLogging(DebugLogging) {}
+
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+
+private:
+  ModuleToFunctionPassAdaptor<FunctionPassManager> SerialPipeline;
+  std::string PipelineText;
+  std::string AAPipelineText;
+  unsigned ThreadCount;
+  TargetMachine *TM;
+  bool VerifyEachPass;
+  bool DebugLogging;
+};
+
+} // End llvm namespace
+
+#endif
@@ -16,6 +16,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Passes/PassBuilder.h"
+#include "ParallelFunctionPipeline.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/AliasAnalysisEvaluator.h"
@@ -658,15 +659,18 @@ bool PassBuilder::parseModulePassPipeline(ModulePassManager &MPM,
 
       // Parse the inner pipeline inte the nested manager.
       PipelineText = PipelineText.substr(strlen("function("));
+      StringRef InnerPipelineText = PipelineText;
       if (!parseFunctionPassPipeline(NestedFPM, PipelineText, VerifyEachPass,
                                      DebugLogging) ||
           PipelineText.empty())
         return false;
       assert(PipelineText[0] == ')');
+      InnerPipelineText = InnerPipelineText.drop_back(PipelineText.size());
       PipelineText = PipelineText.substr(1);
 
       // Add the nested pass manager with the appropriate adaptor.
-      MPM.addPass(createModuleToFunctionPassAdaptor(std::move(NestedFPM)));
+      addFunctionPipeline(MPM, std::move(NestedFPM), InnerPipelineText,
+                          VerifyEachPass, DebugLogging);
     } else {
       // Otherwise try to parse a pass name.
       size_t End = PipelineText.find_first_of(",)");
@@ -686,6 +690,20 @@ bool PassBuilder::parseModulePassPipeline(ModulePassManager &MPM,
   }
 }
 
+void PassBuilder::addFunctionPipeline(ModulePassManager &MPM,
+                                      FunctionPassManager FPM,
+                                      StringRef PipelineText,
+                                      bool VerifyEachPass, bool DebugLogging) {
+  if (FunctionPipelineThreads <= 1) {
+    MPM.addPass(createModuleToFunctionPassAdaptor(std::move(FPM)));
+    return;
+  }
+  MPM.addPass(ParallelFunctionPipelinePass(
+      createModuleToFunctionPassAdaptor(std::move(FPM)), PipelineText,
+      FunctionPipelineAAText, FunctionPipelineThreads, TM, VerifyEachPass,
+      DebugLogging));
+}
+
 // Primary pass pipeline description parsing routine.
 // FIXME: Should this routine accept a TargetMachine or require the caller to
 // pre-populate the analysis managers with target-specific stuff?
@@ -722,11 +740,13 @@ bool PassBuilder::parsePassPipeline(ModulePassManager &MPM,
   // a Function pipelien.
   if (PipelineText.startswith("function(") || isFunctionPassName(FirstName)) {
     FunctionPassManager FPM(DebugLogging);
+    StringRef FunctionPipelineText = PipelineText;
     if (!parseFunctionPassPipeline(FPM, PipelineText, VerifyEachPass,
                                    DebugLogging) ||
         !PipelineText.empty())
       return false;
-    MPM.addPass(createModuleToFunctionPassAdaptor(std::move(FPM)));
+    addFunctionPipeline(MPM, std::move(FPM), FunctionPipelineText,
+                        VerifyEachPass, DebugLogging);
     return true;
   }
 
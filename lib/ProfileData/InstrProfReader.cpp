@@ -477,6 +477,68 @@ bool InstrProfLookupTrait::readValueProfilingData(
   return true;
 }
 
+bool InstrProfLookupTrait::skipValueProfilingData(
+    const unsigned char *&D, const unsigned char *const End) {
+  // The value profiling data starts with its total size.
+  using namespace support;
+  if (D + sizeof(uint32_t) > End)
+    return false;
+  uint32_t TotalSize =
+      ValueProfDataEndianness == little
+          ? endian::read<uint32_t, little, unaligned>(D)
+          : endian::read<uint32_t, big, unaligned>(D);
+  if (TotalSize < sizeof(uint32_t) || TotalSize > uint64_t(End - D))
+    return false;
+  D += TotalSize;
+  return true;
+}
+
+bool InstrProfLookupTrait::readCounts(const unsigned char *&D,
+                                      const unsigned char *const End,
+                                      offset_type N, uint64_t &Hash,
+                                      ArrayRef<support::ulittle64_t> &Counts) {
+  using namespace support;
+  // Read hash.
+  if (D + sizeof(uint64_t) >= End)
+    return false;
+  Hash = endian::readNext<uint64_t, little, unaligned>(D);
+
+  // Initialize number of counters for GET_VERSION(FormatVersion) == 1.
+  uint64_t CountsSize = N / sizeof(uint64_t) - 1;
+  // If format version is different then read the number of counters.
+  if (GET_VERSION(FormatVersion) != IndexedInstrProf::ProfVersion::Version1) {
+    if (D + sizeof(uint64_t) > End)
+      return false;
+    CountsSize = endian::readNext<uint64_t, little, unaligned>(D);
+  }
+  // Point to the counter values.
+  if (CountsSize > uint64_t(End - D) / sizeof(uint64_t))
+    return false;
+  Counts = makeArrayRef(reinterpret_cast<const ulittle64_t *>(D), CountsSize);
+  D += CountsSize * sizeof(uint64_t);
+  return true;
+}
+
+Error InstrProfLookupTrait::findCounts(const unsigned char *D, offset_type N,
+                                       uint64_t FuncHash,
+                                       ArrayRef<support::ulittle64_t> &Counts) {
+  if (N % sizeof(uint64_t))
+    return make_error<InstrProfError>(instrprof_error::malformed);
+
+  const unsigned char *End = D + N;
+  while (D < End) {
+    uint64_t Hash;
+    if (!readCounts(D, End, N, Hash, Counts))
+      return make_error<InstrProfError>(instrprof_error::malformed);
+    if (Hash == FuncHash)
+      return Error::success();
+    if (GET_VERSION(FormatVersion) > IndexedInstrProf::ProfVersion::Version2 &&
+        !skipValueProfilingData(D, End))
+      return make_error<InstrProfError>(instrprof_error::malformed);
+  }
+  return make_error<InstrProfError>(instrprof_error::hash_mismatch);
+}
+
 data_type InstrProfLookupTrait::ReadData(StringRef K, const unsigned char *D,
                                          offset_type N) {
   // Check if the data is corrupt. If so, don't try to read it.
@@ -484,34 +546,17 @@ data_type InstrProfLookupTrait::ReadData(StringRef K, const unsigned char *D,
     return data_type();
 
   DataBuffer.clear();
-  std::vector<uint64_t> CounterBuffer;
 
-  using namespace support;
   const unsigned char *End = D + N;
   while (D < End) {
-    // Read hash.
-    if (D + sizeof(uint64_t) >= End)
+    uint64_t Hash;
+    ArrayRef<support::ulittle64_t> Counts;
+    if (!readCounts(D, End, N, Hash, Counts)) {
+      DataBuffer.clear();
       return data_type();
-    uint64_t Hash = endian::readNext<uint64_t, little, unaligned>(D);
-
-    // Initialize number of counters for GET_VERSION(FormatVersion) == 1.
-    uint64_t CountsSize = N / sizeof(uint64_t) - 1;
-    // If format version is different then read the number of counters.
-    if (GET_VERSION(FormatVersion) != IndexedInstrProf::ProfVersion::Version1) {
-      if (D + sizeof(uint64_t) > End)
-        return data_type();
-      CountsSize = endian::readNext<uint64_t, little, unaligned>(D);
     }
-    // Read counter values.
-    if (D + CountsSize * sizeof(uint64_t) > End)
-      return data_type();
-
-    CounterBuffer.clear();
-    CounterBuffer.reserve(CountsSize);
-    for (uint64_t J = 0; J < CountsSize; ++J)
-      CounterBuffer.push_back(endian::readNext<uint64_t, little, unaligned>(D));
-
-    DataBuffer.emplace_back(K, Hash, std::move(CounterBuffer));
+    DataBuffer.emplace_back(K, Hash,
+                            std::vector<uint64_t>(Counts.begin(), Counts.end()));
 
     // Read value profiling data.
     if (GET_VERSION(FormatVersion) > IndexedInstrProf::ProfVersion::Version2 &&
@@ -537,6 +582,18 @@ Error InstrProfReaderIndex<HashTableImpl>::getRecords(
   return Error::success();
 }
 
+template <typename HashTableImpl>
+Error InstrProfReaderIndex<HashTableImpl>::getCounts(
+    StringRef FuncName, uint64_t FuncHash,
+    ArrayRef<support::ulittle64_t> &Counts) {
+  auto Iter = HashTable->find(FuncName);
+  if (Iter == HashTable->end())
+    return make_error<InstrProfError>(instrprof_error::unknown_function);
+
+  return HashTable->getInfoObj().findCounts(Iter.getDataPtr(),
+                                            Iter.getDataLen(), FuncHash, Counts);
+}
+
 template <typename HashTableImpl>
 Error InstrProfReaderIndex<HashTableImpl>::getRecords(
     ArrayRef<InstrProfRecord> &Data) {
@@ -694,11 +751,27 @@ IndexedInstrProfReader::getInstrProfRecord(StringRef FuncName,
 Error IndexedInstrProfReader::getFunctionCounts(StringRef FuncName,
                                                 uint64_t FuncHash,
                                                 std::vector<uint64_t> &Counts) {
-  Expected<InstrProfRecord> Record = getInstrProfRecord(FuncName, FuncHash);
-  if (Error E = Record.takeError())
+  // Only the counters are needed, don't materialize the whole record.
+  ArrayRef<support::ulittle64_t> CountsInProfile;
+  if (Error E = getFunctionCounts(FuncName, FuncHash, CountsInProfile))
+    return E;
+
+  Counts.assign(CountsInProfile.begin(), CountsInProfile.end());
+  return success();
+}
+
+Error IndexedInstrProfReader::getFunctionCounts(
+    StringRef FuncName, uint64_t FuncHash,
+    ArrayRef<support::ulittle64_t> &Counts) {
+  if (Error E = Index->getCounts(FuncName, FuncHash, Counts))
     return error(std::move(E));
+  return success();
+}
 
-  Counts = Record.get().Counts;
+Error IndexedInstrProfReader::getFunctionRecords(
+    StringRef FuncName, ArrayRef<InstrProfRecord> &Records) {
+  if (Error E = Index->getRecords(FuncName, Records))
+    return error(std::move(E));
   return success();
 }
 
@@ -14,8 +14,10 @@
 
 #include "llvm/ProfileData/InstrProfWriter.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/ProfileData/InstrProfReader.h"
 #include "llvm/Support/EndianStream.h"
 #include "llvm/Support/OnDiskHashTable.h"
+#include <algorithm>
 #include <tuple>
 
 using namespace llvm;
@@ -139,6 +141,69 @@ public:
     }
   }
 };
+
+/// The trait emitting the merged records of the streaming merge: the data of
+/// each key is only merged from the inputs when its entry is emitted, and
+/// dropped right after.
+class InstrProfMergingWriterTrait {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+
+  // The data is looked up in the inputs by key.
+  typedef char data_type;
+  typedef char data_type_ref;
+
+  typedef uint64_t hash_value_type;
+  typedef uint64_t offset_type;
+
+  InstrProfMergingWriterTrait(
+      InstrProfRecordWriterTrait &RecordTrait,
+      ArrayRef<InstrProfWriter::WeightedInput> Inputs,
+      function_ref<void(Error, StringRef)> Warn)
+      : RecordTrait(RecordTrait), Inputs(Inputs), Warn(Warn) {}
+
+  static hash_value_type ComputeHash(key_type_ref K) {
+    return InstrProfRecordWriterTrait::ComputeHash(K);
+  }
+
+  std::pair<offset_type, offset_type>
+  EmitKeyDataLength(raw_ostream &Out, key_type_ref K, data_type_ref) {
+    Merged.clear();
+    for (const InstrProfWriter::WeightedInput &Input : Inputs) {
+      ArrayRef<InstrProfRecord> Records;
+      if (Error E = Input.first->getFunctionRecords(K, Records)) {
+        // Functions are missing from most inputs.
+        handleAllErrors(std::move(E), [&](const InstrProfError &IPE) {
+          if (IPE.get() != instrprof_error::unknown_function)
+            Warn(make_error<InstrProfError>(IPE.get()), K);
+        });
+        continue;
+      }
+      for (const InstrProfRecord &Record : Records)
+        if (Error E = InstrProfWriter::addRecord(Merged, InstrProfRecord(Record),
+                                                 Input.second))
+          Warn(std::move(E), K);
+    }
+    return InstrProfRecordWriterTrait::EmitKeyDataLength(Out, K, &Merged);
+  }
+
+  void EmitKey(raw_ostream &Out, key_type_ref K, offset_type N) {
+    RecordTrait.EmitKey(Out, K, N);
+  }
+
+  void EmitData(raw_ostream &Out, key_type_ref K, data_type_ref,
+                offset_type N) {
+    RecordTrait.EmitData(Out, K, &Merged, N);
+    Merged.clear();
+  }
+
+private:
+  InstrProfRecordWriterTrait &RecordTrait;
+  ArrayRef<InstrProfWriter::WeightedInput> Inputs;
+  function_ref<void(Error, StringRef)> Warn;
+  InstrProfWriter::ProfilingData Merged;
+};
 }
 
 InstrProfWriter::InstrProfWriter(bool Sparse)
@@ -157,8 +222,14 @@ void InstrProfWriter::setOutputSparse(bool Sparse) {
 }
 
 Error InstrProfWriter::addRecord(InstrProfRecord &&I, uint64_t Weight) {
-  auto &ProfileDataMap = FunctionData[I.Name];
+  auto Where = FunctionData.insert(std::make_pair(I.Name, ProfilingData()));
+  // Fix up the name to avoid dangling reference.
+  I.Name = Where.first->getKey();
+  return addRecord(Where.first->getValue(), std::move(I), Weight);
+}
 
+Error InstrProfWriter::addRecord(ProfilingData &ProfileDataMap,
+                                 InstrProfRecord &&I, uint64_t Weight) {
   bool NewFunc;
   ProfilingData::iterator Where;
   std::tie(Where, NewFunc) =
@@ -168,8 +239,6 @@ Error InstrProfWriter::addRecord(InstrProfRecord &&I, uint64_t Weight) {
   if (NewFunc) {
     // We've never seen a function with this name and hash, add it.
     Dest = std::move(I);
-    // Fix up the name to avoid dangling reference.
-    Dest.Name = FunctionData.find(Dest.Name)->getKey();
     if (Weight > 1)
       Dest.scale(Weight);
   } else {
@@ -221,14 +290,69 @@ static void setSummary(IndexedInstrProf::Summary *TheSummary,
 void InstrProfWriter::writeImpl(ProfOStream &OS) {
   OnDiskChainedHashTableGenerator<InstrProfRecordWriterTrait> Generator;
 
-  using namespace IndexedInstrProf;
-  InstrProfSummaryBuilder ISB(ProfileSummaryBuilder::DefaultCutoffs);
-  InfoObj->SummaryBuilder = &ISB;
-
   // Populate the hash table generator.
   for (const auto &I : FunctionData)
     if (shouldEncodeData(I.getValue()))
       Generator.insert(I.getKey(), &I.getValue());
+
+  writeIndexed(OS, [&](raw_ostream &Out) {
+    return Generator.Emit(Out, *InfoObj);
+  });
+}
+
+Error InstrProfWriter::writeMerged(raw_fd_ostream &OS,
+                                   ArrayRef<WeightedInput> Inputs,
+                                   function_ref<void(Error, StringRef)> Warn) {
+  for (const WeightedInput &Input : Inputs)
+    if (Error E = setIsIRLevelProfile(Input.first->isIRLevelProfile()))
+      return E;
+
+  // Only the function names, which point into the inputs, are kept in memory
+  // for the whole merge. Sort them so that each function is only inserted
+  // once, whatever the number of inputs it appears in.
+  std::vector<StringRef> Names;
+  for (const WeightedInput &Input : Inputs)
+    Input.first->getFunctionNames(Names);
+  std::sort(Names.begin(), Names.end());
+  Names.erase(std::unique(Names.begin(), Names.end()), Names.end());
+
+  InstrProfMergingWriterTrait MergingTrait(*InfoObj, Inputs, Warn);
+  OnDiskChainedHashTableGenerator<InstrProfMergingWriterTrait> Generator;
+  for (StringRef Name : Names)
+    if (!Sparse || hasNonZeroCounts(Name, Inputs))
+      Generator.insert(Name, 0, MergingTrait);
+
+  ProfOStream POS(OS);
+  writeIndexed(POS, [&](raw_ostream &Out) {
+    return Generator.Emit(Out, MergingTrait);
+  });
+  return Error::success();
+}
+
+bool InstrProfWriter::hasNonZeroCounts(StringRef Name,
+                                       ArrayRef<WeightedInput> Inputs) {
+  // The weights are positive and the merge saturates, so the merged counters
+  // are all zero only if they are in every input.
+  for (const WeightedInput &Input : Inputs) {
+    ArrayRef<InstrProfRecord> Records;
+    if (Error E = Input.first->getFunctionRecords(Name, Records)) {
+      consumeError(std::move(E));
+      continue;
+    }
+    for (const InstrProfRecord &Record : Records)
+      if (std::any_of(Record.Counts.begin(), Record.Counts.end(),
+                      [](uint64_t Count) { return Count > 0; }))
+        return true;
+  }
+  return false;
+}
+
+void InstrProfWriter::writeIndexed(
+    ProfOStream &OS, function_ref<uint64_t(raw_ostream &)> EmitHashTable) {
+  using namespace IndexedInstrProf;
+  InstrProfSummaryBuilder ISB(ProfileSummaryBuilder::DefaultCutoffs);
+  InfoObj->SummaryBuilder = &ISB;
+
   // Write the header.
   IndexedInstrProf::Header Header;
   Header.Magic = IndexedInstrProf::Magic;
@@ -260,7 +384,7 @@ void InstrProfWriter::writeImpl(ProfOStream &OS) {
     OS.write(0);
 
   // Write the hash table.
-  uint64_t HashTableStart = Generator.Emit(OS.OS, *InfoObj);
+  uint64_t HashTableStart = EmitHashTable(OS.OS);
 
   // Allocate space for data to be serialized out.
   std::unique_ptr<IndexedInstrProf::Summary> TheSummary =
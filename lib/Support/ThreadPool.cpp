@@ -7,95 +7,182 @@
 //
 //===----------------------------------------------------------------------===//
 //
-// This file implements a crude C++11 based thread pool.
+// This file implements a C++11 based work-stealing thread pool.
 //
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/ThreadPool.h"
 
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+
 using namespace llvm;
 
 #if LLVM_ENABLE_THREADS
 
+// The pool and the index of the worker the current thread belongs to, if any.
+static LLVM_THREAD_LOCAL const ThreadPool *CurrentPool = nullptr;
+static LLVM_THREAD_LOCAL unsigned CurrentWorkerID = 0;
+
 // Default to std::thread::hardware_concurrency
 ThreadPool::ThreadPool() : ThreadPool(std::thread::hardware_concurrency()) {}
 
 ThreadPool::ThreadPool(unsigned ThreadCount)
-    : ActiveThreads(0), EnableFlag(true) {
-  // Create ThreadCount threads that will loop forever, wait on QueueCondition
-  // for tasks to be queued or the Pool to be destroyed.
+    : NextQueue(0), QueuedTasks(0), UnfinishedTasks(0), WaitingWorkers(0),
+      EnableFlag(true) {
+  Queues.reserve(std::max(ThreadCount, 1U));
+  for (unsigned I = 0, E = std::max(ThreadCount, 1U); I != E; ++I)
+    Queues.push_back(llvm::make_unique<WorkerQueue>());
+
+  // Create ThreadCount threads that will loop forever, running tasks from
+  // their own queue or stolen from the other workers, and wait on
+  // QueueCondition when all the queues are empty.
   Threads.reserve(ThreadCount);
   for (unsigned ThreadID = 0; ThreadID < ThreadCount; ++ThreadID) {
-    Threads.emplace_back([&] {
+    Threads.emplace_back([this, ThreadID] {
+      CurrentPool = this;
+      CurrentWorkerID = ThreadID;
       while (true) {
-        PackagedTaskTy Task;
-        {
-          std::unique_lock<std::mutex> LockGuard(QueueLock);
-          // Wait for tasks to be pushed in the queue
-          QueueCondition.wait(LockGuard,
-                              [&] { return !EnableFlag || !Tasks.empty(); });
-          // Exit condition
-          if (!EnableFlag && Tasks.empty())
-            return;
-          // Yeah, we have a task, grab it and release the lock on the queue
-
-          // We first need to signal that we are active before popping the queue
-          // in order for wait() to properly detect that even if the queue is
-          // empty, there is still a task in flight.
-          {
-            ++ActiveThreads;
-            std::unique_lock<std::mutex> LockGuard(CompletionLock);
-          }
-          Task = std::move(Tasks.front());
-          Tasks.pop();
-        }
-        // Run the task we just grabbed
+        if (runOneTask(ThreadID))
+          continue;
+        std::unique_lock<std::mutex> LockGuard(QueueLock);
+        // Wait for tasks to be pushed in one of the queues
+        QueueCondition.wait(LockGuard,
+                            [&] { return !EnableFlag || QueuedTasks != 0; });
+        // Exit condition
+        if (!EnableFlag && QueuedTasks == 0)
+          return;
+      }
+    });
+  }
+}
+
+bool ThreadPool::isWorkerThread() const { return CurrentPool == this; }
+
+bool ThreadPool::popTask(unsigned WorkerID, PackagedTaskTy &Task) {
+  // Newest task from our own queue first, it is the most likely to be hot in
+  // cache and to be a subtask someone is waiting on.
+  {
+    WorkerQueue &Own = *Queues[WorkerID];
+    std::unique_lock<std::mutex> LockGuard(Own.Lock);
+    if (!Own.Tasks.empty()) {
+      Task = std::move(Own.Tasks.back());
+      Own.Tasks.pop_back();
+      --QueuedTasks;
+      return true;
+    }
+  }
+  // Otherwise steal the oldest task of another worker.
+  for (unsigned I = 1, E = Queues.size(); I != E; ++I) {
+    WorkerQueue &Victim = *Queues[(WorkerID + I) % E];
+    std::unique_lock<std::mutex> LockGuard(Victim.Lock);
+    if (!Victim.Tasks.empty()) {
+      Task = std::move(Victim.Tasks.front());
+      Victim.Tasks.pop_front();
+      --QueuedTasks;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ThreadPool::runOneTask(unsigned WorkerID) {
+  PackagedTaskTy Task;
+  if (!popTask(WorkerID, Task))
+    return false;
+
+  // Run the task we just grabbed
 #ifndef _MSC_VER
-        Task();
+  Task();
 #else
-        Task(/* unused */ false);
+  Task(/* unused */ false);
 #endif
 
-        {
-          // Adjust `ActiveThreads`, in case someone waits on ThreadPool::wait()
-          std::unique_lock<std::mutex> LockGuard(CompletionLock);
-          --ActiveThreads;
-        }
-
-        // Notify task completion, in case someone waits on ThreadPool::wait()
-        CompletionCondition.notify_all();
-      }
-    });
+  {
+    // Adjust `UnfinishedTasks`, in case someone waits on ThreadPool::wait()
+    std::unique_lock<std::mutex> LockGuard(CompletionLock);
+    --UnfinishedTasks;
   }
+
+  // Notify task completion, in case someone waits on ThreadPool::wait()
+  CompletionCondition.notify_all();
+  return true;
 }
 
 void ThreadPool::wait() {
-  // Wait for all threads to complete and the queue to be empty
+  assert(!isWorkerThread() && "Waiting for the whole pool from one of its "
+                              "tasks would deadlock");
+  // Wait for all tasks to complete, which implies that the queues are empty.
   std::unique_lock<std::mutex> LockGuard(CompletionLock);
-  // The order of the checks for ActiveThreads and Tasks.empty() matters because
-  // any active threads might be modifying the Tasks queue, and this would be a
-  // race.
-  CompletionCondition.wait(LockGuard,
-                           [&] { return !ActiveThreads && Tasks.empty(); });
+  CompletionCondition.wait(LockGuard, [&] { return !UnfinishedTasks; });
+}
+
+void ThreadPool::wait(const std::shared_future<VoidTy> &Future) {
+  if (!isWorkerThread()) {
+    Future.wait();
+    return;
+  }
+  auto IsReady = [&] {
+    return Future.wait_for(std::chrono::seconds(0)) ==
+           std::future_status::ready;
+  };
+  // Help with the queued work instead of blocking this worker: the task we are
+  // waiting on may well be sitting in our own queue.
+  while (!IsReady()) {
+    if (runOneTask(CurrentWorkerID))
+      continue;
+    // Nothing left to help with, the task is running on another worker. Sleep
+    // until some task completes, which runOneTask() signals after the future
+    // is made ready, or until a new task gets queued.
+    std::unique_lock<std::mutex> LockGuard(CompletionLock);
+    ++WaitingWorkers;
+    CompletionCondition.wait(LockGuard,
+                             [&] { return QueuedTasks != 0 || IsReady(); });
+    --WaitingWorkers;
+  }
 }
 
 std::shared_future<ThreadPool::VoidTy> ThreadPool::asyncImpl(TaskTy Task) {
   /// Wrap the Task in a packaged_task to return a future object.
   PackagedTaskTy PackagedTask(std::move(Task));
   auto Future = PackagedTask.get_future();
+
+  // Tasks spawned by a worker go to its own queue, others are spread
+  // round-robin over all the queues.
+  unsigned QueueID =
+      isWorkerThread() ? CurrentWorkerID : NextQueue++ % Queues.size();
+
+  // Account for the task before making it visible to the workers, so that
+  // neither counter can be observed going below zero.
+  {
+    std::unique_lock<std::mutex> LockGuard(CompletionLock);
+    ++UnfinishedTasks;
+  }
   {
-    // Lock the queue and push the new task
     std::unique_lock<std::mutex> LockGuard(QueueLock);
 
     // Don't allow enqueueing after disabling the pool
     assert(EnableFlag && "Queuing a thread during ThreadPool destruction");
 
-    Tasks.push(std::move(PackagedTask));
+    ++QueuedTasks;
+  }
+  {
+    WorkerQueue &Queue = *Queues[QueueID];
+    std::unique_lock<std::mutex> LockGuard(Queue.Lock);
+    Queue.Tasks.push_back(std::move(PackagedTask));
   }
   QueueCondition.notify_one();
+  // Workers blocked in wait(Future) sleep on CompletionCondition, and may be
+  // the only ones able to run the new task. They bump WaitingWorkers before
+  // checking QueuedTasks, so either they see the task or we see them.
+  if (WaitingWorkers) {
+    { std::unique_lock<std::mutex> LockGuard(CompletionLock); }
+    CompletionCondition.notify_all();
+  }
   return Future.share();
 }
 
@@ -116,24 +203,48 @@ ThreadPool::ThreadPool() : ThreadPool(0) {}
 
 // No threads are launched, issue a warning if ThreadCount is not 0
 ThreadPool::ThreadPool(unsigned ThreadCount)
-    : ActiveThreads(0) {
+    : NextQueue(0), QueuedTasks(0), UnfinishedTasks(0), WaitingWorkers(0) {
+  Queues.push_back(llvm::make_unique<WorkerQueue>());
   if (ThreadCount) {
     errs() << "Warning: request a ThreadPool with " << ThreadCount
            << " threads, but LLVM_ENABLE_THREADS has been turned off\n";
   }
 }
 
+bool ThreadPool::isWorkerThread() const { return false; }
+
 void ThreadPool::wait() {
   // Sequential implementation running the tasks
-  while (!Tasks.empty()) {
-    auto Task = std::move(Tasks.front());
-    Tasks.pop();
+  while (runOneTask(0))
+    ;
+}
+
+void ThreadPool::wait(const std::shared_future<VoidTy> &Future) {
+  // The future is deferred, waiting on it runs the task.
+  Future.wait();
+}
+
+bool ThreadPool::popTask(unsigned WorkerID, PackagedTaskTy &Task) {
+  auto &Tasks = Queues[WorkerID]->Tasks;
+  if (Tasks.empty())
+    return false;
+  Task = std::move(Tasks.front());
+  Tasks.pop_front();
+  --QueuedTasks;
+  return true;
+}
+
+bool ThreadPool::runOneTask(unsigned WorkerID) {
+  PackagedTaskTy Task;
+  if (!popTask(WorkerID, Task))
+    return false;
 #ifndef _MSC_VER
-        Task();
+  Task();
 #else
-        Task(/* unused */ false);
+  Task(/* unused */ false);
 #endif
-  }
+  --UnfinishedTasks;
+  return true;
 }
 
 std::shared_future<ThreadPool::VoidTy> ThreadPool::asyncImpl(TaskTy Task) {
@@ -147,7 +258,9 @@ std::shared_future<ThreadPool::VoidTy> ThreadPool::asyncImpl(TaskTy Task) {
   auto Future = std::async(std::launch::deferred, std::move(Task), false).share();
   PackagedTaskTy PackagedTask([Future](bool) -> bool { Future.get(); return false; });
 #endif
-  Tasks.push(std::move(PackagedTask));
+  ++UnfinishedTasks;
+  ++QueuedTasks;
+  Queues[0]->Tasks.push_back(std::move(PackagedTask));
   return Future;
 }
 
@@ -0,0 +1,160 @@
+//===-- TimeProfiler.cpp - Trace Event Profiler ---------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the trace event profiler declared in TimeProfiler.h.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+typedef std::chrono::steady_clock ClockTy;
+
+struct Entry {
+  ClockTy::time_point Start;
+  ClockTy::duration Duration;
+  int64_t MemoryDelta;
+  unsigned ThreadID;
+  std::string Name;
+  std::string Detail;
+};
+} // end anonymous namespace
+
+namespace llvm {
+class TimeProfiler {
+public:
+  TimeProfiler() : BeginningOfTime(ClockTy::now()) {}
+
+  void record(Entry E) {
+    std::lock_guard<std::mutex> Lock(EntriesLock);
+    Entries.push_back(std::move(E));
+  }
+
+  void write(raw_ostream &OS);
+
+private:
+  const ClockTy::time_point BeginningOfTime;
+  std::mutex EntriesLock;
+  std::vector<Entry> Entries;
+};
+} // end namespace llvm
+
+TimeProfiler *llvm::TimeTraceProfilerInstance = nullptr;
+
+/// Returns a small number identifying the calling thread in the trace.
+static unsigned getThreadID() {
+  static std::atomic<unsigned> NextThreadID(0);
+  static LLVM_THREAD_LOCAL unsigned ThreadID = 0;
+  if (!ThreadID)
+    ThreadID = ++NextThreadID;
+  return ThreadID;
+}
+
+/// Write \p S as a JSON string literal.
+static void writeJSONString(raw_ostream &OS, StringRef S) {
+  OS << '"';
+  for (unsigned char C : S) {
+    switch (C) {
+    case '"':  OS << "\\\""; break;
+    case '\\': OS << "\\\\"; break;
+    case '\n': OS << "\\n"; break;
+    case '\t': OS << "\\t"; break;
+    default:
+      if (C < 0x20)
+        OS << format("\\u%04x", C);
+      else
+        OS << C;
+    }
+  }
+  OS << '"';
+}
+
+void TimeProfiler::write(raw_ostream &OS) {
+  std::lock_guard<std::mutex> Lock(EntriesLock);
+  typedef std::chrono::duration<uint64_t, std::micro> MicrosecondsTy;
+
+  OS << "{\"traceEvents\":[";
+  bool First = true;
+  for (const Entry &E : Entries) {
+    OS << (First ? "\n" : ",\n");
+    First = false;
+    uint64_t Ts = std::chrono::duration_cast<MicrosecondsTy>(
+                      E.Start - BeginningOfTime).count();
+    uint64_t Dur =
+        std::chrono::duration_cast<MicrosecondsTy>(E.Duration).count();
+    OS << "{\"pid\":1,\"tid\":" << E.ThreadID << ",\"ph\":\"X\",\"ts\":" << Ts
+       << ",\"dur\":" << Dur << ",\"name\":";
+    writeJSONString(OS, E.Name);
+    OS << ",\"args\":{\"detail\":";
+    writeJSONString(OS, E.Detail);
+    OS << ",\"mem-delta\":" << E.MemoryDelta << "}}";
+  }
+  OS << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+void llvm::timeTraceProfilerInitialize() {
+  assert(!TimeTraceProfilerInstance && "Profiler already initialized");
+  TimeTraceProfilerInstance = new TimeProfiler();
+}
+
+void llvm::timeTraceProfilerCleanup() {
+  delete TimeTraceProfilerInstance;
+  TimeTraceProfilerInstance = nullptr;
+}
+
+void llvm::timeTraceProfilerWrite(raw_ostream &OS) {
+  assert(TimeTraceProfilerInstance && "Profiler not initialized");
+  TimeTraceProfilerInstance->write(OS);
+}
+
+bool llvm::timeTraceProfilerWrite(StringRef Path, std::string &ErrorInfo) {
+  std::error_code EC;
+  raw_fd_ostream OS(Path, EC, sys::fs::F_Text);
+  if (EC) {
+    ErrorInfo = EC.message();
+    return false;
+  }
+  timeTraceProfilerWrite(OS);
+  return true;
+}
+
+void TimeTraceScope::begin(StringRef Name, StringRef Detail) {
+  Active = true;
+  this->Name = Name;
+  this->Detail = Detail;
+  // Sample the heap before the clock, so that the cost of doing so isn't part
+  // of the span; the end of the span does it the other way around.
+  StartMemory = sys::Process::GetMallocUsage();
+  Start = ClockTy::now();
+}
+
+TimeTraceScope::~TimeTraceScope() {
+  if (!Active)
+    return;
+  ClockTy::time_point End = ClockTy::now();
+  size_t EndMemory = sys::Process::GetMallocUsage();
+  // The profiler may have been torn down while the scope was open.
+  TimeProfiler *Profiler = TimeTraceProfilerInstance;
+  if (!Profiler)
+    return;
+  Profiler->record({Start, End - Start,
+                    int64_t(EndMemory) - int64_t(StartMemory),
+                    getThreadID(), std::move(Name),
+                    std::move(Detail)});
+}
@@ -18,6 +18,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
 
@@ -223,3 +224,9 @@ bool TargetRecip::operator==(const TargetRecip &Other) const {
   }
   return true;
 }
+
+void TargetRecip::print(raw_ostream &OS) const {
+  for (const auto &KV : RecipMap)
+    OS << KV.first << ':' << int(KV.second.Enabled) << ':'
+       << int(KV.second.RefinementSteps) << ',';
+}
@@ -131,6 +131,10 @@ public:
                          SmallVectorImpl<MCFixup> &Fixups,
                          const MCSubtargetInfo &STI) const override;
 
+  /// The only context state encoding changes is the allocator, for the
+  /// expressions of the fixups.
+  bool supportsConcurrentEncoding() const override { return true; }
+
   void EmitVEXOpcodePrefix(uint64_t TSFlags, unsigned &CurByte, int MemOperand,
                            const MCInst &MI, const MCInstrDesc &Desc,
                            raw_ostream &OS) const;
@@ -132,6 +132,9 @@ private:
   bool X86SelectFPExt(const Instruction *I);
   bool X86SelectFPTrunc(const Instruction *I);
   bool X86SelectSIToFP(const Instruction *I);
+  bool X86SelectUIToFP(const Instruction *I);
+
+  unsigned X86FastEmitZExtToI64(MVT SrcVT, unsigned SrcReg);
 
   const X86InstrInfo *getInstrInfo() const {
     return Subtarget->getInstrInfo();
@@ -1521,24 +1524,7 @@ bool X86FastISel::X86SelectZExt(const Instruction *I) {
   }
 
   if (DstVT == MVT::i64) {
-    // Handle extension to 64-bits via sub-register shenanigans.
-    unsigned MovInst;
-
-    switch (SrcVT.SimpleTy) {
-    case MVT::i8:  MovInst = X86::MOVZX32rr8;  break;
-    case MVT::i16: MovInst = X86::MOVZX32rr16; break;
-    case MVT::i32: MovInst = X86::MOV32rr;     break;
-    default: llvm_unreachable("Unexpected zext to i64 source type");
-    }
-
-    unsigned Result32 = createResultReg(&X86::GR32RegClass);
-    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(MovInst), Result32)
-      .addReg(ResultReg);
-
-    ResultReg = createResultReg(&X86::GR64RegClass);
-    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(TargetOpcode::SUBREG_TO_REG),
-            ResultReg)
-      .addImm(0).addReg(Result32).addImm(X86::sub_32bit);
+    ResultReg = X86FastEmitZExtToI64(SrcVT, ResultReg);
   } else if (DstVT != MVT::i8) {
     ResultReg = fastEmit_r(MVT::i8, DstVT.getSimpleVT(), ISD::ZERO_EXTEND,
                            ResultReg, /*Kill=*/true);
@@ -1550,6 +1536,29 @@ bool X86FastISel::X86SelectZExt(const Instruction *I) {
   return true;
 }
 
+/// Zero-extend \p SrcReg, an i8, i16 or i32 register, to a new i64 register.
+unsigned X86FastISel::X86FastEmitZExtToI64(MVT SrcVT, unsigned SrcReg) {
+  // Handle extension to 64-bits via sub-register shenanigans.
+  unsigned MovInst;
+
+  switch (SrcVT.SimpleTy) {
+  case MVT::i8:  MovInst = X86::MOVZX32rr8;  break;
+  case MVT::i16: MovInst = X86::MOVZX32rr16; break;
+  case MVT::i32: MovInst = X86::MOV32rr;     break;
+  default: llvm_unreachable("Unexpected zext to i64 source type");
+  }
+
+  unsigned Result32 = createResultReg(&X86::GR32RegClass);
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(MovInst), Result32)
+    .addReg(SrcReg);
+
+  unsigned ResultReg = createResultReg(&X86::GR64RegClass);
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(TargetOpcode::SUBREG_TO_REG),
+          ResultReg)
+    .addImm(0).addReg(Result32).addImm(X86::sub_32bit);
+  return ResultReg;
+}
+
 bool X86FastISel::X86SelectBranch(const Instruction *I) {
   // Unconditional branches are selected by tablegen-generated code.
   // Handle a conditional branch.
@@ -2303,6 +2312,51 @@ bool X86FastISel::X86SelectSIToFP(const Instruction *I) {
   return true;
 }
 
+bool X86FastISel::X86SelectUIToFP(const Instruction *I) {
+  // There is no unsigned conversion before AVX-512, but in 64-bit mode an
+  // unsigned integer of up to 32 bits converts exactly as the signed 64-bit
+  // integer it zero-extends to. This is what SelectionDAG does as well.
+  if (!Subtarget->is64Bit())
+    return false;
+
+  MVT SrcVT;
+  if (!isTypeLegal(I->getOperand(0)->getType(), SrcVT) ||
+      (SrcVT != MVT::i8 && SrcVT != MVT::i16 && SrcVT != MVT::i32))
+    return false;
+
+  const TargetRegisterClass *RC = nullptr;
+  unsigned Opcode;
+  bool HasAVX = Subtarget->hasAVX();
+  if (I->getType()->isDoubleTy() && X86ScalarSSEf64) {
+    // uitofp int -> double
+    Opcode = HasAVX ? X86::VCVTSI2SD64rr : X86::CVTSI2SD64rr;
+    RC = &X86::FR64RegClass;
+  } else if (I->getType()->isFloatTy() && X86ScalarSSEf32) {
+    // uitofp int -> float
+    Opcode = HasAVX ? X86::VCVTSI2SS64rr : X86::CVTSI2SS64rr;
+    RC = &X86::FR32RegClass;
+  } else
+    return false;
+
+  unsigned OpReg = getRegForValue(I->getOperand(0));
+  if (OpReg == 0)
+    return false;
+  unsigned Op64Reg = X86FastEmitZExtToI64(SrcVT, OpReg);
+
+  unsigned ResultReg;
+  if (HasAVX) {
+    unsigned ImplicitDefReg = createResultReg(RC);
+    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc,
+            TII.get(TargetOpcode::IMPLICIT_DEF), ImplicitDefReg);
+    ResultReg =
+        fastEmitInst_rr(Opcode, RC, ImplicitDefReg, true, Op64Reg, true);
+  } else {
+    ResultReg = fastEmitInst_r(Opcode, RC, Op64Reg, true);
+  }
+  updateValueMap(I, ResultReg);
+  return true;
+}
+
 // Helper method used by X86SelectFPExt and X86SelectFPTrunc.
 bool X86FastISel::X86SelectFPExtOrFPTrunc(const Instruction *I,
                                           unsigned TargetOpc,
@@ -3432,6 +3486,8 @@ X86FastISel::fastSelectInstruction(const Instruction *I)  {
     return X86SelectFPTrunc(I);
   case Instruction::SIToFP:
     return X86SelectSIToFP(I);
+  case Instruction::UIToFP:
+    return X86SelectUIToFP(I);
   case Instruction::IntToPtr: // Deliberate fall-through.
   case Instruction::PtrToInt: {
     EVT SrcVT = TLI.getValueType(DL, I->getOperand(0)->getType());
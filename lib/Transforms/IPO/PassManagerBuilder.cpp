@@ -141,6 +141,11 @@ static cl::opt<bool> EnableGVNHoist(
     "enable-gvn-hoist", cl::init(false), cl::Hidden,
     cl::desc("Enable the experimental GVN Hoisting pass"));
 
+static cl::opt<bool> EnableMemorySSAGVNDSE(
+    "enable-memoryssa-gvn-dse", cl::init(false), cl::Hidden,
+    cl::desc("Use MemorySSA instead of MemoryDependenceAnalysis in GVN and "
+             "DSE"));
+
 PassManagerBuilder::PassManagerBuilder() {
     OptLevel = 2;
     SizeLevel = 0;
@@ -155,6 +160,7 @@ PassManagerBuilder::PassManagerBuilder() {
     RerollLoops = RunLoopRerolling;
     LoadCombine = RunLoadCombine;
     DisableGVNLoadPRE = false;
+    UseMemorySSA = EnableMemorySSAGVNDSE;
     VerifyInput = false;
     VerifyOutput = false;
     MergeFunctions = false;
@@ -309,7 +315,8 @@ void PassManagerBuilder::addFunctionSimplificationPasses(
   if (OptLevel > 1) {
     if (EnableMLSM)
       MPM.add(createMergedLoadStoreMotionPass()); // Merge ld/st in diamonds
-    MPM.add(createGVNPass(DisableGVNLoadPRE));  // Remove redundancies
+    // Remove redundancies
+    MPM.add(createGVNPass(DisableGVNLoadPRE, UseMemorySSA));
   }
   MPM.add(createMemCpyOptPass());             // Remove memcpy / form memset
   MPM.add(createSCCPPass());                  // Constant prop with SCCP
@@ -325,7 +332,8 @@ void PassManagerBuilder::addFunctionSimplificationPasses(
   addExtensionsToPM(EP_Peephole, MPM);
   MPM.add(createJumpThreadingPass());         // Thread jumps
   MPM.add(createCorrelatedValuePropagationPass());
-  MPM.add(createDeadStoreEliminationPass());  // Delete dead stores
+  // Delete dead stores
+  MPM.add(createDeadStoreEliminationPass(UseMemorySSA));
   MPM.add(createLICMPass());
 
   addExtensionsToPM(EP_ScalarOptimizerLate, MPM);
@@ -341,7 +349,8 @@ void PassManagerBuilder::addFunctionSimplificationPasses(
       addInstructionCombiningPass(MPM);
       addExtensionsToPM(EP_Peephole, MPM);
       if (OptLevel > 1 && UseGVNAfterVectorization)
-        MPM.add(createGVNPass(DisableGVNLoadPRE)); // Remove redundancies
+        // Remove redundancies
+        MPM.add(createGVNPass(DisableGVNLoadPRE, UseMemorySSA));
       else
         MPM.add(createEarlyCSEPass());      // Catch trivial redundancies
 
@@ -565,7 +574,8 @@ void PassManagerBuilder::populateModulePassManager(
       addInstructionCombiningPass(MPM);
       addExtensionsToPM(EP_Peephole, MPM);
       if (OptLevel > 1 && UseGVNAfterVectorization)
-        MPM.add(createGVNPass(DisableGVNLoadPRE)); // Remove redundancies
+        // Remove redundancies
+        MPM.add(createGVNPass(DisableGVNLoadPRE, UseMemorySSA));
       else
         MPM.add(createEarlyCSEPass());      // Catch trivial redundancies
 
@@ -711,11 +721,12 @@ void PassManagerBuilder::addLTOOptimizationPasses(legacy::PassManagerBase &PM) {
   PM.add(createLICMPass());                 // Hoist loop invariants.
   if (EnableMLSM)
     PM.add(createMergedLoadStoreMotionPass()); // Merge ld/st in diamonds.
-  PM.add(createGVNPass(DisableGVNLoadPRE)); // Remove redundancies.
+  // Remove redundancies.
+  PM.add(createGVNPass(DisableGVNLoadPRE, UseMemorySSA));
   PM.add(createMemCpyOptPass());            // Remove dead memcpys.
 
   // Nuke dead stores.
-  PM.add(createDeadStoreEliminationPass());
+  PM.add(createDeadStoreEliminationPass(UseMemorySSA));
 
   // More loops are countable; try to optimize them.
   PM.add(createIndVarSimplifyPass());
@@ -40,6 +40,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Transforms/Utils/MemorySSA.h"
 #include <map>
 using namespace llvm;
 
@@ -55,6 +56,11 @@ EnablePartialOverwriteTracking("enable-dse-partial-overwrite-tracking",
   cl::init(true), cl::Hidden,
   cl::desc("Enable partial-overwrite tracking in DSE"));
 
+static cl::opt<unsigned>
+MemorySSAScanLimit("dse-memoryssa-scan-limit", cl::init(100), cl::Hidden,
+  cl::desc("The number of memory defs DSE walks up from a store when using "
+           "MemorySSA"));
+
 
 //===----------------------------------------------------------------------===//
 // Helper functions
@@ -66,9 +72,11 @@ typedef DenseMap<Instruction *, OverlapIntervalsTy> InstOverlapIntervalsTy;
 /// operands of this instruction.  If any of them become dead, delete them and
 /// the computation tree that feeds them.
 /// If ValueSet is non-null, remove any deleted instructions from it as well.
+/// Exactly one of MD and MSSA is expected to be non-null.
 static void
 deleteDeadInstruction(Instruction *I, BasicBlock::iterator *BBI,
-                      MemoryDependenceResults &MD, const TargetLibraryInfo &TLI,
+                      MemoryDependenceResults *MD, MemorySSA *MSSA,
+                      const TargetLibraryInfo &TLI,
                       InstOverlapIntervalsTy &IOL,
                       SmallSetVector<Value *, 16> *ValueSet = nullptr) {
   SmallVector<Instruction*, 32> NowDeadInsts;
@@ -88,7 +96,11 @@ deleteDeadInstruction(Instruction *I, BasicBlock::iterator *BBI,
     // This instruction is dead, zap it, in stages.  Start by removing it from
     // MemDep, which needs to know the operands and needs it to be in the
     // function.
-    MD.removeInstruction(DeadInst);
+    if (MD)
+      MD->removeInstruction(DeadInst);
+    if (MSSA)
+      if (MemoryAccess *MA = MSSA->getMemoryAccess(DeadInst))
+        MSSA->removeMemoryAccess(MA);
 
     for (unsigned op = 0, e = DeadInst->getNumOperands(); op != e; ++op) {
       Value *Op = DeadInst->getOperand(op);
@@ -585,11 +597,79 @@ static void findUnconditionalPreds(SmallVectorImpl<BasicBlock *> &Blocks,
   }
 }
 
+/// The MemorySSA counterpart of MemoryDependenceResults's
+/// getPointerDependencyFrom for a write to \p Loc. Walks the defs in \p BB
+/// up from \p Current, the memory state just before \p Bound (the end of
+/// the block if null), and returns the first of them that may access \p Loc.
+/// A read of \p Loc between that def and \p Bound is returned instead. Uses
+/// are attached to their clobbering def, so the reads that matter all hang
+/// off the defs walked over.
+static MemDepResult getWriteDependency(const MemoryLocation &Loc,
+                                       const MemoryAccess *Current,
+                                       const MemoryAccess *Bound,
+                                       const BasicBlock *BB, MemorySSA &MSSA,
+                                       AliasAnalysis &AA) {
+  unsigned Limit = MemorySSAScanLimit;
+  while (auto *Def = dyn_cast_or_null<MemoryDef>(Current)) {
+    if (MSSA.isLiveOnEntryDef(Def) || Def->getBlock() != BB)
+      break;
+    // MemorySSA gives debug intrinsics a def, they must not change the result
+    // nor count against the limit.
+    if (isa<DbgInfoIntrinsic>(Def->getMemoryInst())) {
+      Current = Def->getDefiningAccess();
+      continue;
+    }
+    if (!Limit--)
+      return MemDepResult::getUnknown();
+
+    for (const User *U : Def->users()) {
+      auto *Use = dyn_cast<MemoryUse>(U);
+      if (!Use || Use->getBlock() != BB ||
+          (Bound && !MSSA.locallyDominates(Use, Bound)))
+        continue;
+      if (AA.getModRefInfo(Use->getMemoryInst(), Loc) & MRI_Ref)
+        return MemDepResult::getClobber(Use->getMemoryInst());
+    }
+
+    if (AA.getModRefInfo(Def->getMemoryInst(), Loc) != MRI_NoModRef)
+      return MemDepResult::getClobber(Def->getMemoryInst());
+    Current = Def->getDefiningAccess();
+  }
+  return MemDepResult::getNonLocal();
+}
+
+/// Return the memory state at the end of \p BB, or null if \p BB does not
+/// write memory.
+static const MemoryAccess *getLastDef(const BasicBlock *BB, MemorySSA &MSSA) {
+  if (const MemorySSA::AccessList *Accesses = MSSA.getBlockAccesses(BB))
+    for (const MemoryAccess &MA : reverse(*Accesses))
+      if (!isa<MemoryUse>(MA))
+        return &MA;
+  return nullptr;
+}
+
+/// Returns true if an instruction of \p BB before \p Bound may read \p Loc.
+/// Reads are attached to whatever def clobbers them, which can be in another
+/// block, so they have to be scanned before moving to the predecessors.
+static bool mayReadBefore(const MemoryLocation &Loc, const BasicBlock *BB,
+                          const MemoryAccess *Bound, MemorySSA &MSSA,
+                          AliasAnalysis &AA) {
+  if (const MemorySSA::AccessList *Accesses = MSSA.getBlockAccesses(BB))
+    for (const MemoryAccess &MA : *Accesses) {
+      if (&MA == Bound)
+        break;
+      if (auto *Use = dyn_cast<MemoryUse>(&MA))
+        if (AA.getModRefInfo(Use->getMemoryInst(), Loc) & MRI_Ref)
+          return true;
+    }
+  return false;
+}
+
 /// Handle frees of entire structures whose dependency is a store
 /// to a field of that structure.
 static bool handleFree(CallInst *F, AliasAnalysis *AA,
-                       MemoryDependenceResults *MD, DominatorTree *DT,
-                       const TargetLibraryInfo *TLI,
+                       MemoryDependenceResults *MD, MemorySSA *MSSA,
+                       DominatorTree *DT, const TargetLibraryInfo *TLI,
                        InstOverlapIntervalsTy &IOL) {
   bool MadeChange = false;
 
@@ -603,8 +683,23 @@ static bool handleFree(CallInst *F, AliasAnalysis *AA,
     Instruction *InstPt = BB->getTerminator();
     if (BB == F->getParent()) InstPt = F;
 
-    MemDepResult Dep =
-        MD->getPointerDependencyFrom(Loc, false, InstPt->getIterator(), BB);
+    // With MemorySSA, the walk starts from the state before the free, or from
+    // the last def of a predecessor.
+    const MemoryAccess *Bound = nullptr;
+    auto GetDependency = [&]() {
+      if (MD)
+        return MD->getPointerDependencyFrom(Loc, false, InstPt->getIterator(),
+                                            BB);
+      if (InstPt != F)
+        return getWriteDependency(Loc, getLastDef(BB, *MSSA), nullptr, BB,
+                                  *MSSA, *AA);
+      Bound = MSSA->getMemoryAccess(F);
+      return getWriteDependency(
+          Loc, cast<MemoryUseOrDef>(Bound)->getDefiningAccess(), Bound, BB,
+          *MSSA, *AA);
+    };
+
+    MemDepResult Dep = GetDependency();
     while (Dep.isDef() || Dep.isClobber()) {
       Instruction *Dependency = Dep.getInst();
       if (!hasMemoryWrite(Dependency, *TLI) || !isRemovable(Dependency))
@@ -622,7 +717,7 @@ static bool handleFree(CallInst *F, AliasAnalysis *AA,
 
       // DCE instructions only used to calculate that store.
       BasicBlock::iterator BBI(Dependency);
-      deleteDeadInstruction(Dependency, &BBI, *MD, *TLI, IOL);
+      deleteDeadInstruction(Dependency, &BBI, MD, MSSA, *TLI, IOL);
       ++NumFastStores;
       MadeChange = true;
 
@@ -631,10 +726,14 @@ static bool handleFree(CallInst *F, AliasAnalysis *AA,
       //    s[0] = 0;
       //    s[1] = 0; // This has just been deleted.
       //    free(s);
-      Dep = MD->getPointerDependencyFrom(Loc, false, BBI, BB);
+      // MemorySSA has rewired the chain around the deleted def, so the walk
+      // simply starts over.
+      Dep = MD ? MD->getPointerDependencyFrom(Loc, false, BBI, BB)
+               : GetDependency();
     }
 
-    if (Dep.isNonLocal())
+    if (Dep.isNonLocal() &&
+        (MD || !mayReadBefore(Loc, BB, Bound, *MSSA, *AA)))
       findUnconditionalPreds(Blocks, BB, DT);
   }
 
@@ -676,7 +775,7 @@ static void removeAccessedObjects(const MemoryLocation &LoadedLoc,
 /// store i32 1, i32* %A
 /// ret void
 static bool handleEndBlock(BasicBlock &BB, AliasAnalysis *AA,
-                             MemoryDependenceResults *MD,
+                             MemoryDependenceResults *MD, MemorySSA *MSSA,
                              const TargetLibraryInfo *TLI,
                              InstOverlapIntervalsTy &IOL) {
   bool MadeChange = false;
@@ -737,7 +836,8 @@ static bool handleEndBlock(BasicBlock &BB, AliasAnalysis *AA,
               dbgs() << '\n');
 
         // DCE instructions only used to calculate that store.
-        deleteDeadInstruction(Dead, &BBI, *MD, *TLI, IOL, &DeadStackObjects);
+        deleteDeadInstruction(Dead, &BBI, MD, MSSA, *TLI, IOL,
+                              &DeadStackObjects);
         ++NumFastStores;
         MadeChange = true;
         continue;
@@ -748,7 +848,8 @@ static bool handleEndBlock(BasicBlock &BB, AliasAnalysis *AA,
     if (isInstructionTriviallyDead(&*BBI, TLI)) {
       DEBUG(dbgs() << "DSE: Removing trivially dead instruction:\n  DEAD: "
                    << *&*BBI << '\n');
-      deleteDeadInstruction(&*BBI, &BBI, *MD, *TLI, IOL, &DeadStackObjects);
+      deleteDeadInstruction(&*BBI, &BBI, MD, MSSA, *TLI, IOL,
+                            &DeadStackObjects);
       ++NumFastOther;
       MadeChange = true;
       continue;
@@ -943,9 +1044,23 @@ static bool removePartiallyOverlappedStores(AliasAnalysis *AA,
   return Changed;
 }
 
+/// Returns true if the location \p SI stores to has the same clobbering access
+/// as the load \p LI, i.e. it is not written between the two. This is only a
+/// fast path: ordered loads are defs and have no clobber of their own.
+static bool isUnclobberedSinceLoad(LoadInst *LI, StoreInst *SI,
+                                   MemorySSA &MSSA) {
+  MemoryAccess *LoadAccess = MSSA.getMemoryAccess(LI);
+  MemoryAccess *StoreAccess = MSSA.getMemoryAccess(SI);
+  if (!LoadAccess || !StoreAccess)
+    return false;
+  MemorySSAWalker *Walker = MSSA.getWalker();
+  return Walker->getClobberingMemoryAccess(LoadAccess) ==
+         Walker->getClobberingMemoryAccess(StoreAccess);
+}
+
 static bool eliminateNoopStore(Instruction *Inst, BasicBlock::iterator &BBI,
                                AliasAnalysis *AA, MemoryDependenceResults *MD,
-                               const DataLayout &DL,
+                               MemorySSA *MSSA, const DataLayout &DL,
                                const TargetLibraryInfo *TLI,
                                InstOverlapIntervalsTy &IOL) {
   // Must be a store instruction.
@@ -957,12 +1072,14 @@ static bool eliminateNoopStore(Instruction *Inst, BasicBlock::iterator &BBI,
   // then the store can be removed.
   if (LoadInst *DepLoad = dyn_cast<LoadInst>(SI->getValueOperand())) {
     if (SI->getPointerOperand() == DepLoad->getPointerOperand() &&
-        isRemovable(SI) && memoryIsNotModifiedBetween(DepLoad, SI, AA)) {
+        isRemovable(SI) &&
+        ((MSSA && isUnclobberedSinceLoad(DepLoad, SI, *MSSA)) ||
+         memoryIsNotModifiedBetween(DepLoad, SI, AA))) {
 
       DEBUG(dbgs() << "DSE: Remove Store Of Load from same pointer:\n  LOAD: "
                    << *DepLoad << "\n  STORE: " << *SI << '\n');
 
-      deleteDeadInstruction(SI, &BBI, *MD, *TLI, IOL);
+      deleteDeadInstruction(SI, &BBI, MD, MSSA, *TLI, IOL);
       ++NumRedundantStores;
       return true;
     }
@@ -980,7 +1097,7 @@ static bool eliminateNoopStore(Instruction *Inst, BasicBlock::iterator &BBI,
           dbgs() << "DSE: Remove null store to the calloc'ed object:\n  DEAD: "
                  << *Inst << "\n  OBJECT: " << *UnderlyingPointer << '\n');
 
-      deleteDeadInstruction(SI, &BBI, *MD, *TLI, IOL);
+      deleteDeadInstruction(SI, &BBI, MD, MSSA, *TLI, IOL);
       ++NumRedundantStores;
       return true;
     }
@@ -989,7 +1106,8 @@ static bool eliminateNoopStore(Instruction *Inst, BasicBlock::iterator &BBI,
 }
 
 static bool eliminateDeadStores(BasicBlock &BB, AliasAnalysis *AA,
-                                MemoryDependenceResults *MD, DominatorTree *DT,
+                                MemoryDependenceResults *MD, MemorySSA *MSSA,
+                                DominatorTree *DT,
                                 const TargetLibraryInfo *TLI) {
   const DataLayout &DL = BB.getModule()->getDataLayout();
   bool MadeChange = false;
@@ -1001,7 +1119,7 @@ static bool eliminateDeadStores(BasicBlock &BB, AliasAnalysis *AA,
   for (BasicBlock::iterator BBI = BB.begin(), BBE = BB.end(); BBI != BBE; ) {
     // Handle 'free' calls specially.
     if (CallInst *F = isFreeCall(&*BBI, TLI)) {
-      MadeChange |= handleFree(F, AA, MD, DT, TLI, IOL);
+      MadeChange |= handleFree(F, AA, MD, MSSA, DT, TLI, IOL);
       // Increment BBI after handleFree has potentially deleted instructions.
       // This ensures we maintain a valid iterator.
       ++BBI;
@@ -1015,22 +1133,33 @@ static bool eliminateDeadStores(BasicBlock &BB, AliasAnalysis *AA,
       continue;
 
     // eliminateNoopStore will update in iterator, if necessary.
-    if (eliminateNoopStore(Inst, BBI, AA, MD, DL, TLI, IOL)) {
+    if (eliminateNoopStore(Inst, BBI, AA, MD, MSSA, DL, TLI, IOL)) {
       MadeChange = true;
       continue;
     }
 
+    // Figure out what location is being stored to.
+    MemoryLocation Loc = getLocForWrite(Inst, *AA);
+
     // If we find something that writes memory, get its memory dependence.
-    MemDepResult InstDep = MD->getDependency(Inst);
+    const MemoryAccess *InstAccess =
+        MSSA ? MSSA->getMemoryAccess(Inst) : nullptr;
+    auto GetDependency = [&]() {
+      if (MD)
+        return MD->getDependency(Inst);
+      if (!InstAccess || !Loc.Ptr)
+        return MemDepResult::getUnknown();
+      return getWriteDependency(
+          Loc, cast<MemoryUseOrDef>(InstAccess)->getDefiningAccess(),
+          InstAccess, &BB, *MSSA, *AA);
+    };
+    MemDepResult InstDep = GetDependency();
 
     // Ignore any store where we can't find a local dependence.
     // FIXME: cross-block DSE would be fun. :)
     if (!InstDep.isDef() && !InstDep.isClobber())
       continue;
 
-    // Figure out what location is being stored to.
-    MemoryLocation Loc = getLocForWrite(Inst, *AA);
-
     // If we didn't get a useful location, fail.
     if (!Loc.Ptr)
       continue;
@@ -1063,12 +1192,12 @@ static bool eliminateDeadStores(BasicBlock &BB, AliasAnalysis *AA,
                 << *DepWrite << "\n  KILLER: " << *Inst << '\n');
 
           // Delete the store and now-dead instructions that feed it.
-          deleteDeadInstruction(DepWrite, &BBI, *MD, *TLI, IOL);
+          deleteDeadInstruction(DepWrite, &BBI, MD, MSSA, *TLI, IOL);
           ++NumFastStores;
           MadeChange = true;
 
           // We erased DepWrite; start over.
-          InstDep = MD->getDependency(Inst);
+          InstDep = GetDependency();
           continue;
         } else if ((OR == OverwriteEnd && isShortenableAtTheEnd(DepWrite)) ||
                    ((OR == OverwriteBegin &&
@@ -1098,8 +1227,14 @@ static bool eliminateDeadStores(BasicBlock &BB, AliasAnalysis *AA,
       if (AA->getModRefInfo(DepWrite, Loc) & MRI_Ref)
         break;
 
-      InstDep = MD->getPointerDependencyFrom(Loc, false,
-                                             DepWrite->getIterator(), &BB);
+      if (MD)
+        InstDep = MD->getPointerDependencyFrom(Loc, false,
+                                               DepWrite->getIterator(), &BB);
+      else
+        InstDep = getWriteDependency(
+            Loc, cast<MemoryDef>(MSSA->getMemoryAccess(DepWrite))
+                     ->getDefiningAccess(),
+            InstAccess, &BB, *MSSA, *AA);
     }
   }
 
@@ -1109,20 +1244,26 @@ static bool eliminateDeadStores(BasicBlock &BB, AliasAnalysis *AA,
   // If this block ends in a return, unwind, or unreachable, all allocas are
   // dead at its end, which means stores to them are also dead.
   if (BB.getTerminator()->getNumSuccessors() == 0)
-    MadeChange |= handleEndBlock(BB, AA, MD, TLI, IOL);
+    MadeChange |= handleEndBlock(BB, AA, MD, MSSA, TLI, IOL);
 
   return MadeChange;
 }
 
+/// When MD is null, the dependencies are found with a MemorySSA built for
+/// the function instead.
 static bool eliminateDeadStores(Function &F, AliasAnalysis *AA,
                                 MemoryDependenceResults *MD, DominatorTree *DT,
                                 const TargetLibraryInfo *TLI) {
+  std::unique_ptr<MemorySSA> MSSA;
+  if (!MD)
+    MSSA.reset(new MemorySSA(F, AA, DT));
+
   bool MadeChange = false;
   for (BasicBlock &BB : F)
     // Only check non-dead blocks.  Dead blocks may have strange pointer
     // cycles that will confuse alias analysis.
     if (DT->isReachableFromEntry(&BB))
-      MadeChange |= eliminateDeadStores(BB, AA, MD, DT, TLI);
+      MadeChange |= eliminateDeadStores(BB, AA, MD, MSSA.get(), DT, TLI);
   return MadeChange;
 }
 
@@ -1132,7 +1273,8 @@ static bool eliminateDeadStores(Function &F, AliasAnalysis *AA,
 PreservedAnalyses DSEPass::run(Function &F, FunctionAnalysisManager &AM) {
   AliasAnalysis *AA = &AM.getResult<AAManager>(F);
   DominatorTree *DT = &AM.getResult<DominatorTreeAnalysis>(F);
-  MemoryDependenceResults *MD = &AM.getResult<MemoryDependenceAnalysis>(F);
+  MemoryDependenceResults *MD =
+      UseMemorySSA ? nullptr : &AM.getResult<MemoryDependenceAnalysis>(F);
   const TargetLibraryInfo *TLI = &AM.getResult<TargetLibraryAnalysis>(F);
 
   if (!eliminateDeadStores(F, AA, MD, DT, TLI))
@@ -1148,7 +1290,8 @@ namespace {
 /// A legacy pass for the legacy pass manager that wraps \c DSEPass.
 class DSELegacyPass : public FunctionPass {
 public:
-  DSELegacyPass() : FunctionPass(ID) {
+  explicit DSELegacyPass(bool UseMemorySSA = false)
+      : FunctionPass(ID), UseMemorySSA(UseMemorySSA) {
     initializeDSELegacyPassPass(*PassRegistry::getPassRegistry());
   }
 
@@ -1159,7 +1302,8 @@ public:
     DominatorTree *DT = &getAnalysis<DominatorTreeWrapperPass>().getDomTree();
     AliasAnalysis *AA = &getAnalysis<AAResultsWrapperPass>().getAAResults();
     MemoryDependenceResults *MD =
-        &getAnalysis<MemoryDependenceWrapperPass>().getMemDep();
+        UseMemorySSA ? nullptr
+                     : &getAnalysis<MemoryDependenceWrapperPass>().getMemDep();
     const TargetLibraryInfo *TLI =
         &getAnalysis<TargetLibraryInfoWrapperPass>().getTLI();
 
@@ -1170,7 +1314,8 @@ public:
     AU.setPreservesCFG();
     AU.addRequired<DominatorTreeWrapperPass>();
     AU.addRequired<AAResultsWrapperPass>();
-    AU.addRequired<MemoryDependenceWrapperPass>();
+    if (!UseMemorySSA)
+      AU.addRequired<MemoryDependenceWrapperPass>();
     AU.addRequired<TargetLibraryInfoWrapperPass>();
     AU.addPreserved<DominatorTreeWrapperPass>();
     AU.addPreserved<GlobalsAAWrapperPass>();
@@ -1178,6 +1323,9 @@ public:
   }
 
   static char ID; // Pass identification, replacement for typeid
+
+private:
+  bool UseMemorySSA;
 };
 } // end anonymous namespace
 
@@ -1192,6 +1340,6 @@ INITIALIZE_PASS_DEPENDENCY(TargetLibraryInfoWrapperPass)
 INITIALIZE_PASS_END(DSELegacyPass, "dse", "Dead Store Elimination", false,
                     false)
 
-FunctionPass *llvm::createDeadStoreEliminationPass() {
-  return new DSELegacyPass();
+FunctionPass *llvm::createDeadStoreEliminationPass(bool UseMemorySSA) {
+  return new DSELegacyPass(UseMemorySSA);
 }
@@ -64,6 +64,7 @@ STATISTIC(NumGVNBlocks, "Number of blocks merged");
 STATISTIC(NumGVNSimpl,  "Number of instructions simplified");
 STATISTIC(NumGVNEqProp, "Number of equalities propagated");
 STATISTIC(NumPRELoad,   "Number of loads PRE'd");
+STATISTIC(NumMSSARebuilds, "Number of times MemorySSA was rebuilt");
 
 static cl::opt<bool> EnablePRE("enable-pre",
                                cl::init(true), cl::Hidden);
@@ -592,8 +593,9 @@ PreservedAnalyses GVN::run(Function &F, AnalysisManager<Function> &AM) {
   auto &DT = AM.getResult<DominatorTreeAnalysis>(F);
   auto &TLI = AM.getResult<TargetLibraryAnalysis>(F);
   auto &AA = AM.getResult<AAManager>(F);
-  auto &MemDep = AM.getResult<MemoryDependenceAnalysis>(F);
-  bool Changed = runImpl(F, AC, DT, TLI, AA, &MemDep);
+  auto *MemDep =
+      UseMemorySSA ? nullptr : &AM.getResult<MemoryDependenceAnalysis>(F);
+  bool Changed = runImpl(F, AC, DT, TLI, AA, MemDep);
   if (!Changed)
     return PreservedAnalyses::all();
   PreservedAnalyses PA;
@@ -1781,7 +1783,7 @@ static void patchAndReplaceAllUsesWith(Instruction *I, Value *Repl) {
 /// Attempt to eliminate a load, first by eliminating it
 /// locally, and then attempting non-local elimination if that fails.
 bool GVN::processLoad(LoadInst *L) {
-  if (!MD)
+  if (!MD && !UseMemorySSA)
     return false;
 
   // This code hasn't been audited for ordered or volatile memory access
@@ -1793,6 +1795,9 @@ bool GVN::processLoad(LoadInst *L) {
     return true;
   }
 
+  if (UseMemorySSA)
+    return processLoadWithMemorySSA(L);
+
   // ... to a pointer that has been loaded from before...
   MemDepResult Dep = MD->getDependency(L);
 
@@ -1830,6 +1835,98 @@ bool GVN::processLoad(LoadInst *L) {
   return false;
 }
 
+/// Build the MemorySSA of \p F if there is no up to date one.
+MemorySSA &GVN::getMemorySSA(Function &F) {
+  if (!MSSA) {
+    MSSA.reset(new MemorySSA(F, getAliasAnalysis(), DT));
+    ++NumMSSARebuilds;
+  }
+  return *MSSA;
+}
+
+/// Drop the MemorySSA after a CFG change, its phis would refer to stale
+/// predecessors otherwise.
+void GVN::invalidateMemorySSA() {
+  MSSA.reset();
+  AvailableLoads.clear();
+}
+
+/// Eliminate the load \p L using MemorySSA. The clobbering access of the load
+/// is translated into the local dependence MemoryDependenceAnalysis would have
+/// returned for it, so that the forwarding rules are shared with the MemDep
+/// path. Loads that are not clobbered by a MemoryDef are instead reused from
+/// an earlier, dominating load from the same address with the same clobber.
+bool GVN::processLoadWithMemorySSA(LoadInst *L) {
+  getMemorySSA(*L->getFunction());
+  MemoryAccess *LoadAccess = MSSA->getMemoryAccess(L);
+  if (!LoadAccess)
+    return false;
+  MemoryAccess *Clobber =
+      MSSA->getWalker()->getClobberingMemoryAccess(LoadAccess);
+
+  const DataLayout &DL = L->getModule()->getDataLayout();
+  Value *Address = L->getPointerOperand();
+  MemDepResult Dep;
+  auto *Def = dyn_cast<MemoryDef>(Clobber);
+  if (Def && !MSSA->isLiveOnEntryDef(Def)) {
+    Instruction *DepInst = Def->getMemoryInst();
+    MemoryLocation Loc = MemoryLocation::get(L);
+    AliasAnalysis *AA = getAliasAnalysis();
+    // Ordered loads are defs too, but they cannot be widened or forwarded.
+    if (isa<LoadInst>(DepInst)) {
+      Dep = MemDepResult::getUnknown();
+    } else if (auto *SI = dyn_cast<StoreInst>(DepInst)) {
+      Dep = AA->alias(MemoryLocation::get(SI), Loc) == MustAlias
+                ? MemDepResult::getDef(SI)
+                : MemDepResult::getClobber(SI);
+    } else if (isLifetimeStart(DepInst)) {
+      Dep = AA->alias(MemoryLocation(DepInst->getOperand(1)), Loc) == MustAlias
+                ? MemDepResult::getDef(DepInst)
+                : MemDepResult::getClobber(DepInst);
+    } else if (isNoAliasFn(DepInst, TLI) &&
+               GetUnderlyingObject(Address, DL) == DepInst) {
+      Dep = MemDepResult::getDef(DepInst);
+    } else {
+      Dep = MemDepResult::getClobber(DepInst);
+    }
+  }
+
+  AvailableValue AV;
+  bool Available = false;
+  if (Dep.isDef() || Dep.isClobber()) {
+    Available = AnalyzeLoadAvailability(L, Dep, Address, AV);
+  } else if (MSSA->isLiveOnEntryDef(Clobber) &&
+             isa<AllocaInst>(GetUnderlyingObject(Address, DL))) {
+    // Nothing was stored to the alloca since the function was entered.
+    AV = AvailableValue::get(UndefValue::get(L->getType()));
+    Available = true;
+  }
+
+  if (Available) {
+    Value *AvailableValue = AV.MaterializeAdjustedValue(L, L, *this);
+    patchAndReplaceAllUsesWith(L, AvailableValue);
+    markInstructionForDeletion(L);
+    ++NumGVNLoad;
+    return true;
+  }
+
+  // Otherwise reuse a dominating load that sees the same memory state.
+  if (!L->isSimple())
+    return false;
+  auto &Loads =
+      AvailableLoads[std::make_pair(Clobber, VN.lookupOrAdd(Address))];
+  for (LoadInst *Cand : Loads) {
+    if (Cand->getType() != L->getType() || !DT->dominates(Cand, L))
+      continue;
+    patchAndReplaceAllUsesWith(L, Cand);
+    markInstructionForDeletion(L);
+    ++NumGVNLoad;
+    return true;
+  }
+  Loads.push_back(L);
+  return false;
+}
+
 // In order to find a leader for a given value number at a
 // specific basic block, we first obtain the list of all Values for that number,
 // and then scan the list to find one whose block dominates the block in
@@ -2205,6 +2302,7 @@ bool GVN::runImpl(Function &F, AssumptionCache &RunAC, DominatorTree &RunDT,
   VN.setAliasAnalysis(&RunAA);
   MD = RunMD;
   VN.setMemDep(MD);
+  assert(!MSSA && AvailableLoads.empty() && "MemorySSA left from last run");
 
   bool Changed = false;
   bool ShouldContinue = true;
@@ -2249,6 +2347,7 @@ bool GVN::runImpl(Function &F, AssumptionCache &RunAC, DominatorTree &RunDT,
   // Do not cleanup DeadBlocks in cleanupGlobalSets() as it's called for each
   // iteration.
   DeadBlocks.clear();
+  invalidateMemorySSA();
 
   return Changed;
 }
@@ -2288,6 +2387,9 @@ bool GVN::processBlock(BasicBlock *BB) {
          E = InstrsToErase.end(); I != E; ++I) {
       DEBUG(dbgs() << "GVN removed: " << **I << '\n');
       if (MD) MD->removeInstruction(*I);
+      if (MSSA)
+        if (MemoryAccess *MA = MSSA->getMemoryAccess(*I))
+          MSSA->removeMemoryAccess(MA);
       DEBUG(verifyRemoved(*I));
       (*I)->eraseFromParent();
     }
@@ -2509,6 +2611,8 @@ BasicBlock *GVN::splitCriticalEdges(BasicBlock *Pred, BasicBlock *Succ) {
       SplitCriticalEdge(Pred, Succ, CriticalEdgeSplittingOptions(DT));
   if (MD)
     MD->invalidateCachedPredecessors();
+  if (BB)
+    invalidateMemorySSA();
   return BB;
 }
 
@@ -2523,6 +2627,7 @@ bool GVN::splitCriticalEdges() {
                       CriticalEdgeSplittingOptions(DT));
   } while (!toSplit.empty());
   if (MD) MD->invalidateCachedPredecessors();
+  invalidateMemorySSA();
   return true;
 }
 
@@ -2555,6 +2660,7 @@ void GVN::cleanupGlobalSets() {
   VN.clear();
   LeaderTable.clear();
   TableAllocator.Reset();
+  AvailableLoads.clear();
 }
 
 /// Verify that the specified instruction does not occur in our
@@ -2702,8 +2808,8 @@ void GVN::assignValNumForDeadCode() {
 class llvm::gvn::GVNLegacyPass : public FunctionPass {
 public:
   static char ID; // Pass identification, replacement for typeid
-  explicit GVNLegacyPass(bool NoLoads = false)
-      : FunctionPass(ID), NoLoads(NoLoads) {
+  explicit GVNLegacyPass(bool NoLoads = false, bool UseMemorySSA = false)
+      : FunctionPass(ID), NoLoads(NoLoads), Impl(UseMemorySSA && !NoLoads) {
     initializeGVNLegacyPassPass(*PassRegistry::getPassRegistry());
   }
 
@@ -2716,15 +2822,16 @@ public:
         getAnalysis<DominatorTreeWrapperPass>().getDomTree(),
         getAnalysis<TargetLibraryInfoWrapperPass>().getTLI(),
         getAnalysis<AAResultsWrapperPass>().getAAResults(),
-        NoLoads ? nullptr
-                : &getAnalysis<MemoryDependenceWrapperPass>().getMemDep());
+        NoLoads || Impl.UseMemorySSA
+            ? nullptr
+            : &getAnalysis<MemoryDependenceWrapperPass>().getMemDep());
   }
 
   void getAnalysisUsage(AnalysisUsage &AU) const override {
     AU.addRequired<AssumptionCacheTracker>();
     AU.addRequired<DominatorTreeWrapperPass>();
     AU.addRequired<TargetLibraryInfoWrapperPass>();
-    if (!NoLoads)
+    if (!NoLoads && !Impl.UseMemorySSA)
       AU.addRequired<MemoryDependenceWrapperPass>();
     AU.addRequired<AAResultsWrapperPass>();
 
@@ -2740,8 +2847,8 @@ private:
 char GVNLegacyPass::ID = 0;
 
 // The public interface to this file...
-FunctionPass *llvm::createGVNPass(bool NoLoads) {
-  return new GVNLegacyPass(NoLoads);
+FunctionPass *llvm::createGVNPass(bool NoLoads, bool UseMemorySSA) {
+  return new GVNLegacyPass(NoLoads, UseMemorySSA);
 }
 
 INITIALIZE_PASS_BEGIN(GVNLegacyPass, "gvn", "Global Value Numbering", false, false)
@@ -251,7 +251,7 @@ namespace {
     void EmitPreheaderBranchOnCondition(Value *LIC, Constant *Val,
                                         BasicBlock *TrueDest,
                                         BasicBlock *FalseDest,
-                                        Instruction *InsertPt,
+                                        BranchInst *OldBranch,
                                         TerminatorInst *TI);
 
     void SimplifyCode(std::vector<Instruction*> &Worklist, Loop *L);
@@ -477,9 +477,6 @@ bool LoopUnswitch::runOnLoop(Loop *L, LPPassManager &LPM_Ref) {
     Changed |= processCurrentLoop();
   } while(redoLoop);
 
-  // FIXME: Reconstruct dom info, because it is not preserved properly.
-  if (Changed)
-    DT->recalculate(*F);
   return Changed;
 }
 
@@ -779,11 +776,11 @@ static void copyMetadata(Instruction *DstInst, const Instruction *SrcInst,
 }
 
 /// Emit a conditional branch on two values if LIC == Val, branch to TrueDst,
-/// otherwise branch to FalseDest. Insert the code immediately before InsertPt.
+/// otherwise branch to FalseDest. The new branch replaces OldBranch.
 void LoopUnswitch::EmitPreheaderBranchOnCondition(Value *LIC, Constant *Val,
                                                   BasicBlock *TrueDest,
                                                   BasicBlock *FalseDest,
-                                                  Instruction *InsertPt,
+                                                  BranchInst *OldBranch,
                                                   TerminatorInst *TI) {
   // Insert a conditional branch on LIC to the two preheaders.  The original
   // code is the true version and the new code is the false version.
@@ -791,7 +788,7 @@ void LoopUnswitch::EmitPreheaderBranchOnCondition(Value *LIC, Constant *Val,
   bool Swapped = false;
   if (!isa<ConstantInt>(Val) ||
       Val->getType() != Type::getInt1Ty(LIC->getContext()))
-    BranchVal = new ICmpInst(InsertPt, ICmpInst::ICMP_EQ, LIC, Val);
+    BranchVal = new ICmpInst(OldBranch, ICmpInst::ICMP_EQ, LIC, Val);
   else if (Val != ConstantInt::getTrue(Val->getContext())) {
     // We want to enter the new loop when the condition is true.
     std::swap(TrueDest, FalseDest);
@@ -799,14 +796,48 @@ void LoopUnswitch::EmitPreheaderBranchOnCondition(Value *LIC, Constant *Val,
   }
 
   // Insert the new branch.
-  BranchInst *BI = BranchInst::Create(TrueDest, FalseDest, BranchVal, InsertPt);
+  BranchInst *BI = BranchInst::Create(TrueDest, FalseDest, BranchVal,
+                                      OldBranch);
   copyMetadata(BI, TI, Swapped);
 
   // If either edge is critical, split it. This helps preserve LoopSimplify
-  // form for enclosing loops.
-  auto Options = CriticalEdgeSplittingOptions(DT, LI).setPreserveLCSSA();
+  // form for enclosing loops. The dominator tree is only brought up to date
+  // once the old branch is gone, so the edges are split without it.
+  BasicBlock *Pred = BI->getParent();
+  BasicBlock *Dests[] = {BI->getSuccessor(0), BI->getSuccessor(1)};
+  SmallVector<BasicBlock *, 8> DestPreds[2];
+  for (unsigned I = 0; I != 2; ++I)
+    DestPreds[I].append(pred_begin(Dests[I]), pred_end(Dests[I]));
+  auto Options = CriticalEdgeSplittingOptions(nullptr, LI).setPreserveLCSSA();
   SplitCriticalEdge(BI, 0, Options);
   SplitCriticalEdge(BI, 1, Options);
+
+  // Replace the old branch, and tell the dominator tree about all the edges
+  // that changed at once.
+  SmallVector<DominatorTree::UpdateType, 8> Updates;
+  for (BasicBlock *OldSucc : OldBranch->successors())
+    Updates.push_back({DominatorTree::Delete, Pred, OldSucc});
+  LPM->deleteSimpleAnalysisValue(OldBranch, currentLoop);
+  OldBranch->eraseFromParent();
+  for (unsigned I = 0; I != 2; ++I) {
+    BasicBlock *Succ = BI->getSuccessor(I);
+    Updates.push_back({DominatorTree::Insert, Pred, Succ});
+    if (Succ != Dests[I])
+      Updates.push_back({DominatorTree::Insert, Succ, Dests[I]});
+    // Splitting an edge that leaves a loop may also have moved the loop's
+    // other edges into the destination onto a new exit block.
+    for (BasicBlock *P : DestPreds[I]) {
+      if (P == Pred || is_contained(predecessors(Dests[I]), P))
+        continue;
+      Updates.push_back({DominatorTree::Delete, P, Dests[I]});
+      for (BasicBlock *NewExit : successors(P))
+        if (!DT->getNode(NewExit)) {
+          Updates.push_back({DominatorTree::Insert, P, NewExit});
+          Updates.push_back({DominatorTree::Insert, NewExit, Dests[I]});
+        }
+    }
+  }
+  DT->applyUpdates(Updates);
 }
 
 /// Given a loop that has a trivial unswitchable condition in it (a cond branch
@@ -841,10 +872,9 @@ void LoopUnswitch::UnswitchTrivialCondition(Loop *L, Value *Cond, Constant *Val,
 
   // Okay, now we have a position to branch from and a position to branch to,
   // insert the new conditional branch.
-  EmitPreheaderBranchOnCondition(Cond, Val, NewExit, NewPH,
-                                 loopPreheader->getTerminator(), TI);
-  LPM->deleteSimpleAnalysisValue(loopPreheader->getTerminator(), L);
-  loopPreheader->getTerminator()->eraseFromParent();
+  EmitPreheaderBranchOnCondition(
+      Cond, Val, NewExit, NewPH,
+      cast<BranchInst>(loopPreheader->getTerminator()), TI);
 
   // We need to reprocess this loop, it could be unswitched again.
   redoLoop = true;
@@ -1144,8 +1174,6 @@ void LoopUnswitch::UnswitchNontrivialCondition(Value *LIC, Constant *Val,
   // Emit the new branch that selects between the two versions of this loop.
   EmitPreheaderBranchOnCondition(LIC, Val, NewBlocks[0], LoopBlocks[0], OldBR,
                                  TI);
-  LPM->deleteSimpleAnalysisValue(OldBR, L);
-  OldBR->eraseFromParent();
 
   LoopProcessWorklist.push_back(NewLoop);
   redoLoop = true;
@@ -1306,10 +1334,8 @@ void LoopUnswitch::RewriteLoopBodyWithConditionConstant(Loop *L, Value *LIC,
          PHINode *PN = dyn_cast<PHINode>(II); ++II)
       PN->setIncomingValue(PN->getBasicBlockIndex(Switch),
                            UndefValue::get(PN->getType()));
-    // Tell the domtree about the new block. We don't fully update the
-    // domtree here -- instead we force it to do a full recomputation
-    // after the pass is complete -- but we do need to inform it of
-    // new blocks.
+    // Tell the domtree about the new block. The old edge is kept, so nothing
+    // else changes.
     DT->addNewBlock(Abort, NewSISucc);
   }
 
@@ -1383,6 +1409,16 @@ void LoopUnswitch::SimplifyCode(std::vector<Instruction*> &Worklist, Loop *L) {
         BI->eraseFromParent();
         RemoveFromWorklist(BI, Worklist);
 
+        // Pred now dominates what Succ dominated.
+        if (DomTreeNode *SuccNode = DT->getNode(Succ)) {
+          DomTreeNode *PredNode = DT->getNode(Pred);
+          SmallVector<DomTreeNode *, 8> Children(SuccNode->begin(),
+                                                 SuccNode->end());
+          for (DomTreeNode *Child : Children)
+            DT->changeImmediateDominator(Child, PredNode);
+          DT->eraseNode(Succ);
+        }
+
         // Remove Succ from the loop tree.
         LI->removeBlock(Succ);
         LPM->deleteSimpleAnalysisValue(Succ, L);
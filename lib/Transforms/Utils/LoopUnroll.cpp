@@ -465,8 +465,9 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount, bool Force,
       // Update DomTree: since we just copy the loop body, and each copy has a
       // dedicated entry block (copy of the header block), this header's copy
       // dominates all copied blocks. That means, dominance relations in the
-      // copied body are the same as in the original body.
-      if (DT) {
+      // copied body are the same as in the original body. A partially unrolled
+      // loop gets its updates in one batch once the copies are wired up.
+      if (DT && CompletelyUnroll) {
         if (*BB == Header)
           DT->addNewBlock(New, Latches[It - 1]);
         else {
@@ -504,6 +505,9 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount, bool Force,
     }
   }
 
+  SmallVector<BasicBlock *, 2> OrigLatchSuccs(succ_begin(LatchBlock),
+                                              succ_end(LatchBlock));
+
   // Now that all the basic blocks for the unrolled iterations are in place,
   // set up the branches to connect them.
   for (unsigned i = 0, e = Latches.size(); i != e; ++i) {
@@ -563,7 +567,7 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount, bool Force,
   // the previous idom. This is equivalent to the nearest common dominator of
   // the previous idom and the first latch, which dominates all copies of the
   // previous idom.
-  if (DT && Count > 1) {
+  if (DT && CompletelyUnroll && Count > 1) {
     for (auto *BB : OriginalLoopBlocks) {
       auto *BBDomNode = DT->getNode(BB);
       SmallVector<BasicBlock *, 16> ChildrenToUpdate;
@@ -578,6 +582,21 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount, bool Force,
     }
   }
 
+  // In a partially unrolled loop, the edges of the copies are new, and the
+  // original latch now branches to the second copy instead of the header.
+  if (DT && !CompletelyUnroll) {
+    SmallVector<DominatorTree::UpdateType, 32> Updates;
+    for (BasicBlock *Succ : OrigLatchSuccs)
+      Updates.push_back({DominatorTree::Delete, LatchBlock, Succ});
+    for (BasicBlock *Succ : successors(LatchBlock))
+      Updates.push_back({DominatorTree::Insert, LatchBlock, Succ});
+    for (unsigned i = OriginalLoopBlocks.size(), e = UnrolledLoopBlocks.size();
+         i != e; ++i)
+      for (BasicBlock *Succ : successors(UnrolledLoopBlocks[i]))
+        Updates.push_back({DominatorTree::Insert, UnrolledLoopBlocks[i], Succ});
+    DT->applyUpdates(Updates);
+  }
+
   // Merge adjacent basic blocks, if possible.
   SmallPtrSet<Loop *, 4> ForgottenLoops;
   for (BasicBlock *Latch : Latches) {
@@ -599,11 +618,7 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount, bool Force,
   // whole function's cache.
   AC->clear();
 
-  // FIXME: We only preserve DT info for complete unrolling now. Incrementally
-  // updating domtree after partial loop unrolling should also be easy.
-  if (DT && !CompletelyUnroll)
-    DT->recalculate(*L->getHeader()->getParent());
-  else if (DT)
+  if (DT)
     DEBUG(DT->verifyDomTree());
 
   // Simplify any new induction variables in the partially unrolled loop.
@@ -673,6 +673,21 @@ bool llvm::UnrollRuntimeLoopRemainder(Loop *L, unsigned Count,
     ConnectProlog(L, BECount, Count, PrologExit, PreHeader, NewPreHeader,
                   VMap, DT, LI, PreserveLCSSA);
   }
+
+  // The remainder loop and the branches around the loops were wired up without
+  // updating the dominator tree, tell it about all of them at once.
+  if (DT) {
+    SmallVector<DominatorTree::UpdateType, 16> Updates;
+    Updates.push_back({DominatorTree::Insert, PreHeader, RemainderLoop});
+    Updates.push_back({DominatorTree::Delete, InsertTop, InsertBot});
+    Updates.push_back({DominatorTree::Insert, InsertTop, NewBlocks[0]});
+    Updates.push_back({DominatorTree::Insert,
+                       UseEpilogRemainder ? NewExit : PrologExit, Exit});
+    for (BasicBlock *BB : NewBlocks)
+      for (BasicBlock *Succ : successors(BB))
+        Updates.push_back({DominatorTree::Insert, BB, Succ});
+    DT->applyUpdates(Updates);
+  }
   NumRuntimeUnrolled++;
   return true;
 }
@@ -203,6 +203,47 @@ static void externalize(GlobalValue *GV) {
     GV->setName("__llvmsplit_unnamed");
 }
 
+/// Turn the definitions of \p M for which \p IsInPartition returns false into
+/// external declarations, like CloneModule does for the other partitions.
+static void
+removeDefinitions(Module &M,
+                  function_ref<bool(const GlobalValue *)> IsInPartition) {
+  // Blockaddress users are in the partition of their function, drop the
+  // initializers before the bodies they may refer to.
+  for (GlobalVariable &GV : M.globals())
+    if (!GV.isDeclaration() && !IsInPartition(&GV)) {
+      GV.setInitializer(nullptr);
+      GV.setLinkage(GlobalValue::ExternalLinkage);
+      GV.setComdat(nullptr);
+      GV.clearMetadata();
+    }
+  for (Function &F : M)
+    if (!F.isDeclaration() && !IsInPartition(&F)) {
+      F.deleteBody();
+      F.setComdat(nullptr);
+    }
+
+  // An alias cannot act as an external reference, so it is replaced with
+  // either a function or a global variable depending on the value type.
+  for (auto I = M.alias_begin(), E = M.alias_end(); I != E;) {
+    GlobalAlias &GA = *I++;
+    if (IsInPartition(&GA))
+      continue;
+    GlobalValue *GV;
+    if (GA.getValueType()->isFunctionTy())
+      GV = Function::Create(cast<FunctionType>(GA.getValueType()),
+                            GlobalValue::ExternalLinkage, "", &M);
+    else
+      GV = new GlobalVariable(M, GA.getValueType(), false,
+                              GlobalValue::ExternalLinkage, nullptr, "",
+                              nullptr, GA.getThreadLocalMode(),
+                              GA.getType()->getAddressSpace());
+    GV->takeName(&GA);
+    GA.replaceAllUsesWith(GV);
+    GA.eraseFromParent();
+  }
+}
+
 // Returns whether GV should be in partition (0-based) I of N.
 static bool isInPartition(const GlobalValue *GV, unsigned I, unsigned N) {
   if (auto *GIS = dyn_cast<GlobalIndirectSymbol>(GV))
@@ -245,17 +286,22 @@ void llvm::SplitModule(
   ClusterIDMapType ClusterIDMap;
   findPartitions(M.get(), ClusterIDMap, N);
 
-  // FIXME: We should be able to reuse M as the last partition instead of
-  // cloning it.
+  // The last partition reuses M instead of cloning it.
   for (unsigned I = 0; I < N; ++I) {
-    ValueToValueMapTy VMap;
-    std::unique_ptr<Module> MPart(
-        CloneModule(M.get(), VMap, [&](const GlobalValue *GV) {
-          if (ClusterIDMap.count(GV))
-            return (ClusterIDMap[GV] == I);
-          else
-            return isInPartition(GV, I, N);
-        }));
+    auto IsInPartition = [&](const GlobalValue *GV) {
+      if (ClusterIDMap.count(GV))
+        return (ClusterIDMap[GV] == I);
+      else
+        return isInPartition(GV, I, N);
+    };
+    std::unique_ptr<Module> MPart;
+    if (I == N - 1) {
+      removeDefinitions(*M, IsInPartition);
+      MPart = std::move(M);
+    } else {
+      ValueToValueMapTy VMap;
+      MPart = CloneModule(M.get(), VMap, IsInPartition);
+    }
     if (I != 0)
       MPart->setModuleInlineAsm("");
     ModuleCallback(std::move(MPart));
@@ -0,0 +1,51 @@
+; REQUIRES: asserts
+; RUN: opt < %s -aa-pipeline=basic-aa -passes=aa-eval \
+; RUN:   -print-all-alias-modref-info -disable-output 2>&1 | FileCheck %s
+; RUN: opt < %s -aa-pipeline=basic-aa -passes=aa-eval -basicaa-cache-limit=0 \
+; RUN:   -print-all-alias-modref-info -disable-output 2>&1 | FileCheck %s
+; RUN: opt < %s -aa-pipeline=basic-aa -passes='aa-eval,aa-eval' -stats \
+; RUN:   -disable-output 2>&1 | FileCheck %s --check-prefix=REUSE
+; RUN: opt < %s -aa-pipeline=basic-aa -passes='aa-eval,dce,aa-eval' -stats \
+; RUN:   -disable-output 2>&1 | FileCheck %s --check-prefix=FLUSH
+; RUN: opt < %s -basicaa -aa-eval -aa-eval -stats -disable-output 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=LEGACY
+
+; The answers are the same with and without the caches.
+; CHECK-LABEL: Function: f
+; CHECK-DAG: MustAlias: i32* %a, i64* %b
+; CHECK-DAG: NoAlias: i32* %a, i32* %b1
+; CHECK-DAG: NoAlias: i32* %b1, i64* %b
+; CHECK-DAG: NoAlias: i32* %p, i32* %unused
+; CHECK-DAG: PartialAlias: i32* %a, i32* %c
+
+; The second evaluation only finds answers the first one cached, and reuses
+; the decompositions of the GEPs across queries.
+; REUSE-NOT: Number of times the alias caches were flushed
+; REUSE: 15 basicaa - Number of alias queries answered by the cache
+; REUSE: 15 basicaa - Number of alias queries missing the cache
+
+; DCE deletes the unused GEP, which flushes the caches. The function pipeline
+; as a whole changed the function, so the second evaluation's answers are
+; dropped at its end.
+; FLUSH: 2 basicaa - Number of times the alias caches were flushed
+; FLUSH-NOT: Number of alias queries answered by the cache
+; FLUSH: 25 basicaa - Number of alias queries missing the cache
+
+; The legacy pass manager result does not cache across queries.
+; LEGACY-NOT: Number of alias queries answered by the cache
+; LEGACY-NOT: Number of alias queries missing the cache
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+define void @f(i32* %p, i64 %i, i64 %j) {
+  %a = getelementptr inbounds i32, i32* %p, i64 %i
+  %b = bitcast i32* %a to i64*
+  %b1 = getelementptr inbounds i32, i32* %a, i64 2
+  %c = getelementptr inbounds i32, i32* %p, i64 %j
+  %unused = getelementptr inbounds i32, i32* %p, i64 3
+  store i32 0, i32* %a
+  store i64 1, i64* %b
+  store i32 2, i32* %b1
+  store i32 3, i32* %c
+  ret void
+}
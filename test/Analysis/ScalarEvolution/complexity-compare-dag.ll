@@ -0,0 +1,185 @@
+; RUN: opt < %s -indvars -disable-output
+
+; Both ladders compare equal step by step, and so do the expressions built
+; on them, so canonicalizing the trip count of the loop takes time exponential
+; in the height of the ladders unless the comparisons are memoized. Generated
+; with utils/create_scev_benchmark.py 40.
+
+define void @f(i64* %p, i64* %q) {
+entry:
+  %a.x0 = load i64, i64* %p
+  %a.y0 = load i64, i64* %p
+  %a.x1 = mul i64 %a.x0, %a.y0
+  %a.y1 = add i64 %a.x0, %a.y0
+  %a.x2 = mul i64 %a.x1, %a.y1
+  %a.y2 = add i64 %a.x1, %a.y1
+  %a.x3 = mul i64 %a.x2, %a.y2
+  %a.y3 = add i64 %a.x2, %a.y2
+  %a.x4 = mul i64 %a.x3, %a.y3
+  %a.y4 = add i64 %a.x3, %a.y3
+  %a.x5 = mul i64 %a.x4, %a.y4
+  %a.y5 = add i64 %a.x4, %a.y4
+  %a.x6 = mul i64 %a.x5, %a.y5
+  %a.y6 = add i64 %a.x5, %a.y5
+  %a.x7 = mul i64 %a.x6, %a.y6
+  %a.y7 = add i64 %a.x6, %a.y6
+  %a.x8 = mul i64 %a.x7, %a.y7
+  %a.y8 = add i64 %a.x7, %a.y7
+  %a.x9 = mul i64 %a.x8, %a.y8
+  %a.y9 = add i64 %a.x8, %a.y8
+  %a.x10 = mul i64 %a.x9, %a.y9
+  %a.y10 = add i64 %a.x9, %a.y9
+  %a.x11 = mul i64 %a.x10, %a.y10
+  %a.y11 = add i64 %a.x10, %a.y10
+  %a.x12 = mul i64 %a.x11, %a.y11
+  %a.y12 = add i64 %a.x11, %a.y11
+  %a.x13 = mul i64 %a.x12, %a.y12
+  %a.y13 = add i64 %a.x12, %a.y12
+  %a.x14 = mul i64 %a.x13, %a.y13
+  %a.y14 = add i64 %a.x13, %a.y13
+  %a.x15 = mul i64 %a.x14, %a.y14
+  %a.y15 = add i64 %a.x14, %a.y14
+  %a.x16 = mul i64 %a.x15, %a.y15
+  %a.y16 = add i64 %a.x15, %a.y15
+  %a.x17 = mul i64 %a.x16, %a.y16
+  %a.y17 = add i64 %a.x16, %a.y16
+  %a.x18 = mul i64 %a.x17, %a.y17
+  %a.y18 = add i64 %a.x17, %a.y17
+  %a.x19 = mul i64 %a.x18, %a.y18
+  %a.y19 = add i64 %a.x18, %a.y18
+  %a.x20 = mul i64 %a.x19, %a.y19
+  %a.y20 = add i64 %a.x19, %a.y19
+  %a.x21 = mul i64 %a.x20, %a.y20
+  %a.y21 = add i64 %a.x20, %a.y20
+  %a.x22 = mul i64 %a.x21, %a.y21
+  %a.y22 = add i64 %a.x21, %a.y21
+  %a.x23 = mul i64 %a.x22, %a.y22
+  %a.y23 = add i64 %a.x22, %a.y22
+  %a.x24 = mul i64 %a.x23, %a.y23
+  %a.y24 = add i64 %a.x23, %a.y23
+  %a.x25 = mul i64 %a.x24, %a.y24
+  %a.y25 = add i64 %a.x24, %a.y24
+  %a.x26 = mul i64 %a.x25, %a.y25
+  %a.y26 = add i64 %a.x25, %a.y25
+  %a.x27 = mul i64 %a.x26, %a.y26
+  %a.y27 = add i64 %a.x26, %a.y26
+  %a.x28 = mul i64 %a.x27, %a.y27
+  %a.y28 = add i64 %a.x27, %a.y27
+  %a.x29 = mul i64 %a.x28, %a.y28
+  %a.y29 = add i64 %a.x28, %a.y28
+  %a.x30 = mul i64 %a.x29, %a.y29
+  %a.y30 = add i64 %a.x29, %a.y29
+  %a.x31 = mul i64 %a.x30, %a.y30
+  %a.y31 = add i64 %a.x30, %a.y30
+  %a.x32 = mul i64 %a.x31, %a.y31
+  %a.y32 = add i64 %a.x31, %a.y31
+  %a.x33 = mul i64 %a.x32, %a.y32
+  %a.y33 = add i64 %a.x32, %a.y32
+  %a.x34 = mul i64 %a.x33, %a.y33
+  %a.y34 = add i64 %a.x33, %a.y33
+  %a.x35 = mul i64 %a.x34, %a.y34
+  %a.y35 = add i64 %a.x34, %a.y34
+  %a.x36 = mul i64 %a.x35, %a.y35
+  %a.y36 = add i64 %a.x35, %a.y35
+  %a.x37 = mul i64 %a.x36, %a.y36
+  %a.y37 = add i64 %a.x36, %a.y36
+  %a.x38 = mul i64 %a.x37, %a.y37
+  %a.y38 = add i64 %a.x37, %a.y37
+  %a.x39 = mul i64 %a.x38, %a.y38
+  %a.y39 = add i64 %a.x38, %a.y38
+  %a.x40 = mul i64 %a.x39, %a.y39
+  %a.y40 = add i64 %a.x39, %a.y39
+  %b.x0 = load i64, i64* %q
+  %b.y0 = load i64, i64* %q
+  %b.x1 = mul i64 %b.x0, %b.y0
+  %b.y1 = add i64 %b.x0, %b.y0
+  %b.x2 = mul i64 %b.x1, %b.y1
+  %b.y2 = add i64 %b.x1, %b.y1
+  %b.x3 = mul i64 %b.x2, %b.y2
+  %b.y3 = add i64 %b.x2, %b.y2
+  %b.x4 = mul i64 %b.x3, %b.y3
+  %b.y4 = add i64 %b.x3, %b.y3
+  %b.x5 = mul i64 %b.x4, %b.y4
+  %b.y5 = add i64 %b.x4, %b.y4
+  %b.x6 = mul i64 %b.x5, %b.y5
+  %b.y6 = add i64 %b.x5, %b.y5
+  %b.x7 = mul i64 %b.x6, %b.y6
+  %b.y7 = add i64 %b.x6, %b.y6
+  %b.x8 = mul i64 %b.x7, %b.y7
+  %b.y8 = add i64 %b.x7, %b.y7
+  %b.x9 = mul i64 %b.x8, %b.y8
+  %b.y9 = add i64 %b.x8, %b.y8
+  %b.x10 = mul i64 %b.x9, %b.y9
+  %b.y10 = add i64 %b.x9, %b.y9
+  %b.x11 = mul i64 %b.x10, %b.y10
+  %b.y11 = add i64 %b.x10, %b.y10
+  %b.x12 = mul i64 %b.x11, %b.y11
+  %b.y12 = add i64 %b.x11, %b.y11
+  %b.x13 = mul i64 %b.x12, %b.y12
+  %b.y13 = add i64 %b.x12, %b.y12
+  %b.x14 = mul i64 %b.x13, %b.y13
+  %b.y14 = add i64 %b.x13, %b.y13
+  %b.x15 = mul i64 %b.x14, %b.y14
+  %b.y15 = add i64 %b.x14, %b.y14
+  %b.x16 = mul i64 %b.x15, %b.y15
+  %b.y16 = add i64 %b.x15, %b.y15
+  %b.x17 = mul i64 %b.x16, %b.y16
+  %b.y17 = add i64 %b.x16, %b.y16
+  %b.x18 = mul i64 %b.x17, %b.y17
+  %b.y18 = add i64 %b.x17, %b.y17
+  %b.x19 = mul i64 %b.x18, %b.y18
+  %b.y19 = add i64 %b.x18, %b.y18
+  %b.x20 = mul i64 %b.x19, %b.y19
+  %b.y20 = add i64 %b.x19, %b.y19
+  %b.x21 = mul i64 %b.x20, %b.y20
+  %b.y21 = add i64 %b.x20, %b.y20
+  %b.x22 = mul i64 %b.x21, %b.y21
+  %b.y22 = add i64 %b.x21, %b.y21
+  %b.x23 = mul i64 %b.x22, %b.y22
+  %b.y23 = add i64 %b.x22, %b.y22
+  %b.x24 = mul i64 %b.x23, %b.y23
+  %b.y24 = add i64 %b.x23, %b.y23
+  %b.x25 = mul i64 %b.x24, %b.y24
+  %b.y25 = add i64 %b.x24, %b.y24
+  %b.x26 = mul i64 %b.x25, %b.y25
+  %b.y26 = add i64 %b.x25, %b.y25
+  %b.x27 = mul i64 %b.x26, %b.y26
+  %b.y27 = add i64 %b.x26, %b.y26
+  %b.x28 = mul i64 %b.x27, %b.y27
+  %b.y28 = add i64 %b.x27, %b.y27
+  %b.x29 = mul i64 %b.x28, %b.y28
+  %b.y29 = add i64 %b.x28, %b.y28
+  %b.x30 = mul i64 %b.x29, %b.y29
+  %b.y30 = add i64 %b.x29, %b.y29
+  %b.x31 = mul i64 %b.x30, %b.y30
+  %b.y31 = add i64 %b.x30, %b.y30
+  %b.x32 = mul i64 %b.x31, %b.y31
+  %b.y32 = add i64 %b.x31, %b.y31
+  %b.x33 = mul i64 %b.x32, %b.y32
+  %b.y33 = add i64 %b.x32, %b.y32
+  %b.x34 = mul i64 %b.x33, %b.y33
+  %b.y34 = add i64 %b.x33, %b.y33
+  %b.x35 = mul i64 %b.x34, %b.y34
+  %b.y35 = add i64 %b.x34, %b.y34
+  %b.x36 = mul i64 %b.x35, %b.y35
+  %b.y36 = add i64 %b.x35, %b.y35
+  %b.x37 = mul i64 %b.x36, %b.y36
+  %b.y37 = add i64 %b.x36, %b.y36
+  %b.x38 = mul i64 %b.x37, %b.y37
+  %b.y38 = add i64 %b.x37, %b.y37
+  %b.x39 = mul i64 %b.x38, %b.y38
+  %b.y39 = add i64 %b.x38, %b.y38
+  %b.x40 = mul i64 %b.x39, %b.y39
+  %b.y40 = add i64 %b.x39, %b.y39
+  %n = add i64 %a.x40, %b.x40
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %i.next = add nuw i64 %i, 1
+  %c = icmp ult i64 %i.next, %n
+  br i1 %c, label %loop, label %exit
+
+exit:
+  ret void
+}
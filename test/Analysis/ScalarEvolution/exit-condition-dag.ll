@@ -0,0 +1,64 @@
+; RUN: opt < %s -analyze -scalar-evolution | FileCheck %s
+; RUN: opt < %s -indvars -disable-output
+; RUN: opt < %s -loop-unroll -disable-output
+
+; Each 'and' of the exit condition uses its operand twice, so computing the
+; exit limit of the loop visits 2^40 paths through the condition unless the
+; exit limits of its operands are memoized. Generated with
+; utils/create_scev_benchmark.py --exit-condition 40.
+
+; CHECK: Loop %loop: backedge-taken count is (-1 + %n)
+
+define void @f(i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %i.next = add i32 %i, 1
+  %c0 = icmp ne i32 %i.next, %n
+  %c1 = and i1 %c0, %c0
+  %c2 = and i1 %c1, %c1
+  %c3 = and i1 %c2, %c2
+  %c4 = and i1 %c3, %c3
+  %c5 = and i1 %c4, %c4
+  %c6 = and i1 %c5, %c5
+  %c7 = and i1 %c6, %c6
+  %c8 = and i1 %c7, %c7
+  %c9 = and i1 %c8, %c8
+  %c10 = and i1 %c9, %c9
+  %c11 = and i1 %c10, %c10
+  %c12 = and i1 %c11, %c11
+  %c13 = and i1 %c12, %c12
+  %c14 = and i1 %c13, %c13
+  %c15 = and i1 %c14, %c14
+  %c16 = and i1 %c15, %c15
+  %c17 = and i1 %c16, %c16
+  %c18 = and i1 %c17, %c17
+  %c19 = and i1 %c18, %c18
+  %c20 = and i1 %c19, %c19
+  %c21 = and i1 %c20, %c20
+  %c22 = and i1 %c21, %c21
+  %c23 = and i1 %c22, %c22
+  %c24 = and i1 %c23, %c23
+  %c25 = and i1 %c24, %c24
+  %c26 = and i1 %c25, %c25
+  %c27 = and i1 %c26, %c26
+  %c28 = and i1 %c27, %c27
+  %c29 = and i1 %c28, %c28
+  %c30 = and i1 %c29, %c29
+  %c31 = and i1 %c30, %c30
+  %c32 = and i1 %c31, %c31
+  %c33 = and i1 %c32, %c32
+  %c34 = and i1 %c33, %c33
+  %c35 = and i1 %c34, %c34
+  %c36 = and i1 %c35, %c35
+  %c37 = and i1 %c36, %c36
+  %c38 = and i1 %c37, %c37
+  %c39 = and i1 %c38, %c38
+  %c40 = and i1 %c39, %c39
+  br i1 %c40, label %loop, label %exit
+
+exit:
+  ret void
+}
@@ -0,0 +1,72 @@
+; RUN: opt < %s -analyze -scalar-evolution | FileCheck %s
+; RUN: opt < %s -analyze -scalar-evolution \
+; RUN:   -scalar-evolution-max-folding-work=2 | FileCheck %s --check-prefix=BUDGET
+
+; Once the folding budget of the function is spent, new values are left as
+; SCEVUnknowns.
+
+define void @f(i64 %a, i64 %b) {
+entry:
+; CHECK-LABEL: Classifying expressions for: @f
+; CHECK: %x = add i64 %a, %b
+; CHECK-NEXT: -->  (%a + %b)
+; CHECK: %y = mul i64 %x, 3
+; CHECK-NEXT: -->  (3 * (%a + %b))
+; CHECK: %z = add i64 %y, %a
+; CHECK-NEXT: -->  ((3 * %b) + (4 * %a))
+; CHECK: %w = add i64 %z, 1
+; CHECK-NEXT: -->  (1 + (3 * %b) + (4 * %a))
+
+; BUDGET-LABEL: Classifying expressions for: @f
+; BUDGET: %x = add i64 %a, %b
+; BUDGET-NEXT: -->  (%a + %b)
+; BUDGET: %y = mul i64 %x, 3
+; BUDGET-NEXT: -->  %y
+; BUDGET: %z = add i64 %y, %a
+; BUDGET-NEXT: -->  %z
+; BUDGET: %w = add i64 %z, 1
+; BUDGET-NEXT: -->  %w
+  %x = add i64 %a, %b
+  %y = mul i64 %x, 3
+  %z = add i64 %y, %a
+  %w = add i64 %z, 1
+  ret void
+}
+
+; The budget is per function.
+define void @g(i64 %a, i64 %b) {
+entry:
+; CHECK-LABEL: Classifying expressions for: @g
+; CHECK: %x = add i64 %a, %b
+; CHECK-NEXT: -->  (%a + %b)
+
+; BUDGET-LABEL: Classifying expressions for: @g
+; BUDGET: %x = add i64 %a, %b
+; BUDGET-NEXT: -->  (%a + %b)
+  %x = add i64 %a, %b
+  ret void
+}
+
+; The sums and products clients ask for are folded whatever the budget left, so
+; that passes relying on e.g. the distance between two add recurrences being a
+; constant keep working once the budget is spent.
+; RUN: opt < %s -O2 -loop-reduce -disable-output \
+; RUN:   -scalar-evolution-max-folding-work=3
+define void @forward(i32* %a, i64 %n) {
+; CHECK-LABEL: Classifying expressions for: @forward
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %i.next = add nuw nsw i64 %i, 1
+  %p = getelementptr inbounds i32, i32* %a, i64 %i
+  %q = getelementptr inbounds i32, i32* %a, i64 %i.next
+  %v = load i32, i32* %p
+  store i32 %v, i32* %q
+  %c = icmp slt i64 %i.next, %n
+  br i1 %c, label %loop, label %exit
+
+exit:
+  ret void
+}
@@ -0,0 +1,95 @@
+; Check that large module-level metadata blocks get an index, and that the
+; metadata they contain is only loaded on demand when the module is loaded
+; lazily.
+; REQUIRES: asserts
+
+; RUN: llvm-as < %s -o %t.bc
+; RUN: llvm-bcanalyzer -dump %t.bc | FileCheck %s --check-prefix=BC
+; BC: <METADATA_BLOCK
+; BC: <INDEX_OFFSET
+; BC: <INDEX
+; BC: </METADATA_BLOCK>
+
+; Smaller blocks don't get one.
+; RUN: llvm-as -bitcode-mdindex-threshold=100 < %s | llvm-bcanalyzer -dump | FileCheck %s --check-prefix=NOINDEX
+; NOINDEX-NOT: INDEX
+
+; The module reads back the same with and without loading on demand.
+; RUN: llvm-dis < %t.bc -o %t.ll
+; RUN: llvm-dis -disable-ondemand-mds-loading < %t.bc -o %t.eager.ll
+; RUN: diff %t.ll %t.eager.ll
+; RUN: FileCheck %s < %t.ll
+
+; Extracting @foo only loads the named metadata and the nodes shared by @foo
+; and @bar, not the chain shared by @bar and @baz.
+; RUN: llvm-extract -func=foo -stats %t.bc -S -o %t.foo.ll 2>&1 | FileCheck %s --check-prefix=STATS
+; STATS: 4 bitcode-reader - Number of Metadata records loaded
+; STATS: 4 bitcode-reader - Number of MDStrings loaded
+; RUN: llvm-extract -func=foo -disable-ondemand-mds-loading %t.bc -S -o %t.foo.eager.ll
+; RUN: diff %t.foo.ll %t.foo.eager.ll
+; RUN: FileCheck %s --check-prefix=FOO < %t.foo.ll
+; FOO: define void @foo()
+; FOO-SAME: !shared ![[B0:[0-9]+]]
+; FOO: ![[B0]] = !{!"b0", ![[B1:[0-9]+]]}
+; FOO: ![[B1]] = !{!"b1", ![[B2:[0-9]+]]}
+; FOO-NOT: !"a0"
+
+; CHECK: define void @foo() !shared ![[B0:[0-9]+]]
+; CHECK: define void @bar() !shared ![[B0]] !chain ![[A0:[0-9]+]]
+; CHECK: define void @baz() !chain ![[A0]]
+; CHECK: !named = !{![[NAMED:[0-9]+]]}
+; CHECK: ![[NAMED]] = distinct !{![[NAMED]], !"named"}
+; CHECK: ![[B0]] = !{!"b0", ![[B1:[0-9]+]]}
+; CHECK: ![[A0]] = !{!"a0", ![[A1:[0-9]+]]}
+; CHECK: !{!"a29"}
+
+define void @foo() !shared !40 {
+  ret void
+}
+
+define void @bar() !shared !40 !chain !0 {
+  ret void
+}
+
+define void @baz() !chain !0 {
+  ret void
+}
+
+!named = !{!50}
+
+!0 = !{!"a0", !1}
+!1 = !{!"a1", !2}
+!2 = !{!"a2", !3}
+!3 = !{!"a3", !4}
+!4 = !{!"a4", !5}
+!5 = !{!"a5", !6}
+!6 = !{!"a6", !7}
+!7 = !{!"a7", !8}
+!8 = !{!"a8", !9}
+!9 = !{!"a9", !10}
+!10 = !{!"a10", !11}
+!11 = !{!"a11", !12}
+!12 = !{!"a12", !13}
+!13 = !{!"a13", !14}
+!14 = !{!"a14", !15}
+!15 = !{!"a15", !16}
+!16 = !{!"a16", !17}
+!17 = !{!"a17", !18}
+!18 = !{!"a18", !19}
+!19 = !{!"a19", !20}
+!20 = !{!"a20", !21}
+!21 = !{!"a21", !22}
+!22 = !{!"a22", !23}
+!23 = !{!"a23", !24}
+!24 = !{!"a24", !25}
+!25 = !{!"a25", !26}
+!26 = !{!"a26", !27}
+!27 = !{!"a27", !28}
+!28 = !{!"a28", !29}
+!29 = !{!"a29"}
+
+!40 = !{!"b0", !41}
+!41 = !{!"b1", !42}
+!42 = !{!"b2"}
+
+!50 = distinct !{!50, !"named"}
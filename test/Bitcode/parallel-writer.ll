@@ -0,0 +1,73 @@
+; Check that encoding the function blocks on several threads gives the same
+; bitcode as encoding them serially.
+
+; RUN: llvm-as < %s -o %t.serial.bc
+; RUN: llvm-as -bitcode-writer-threads=3 < %s -o %t.parallel.bc
+; RUN: cmp %t.serial.bc %t.parallel.bc
+; RUN: llvm-dis < %t.parallel.bc | FileCheck %s
+
+; The function offsets of the module-level VST and the summary are written
+; after the function blocks.
+; RUN: opt -module-summary %s -o %t.serial.bc
+; RUN: opt -module-summary -bitcode-writer-threads=3 %s -o %t.parallel.bc
+; RUN: cmp %t.serial.bc %t.parallel.bc
+
+; Use-list orders are still written serially.
+; RUN: llvm-as -preserve-bc-uselistorder -bitcode-writer-threads=3 < %s -o %t.parallel.bc
+; RUN: llvm-as -preserve-bc-uselistorder < %s -o %t.serial.bc
+; RUN: cmp %t.serial.bc %t.parallel.bc
+
+; RUN: llvm-as < %p/compatibility.ll -o %t.serial.bc
+; RUN: llvm-as -bitcode-writer-threads=4 < %p/compatibility.ll -o %t.parallel.bc
+; RUN: cmp %t.serial.bc %t.parallel.bc
+
+@g = global i32 0
+@table = internal constant [2 x i8*] [i8* blockaddress(@big, %a), i8* blockaddress(@big, %b)]
+
+; CHECK: define i32 @big(i32 %x)
+define i32 @big(i32 %x) !attached !0 !dbg !5 {
+entry:
+  %c = icmp eq i32 %x, 0
+  br i1 %c, label %a, label %b, !prof !1
+a:
+  %v = load i32, i32* @g, !local !2
+  %s = add i32 %v, 42
+  br label %b
+b:
+  %r = phi i32 [ %x, %entry ], [ %s, %a ]
+  call void @llvm.dbg.value(metadata i32 %r, i64 0, metadata !8, metadata !9), !dbg !10
+  ret i32 %r, !dbg !10
+}
+
+; CHECK: define float @small(float %f)
+define float @small(float %f) {
+  %m = fmul fast float %f, 2.5
+  ret float %m
+}
+
+; CHECK: define i32 @caller()
+define i32 @caller() {
+  %x = call i32 @big(i32 7)
+  %y = call float @small(float 1.0)
+  store i32 %x, i32* @g
+  ret i32 %x
+}
+
+declare void @llvm.dbg.value(metadata, i64, metadata, metadata)
+
+!llvm.dbg.cu = !{!3}
+!llvm.module.flags = !{!11}
+
+!0 = !{!"attached"}
+!1 = !{!"branch_weights", i32 1, i32 9}
+!2 = !{i32 1}
+!3 = distinct !DICompileUnit(language: DW_LANG_C99, file: !4, producer: "clang", isOptimized: true, runtimeVersion: 0, emissionKind: FullDebug)
+!4 = !DIFile(filename: "parallel.c", directory: "/tmp")
+!5 = distinct !DISubprogram(name: "big", scope: !4, file: !4, line: 1, type: !6, isLocal: false, isDefinition: true, unit: !3)
+!6 = !DISubroutineType(types: !7)
+!7 = !{null}
+!8 = !DILocalVariable(name: "r", scope: !5, file: !4, line: 2, type: !12)
+!9 = !DIExpression()
+!10 = !DILocation(line: 2, column: 3, scope: !5)
+!11 = !{i32 2, !"Debug Info Version", i32 3}
+!12 = !DIBasicType(name: "int", size: 32, align: 32, encoding: DW_ATE_signed)
@@ -0,0 +1,34 @@
+; REQUIRES: asserts
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -mattr=+sse2 | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -mattr=+sse2 \
+; RUN:   -combiner-incremental | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -mattr=+sse2 \
+; RUN:   -combiner-incremental -stats -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=STATS
+
+; The combines after legalization only revisit the nodes legalization created
+; or modified, the others were settled by the first combine.
+; STATS: {{[0-9]+}} dagcombine - Number of unchanged nodes not revisited
+
+; CHECK-LABEL: shuffle_add:
+; CHECK: pshufd $27
+; CHECK: paddd
+; CHECK: retq
+define void @shuffle_add(<4 x i32>* %p, <4 x i32>* %q) {
+  %a = load <4 x i32>, <4 x i32>* %p
+  %b = load <4 x i32>, <4 x i32>* %q
+  %s = shufflevector <4 x i32> %b, <4 x i32> undef,
+                     <4 x i32> <i32 3, i32 2, i32 1, i32 0>
+  %r = add <4 x i32> %a, %s
+  store <4 x i32> %r, <4 x i32>* %p
+  ret void
+}
+
+; CHECK-LABEL: wide_add:
+; CHECK: addq
+; CHECK: adcq
+; CHECK: retq
+define i128 @wide_add(i128 %a, i128 %b) {
+  %r = add i128 %a, %b
+  ret i128 %r
+}
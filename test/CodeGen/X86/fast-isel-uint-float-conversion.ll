@@ -0,0 +1,47 @@
+; RUN: llc -mtriple=x86_64-unknown-unknown -mcpu=generic -mattr=+sse2 -fast-isel --fast-isel-abort=1 < %s | FileCheck %s --check-prefix=ALL --check-prefix=SSE2
+; RUN: llc -mtriple=x86_64-unknown-unknown -mcpu=generic -mattr=+avx -fast-isel --fast-isel-abort=1 < %s | FileCheck %s --check-prefix=ALL --check-prefix=AVX
+
+
+define double @uint_to_double_rr(i32 %a) {
+; ALL-LABEL: uint_to_double_rr:
+; ALL: movl %edi, %e[[REG:[a-z]+]]
+; SSE2-NEXT: cvtsi2sdq %r[[REG]], %xmm0
+; AVX-NEXT: vcvtsi2sdq %r[[REG]], %xmm0, %xmm0
+; ALL-NEXT: ret
+entry:
+  %0 = uitofp i32 %a to double
+  ret double %0
+}
+
+define float @uint_to_float_rr(i32 %a) {
+; ALL-LABEL: uint_to_float_rr:
+; ALL: movl %edi, %e[[REG:[a-z]+]]
+; SSE2-NEXT: cvtsi2ssq %r[[REG]], %xmm0
+; AVX-NEXT: vcvtsi2ssq %r[[REG]], %xmm0, %xmm0
+; ALL-NEXT: ret
+entry:
+  %0 = uitofp i32 %a to float
+  ret float %0
+}
+
+define double @ushort_to_double_rr(i16 %a) {
+; ALL-LABEL: ushort_to_double_rr:
+; ALL: movzwl %di, %e[[REG:[a-z]+]]
+; SSE2-NEXT: cvtsi2sdq %r[[REG]], %xmm0
+; AVX-NEXT: vcvtsi2sdq %r[[REG]], %xmm0, %xmm0
+; ALL-NEXT: ret
+entry:
+  %0 = uitofp i16 %a to double
+  ret double %0
+}
+
+define float @uchar_to_float_rr(i8 %a) {
+; ALL-LABEL: uchar_to_float_rr:
+; ALL: movzbl %dil, %e[[REG:[a-z]+]]
+; SSE2-NEXT: cvtsi2ssq %r[[REG]], %xmm0
+; AVX-NEXT: vcvtsi2ssq %r[[REG]], %xmm0, %xmm0
+; ALL-NEXT: ret
+entry:
+  %0 = uitofp i8 %a to float
+  ret float %0
+}
@@ -0,0 +1,25 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -O0 -isel-report-throughput \
+; RUN:   -o /dev/null 2>&1 | FileCheck %s --check-prefix=FAST
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -isel-report-throughput \
+; RUN:   -o /dev/null 2>&1 | FileCheck %s --check-prefix=DAG
+
+; Fast-isel doesn't select switches, so the entry block is left to SelectionDAG.
+; FAST: isel: selected 7 instructions in {{[0-9.]+}}s ({{[0-9]+}} instructions/s), 3 left by fast-isel to SelectionDAG
+; DAG: isel: selected 7 instructions in {{[0-9.]+}}s ({{[0-9]+}} instructions/s){{$}}
+
+define i32 @f(i32 %x, i32 %y) {
+entry:
+  %a = add i32 %x, %y
+  %m = mul i32 %a, %x
+  switch i32 %m, label %def [
+    i32 1, label %one
+    i32 7, label %seven
+  ]
+one:
+  ret i32 %a
+seven:
+  ret i32 %m
+def:
+  %s = sub i32 %m, %y
+  ret i32 %s
+}
@@ -0,0 +1,63 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -verify-machineinstrs -o %t.eager
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -verify-machineinstrs \
+; RUN:   -lazy-live-intervals -o %t.lazy
+; RUN: diff %t.eager %t.lazy
+
+; Computing the live intervals on demand doesn't change the generated code.
+
+define i32 @sum(i32* %p, i64 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %q = getelementptr i32, i32* %p, i64 %i
+  %v = load i32, i32* %q
+  %s.next = add i32 %s, %v
+  %i.next = add i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %s.next
+}
+
+define i64 @pressure(i64* %p) {
+entry:
+  %a0 = load volatile i64, i64* %p
+  %a1 = load volatile i64, i64* %p
+  %a2 = load volatile i64, i64* %p
+  %a3 = load volatile i64, i64* %p
+  %a4 = load volatile i64, i64* %p
+  %a5 = load volatile i64, i64* %p
+  %a6 = load volatile i64, i64* %p
+  %a7 = load volatile i64, i64* %p
+  %a8 = load volatile i64, i64* %p
+  %a9 = load volatile i64, i64* %p
+  %a10 = load volatile i64, i64* %p
+  %a11 = load volatile i64, i64* %p
+  %a12 = load volatile i64, i64* %p
+  %a13 = load volatile i64, i64* %p
+  %a14 = load volatile i64, i64* %p
+  %a15 = load volatile i64, i64* %p
+  %c = call i64 @g(i64 %a0)
+  %s0 = add i64 %a1, %a2
+  %s1 = add i64 %s0, %a3
+  %s2 = add i64 %s1, %a4
+  %s3 = add i64 %s2, %a5
+  %s4 = add i64 %s3, %a6
+  %s5 = add i64 %s4, %a7
+  %s6 = add i64 %s5, %a8
+  %s7 = add i64 %s6, %a9
+  %s8 = add i64 %s7, %a10
+  %s9 = add i64 %s8, %a11
+  %s10 = add i64 %s9, %a12
+  %s11 = add i64 %s10, %a13
+  %s12 = add i64 %s11, %a14
+  %s13 = add i64 %s12, %a15
+  %s14 = add i64 %s13, %c
+  ret i64 %s14
+}
+
+declare i64 @g(i64)
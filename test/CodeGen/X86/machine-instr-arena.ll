@@ -0,0 +1,33 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -verify-machineinstrs -o %t.default
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -verify-machineinstrs \
+; RUN:   -machine-instr-arena -o %t.arena
+; RUN: diff %t.default %t.arena
+
+; Allocating the instructions from the function arena doesn't change the
+; generated code.
+
+define i32 @f(i32* %p, i32 %n) {
+entry:
+  %c = icmp sgt i32 %n, 0
+  br i1 %c, label %loop, label %exit
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %idx = sext i32 %i to i64
+  %q = getelementptr i32, i32* %p, i64 %idx
+  %v = load i32, i32* %q
+  %m = mul i32 %v, %i
+  %s.next = add i32 %s, %m
+  store i32 %s.next, i32* %q
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %r = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %call = call i32 @g(i32 %r)
+  ret i32 %call
+}
+
+declare i32 @g(i32)
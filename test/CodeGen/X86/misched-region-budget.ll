@@ -0,0 +1,132 @@
+; Check that regions over the budget are scheduled in windows.
+; REQUIRES: asserts
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -enable-misched -stats -o /dev/null 2>&1 | FileCheck %s --check-prefix=DEFAULT
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -enable-misched -misched-region-budget=16 -misched-region-window=8 -verify-machineinstrs -stats -o /dev/null 2>&1 | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -enable-misched -misched-region-budget=1 -misched-region-window=1 -verify-machineinstrs -o /dev/null
+
+; DEFAULT-NOT: scheduled in windows
+; CHECK: 1 misched - Number of regions over the budget scheduled in windows
+
+define void @f(i32* %p, i32* %q) {
+  %p0 = getelementptr i32, i32* %p, i64 0
+  %v0 = load i32, i32* %p0
+  %m0 = mul i32 %v0, 3
+  %q0 = getelementptr i32, i32* %q, i64 0
+  store i32 %m0, i32* %q0
+  %p1 = getelementptr i32, i32* %p, i64 1
+  %v1 = load i32, i32* %p1
+  %m1 = mul i32 %v1, 4
+  %q1 = getelementptr i32, i32* %q, i64 1
+  store i32 %m1, i32* %q1
+  %p2 = getelementptr i32, i32* %p, i64 2
+  %v2 = load i32, i32* %p2
+  %m2 = mul i32 %v2, 5
+  %q2 = getelementptr i32, i32* %q, i64 2
+  store i32 %m2, i32* %q2
+  %p3 = getelementptr i32, i32* %p, i64 3
+  %v3 = load i32, i32* %p3
+  %m3 = mul i32 %v3, 6
+  %q3 = getelementptr i32, i32* %q, i64 3
+  store i32 %m3, i32* %q3
+  %p4 = getelementptr i32, i32* %p, i64 4
+  %v4 = load i32, i32* %p4
+  %m4 = mul i32 %v4, 7
+  %q4 = getelementptr i32, i32* %q, i64 4
+  store i32 %m4, i32* %q4
+  %p5 = getelementptr i32, i32* %p, i64 5
+  %v5 = load i32, i32* %p5
+  %m5 = mul i32 %v5, 8
+  %q5 = getelementptr i32, i32* %q, i64 5
+  store i32 %m5, i32* %q5
+  %p6 = getelementptr i32, i32* %p, i64 6
+  %v6 = load i32, i32* %p6
+  %m6 = mul i32 %v6, 9
+  %q6 = getelementptr i32, i32* %q, i64 6
+  store i32 %m6, i32* %q6
+  %p7 = getelementptr i32, i32* %p, i64 7
+  %v7 = load i32, i32* %p7
+  %m7 = mul i32 %v7, 10
+  %q7 = getelementptr i32, i32* %q, i64 7
+  store i32 %m7, i32* %q7
+  %p8 = getelementptr i32, i32* %p, i64 8
+  %v8 = load i32, i32* %p8
+  %m8 = mul i32 %v8, 11
+  %q8 = getelementptr i32, i32* %q, i64 8
+  store i32 %m8, i32* %q8
+  %p9 = getelementptr i32, i32* %p, i64 9
+  %v9 = load i32, i32* %p9
+  %m9 = mul i32 %v9, 12
+  %q9 = getelementptr i32, i32* %q, i64 9
+  store i32 %m9, i32* %q9
+  %p10 = getelementptr i32, i32* %p, i64 10
+  %v10 = load i32, i32* %p10
+  %m10 = mul i32 %v10, 13
+  %q10 = getelementptr i32, i32* %q, i64 10
+  store i32 %m10, i32* %q10
+  %p11 = getelementptr i32, i32* %p, i64 11
+  %v11 = load i32, i32* %p11
+  %m11 = mul i32 %v11, 14
+  %q11 = getelementptr i32, i32* %q, i64 11
+  store i32 %m11, i32* %q11
+  %p12 = getelementptr i32, i32* %p, i64 12
+  %v12 = load i32, i32* %p12
+  %m12 = mul i32 %v12, 15
+  %q12 = getelementptr i32, i32* %q, i64 12
+  store i32 %m12, i32* %q12
+  %p13 = getelementptr i32, i32* %p, i64 13
+  %v13 = load i32, i32* %p13
+  %m13 = mul i32 %v13, 16
+  %q13 = getelementptr i32, i32* %q, i64 13
+  store i32 %m13, i32* %q13
+  %p14 = getelementptr i32, i32* %p, i64 14
+  %v14 = load i32, i32* %p14
+  %m14 = mul i32 %v14, 17
+  %q14 = getelementptr i32, i32* %q, i64 14
+  store i32 %m14, i32* %q14
+  %p15 = getelementptr i32, i32* %p, i64 15
+  %v15 = load i32, i32* %p15
+  %m15 = mul i32 %v15, 18
+  %q15 = getelementptr i32, i32* %q, i64 15
+  store i32 %m15, i32* %q15
+  %p16 = getelementptr i32, i32* %p, i64 16
+  %v16 = load i32, i32* %p16
+  %m16 = mul i32 %v16, 19
+  %q16 = getelementptr i32, i32* %q, i64 16
+  store i32 %m16, i32* %q16
+  %p17 = getelementptr i32, i32* %p, i64 17
+  %v17 = load i32, i32* %p17
+  %m17 = mul i32 %v17, 20
+  %q17 = getelementptr i32, i32* %q, i64 17
+  store i32 %m17, i32* %q17
+  %p18 = getelementptr i32, i32* %p, i64 18
+  %v18 = load i32, i32* %p18
+  %m18 = mul i32 %v18, 21
+  %q18 = getelementptr i32, i32* %q, i64 18
+  store i32 %m18, i32* %q18
+  %p19 = getelementptr i32, i32* %p, i64 19
+  %v19 = load i32, i32* %p19
+  %m19 = mul i32 %v19, 22
+  %q19 = getelementptr i32, i32* %q, i64 19
+  store i32 %m19, i32* %q19
+  %p20 = getelementptr i32, i32* %p, i64 20
+  %v20 = load i32, i32* %p20
+  %m20 = mul i32 %v20, 23
+  %q20 = getelementptr i32, i32* %q, i64 20
+  store i32 %m20, i32* %q20
+  %p21 = getelementptr i32, i32* %p, i64 21
+  %v21 = load i32, i32* %p21
+  %m21 = mul i32 %v21, 24
+  %q21 = getelementptr i32, i32* %q, i64 21
+  store i32 %m21, i32* %q21
+  %p22 = getelementptr i32, i32* %p, i64 22
+  %v22 = load i32, i32* %p22
+  %m22 = mul i32 %v22, 25
+  %q22 = getelementptr i32, i32* %q, i64 22
+  store i32 %m22, i32* %q22
+  %p23 = getelementptr i32, i32* %p, i64 23
+  %v23 = load i32, i32* %p23
+  %m23 = mul i32 %v23, 26
+  %q23 = getelementptr i32, i32* %q, i64 23
+  store i32 %m23, i32* %q23
+  ret void
+}
@@ -0,0 +1,76 @@
+; Check that huge functions spill instead of splitting live ranges once their
+; splitting budget is spent.
+; REQUIRES: asserts
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -stats -o /dev/null 2>&1 | FileCheck %s --check-prefix=DEFAULT
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -regalloc-huge-function-vregs=0 -regalloc-split-budget=0 -stats -o /dev/null 2>&1 | FileCheck %s --check-prefix=BUDGET
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -regalloc-huge-function-vregs=0 -regalloc-split-budget=0 -verify-machineinstrs -o /dev/null
+
+; DEFAULT-NOT: splitting budget
+; DEFAULT: regalloc - Number of split global live ranges
+; DEFAULT-NOT: splitting budget
+
+; BUDGET-NOT: Number of split global live ranges
+; BUDGET: 1 regalloc - Number of functions that exhausted their splitting budget
+; BUDGET-NOT: Number of split global live ranges
+
+; The values loaded in the entry block are split around the call, which
+; clobbers the registers they can be assigned outside of it.
+
+declare void @g(i64)
+
+define i64 @f(i64* %p, i64 %n) {
+entry:
+  %a0.p = getelementptr i64, i64* %p, i64 0
+  %a0 = load volatile i64, i64* %a0.p
+  %a1.p = getelementptr i64, i64* %p, i64 1
+  %a1 = load volatile i64, i64* %a1.p
+  %a2.p = getelementptr i64, i64* %p, i64 2
+  %a2 = load volatile i64, i64* %a2.p
+  %a3.p = getelementptr i64, i64* %p, i64 3
+  %a3 = load volatile i64, i64* %a3.p
+  %a4.p = getelementptr i64, i64* %p, i64 4
+  %a4 = load volatile i64, i64* %a4.p
+  %a5.p = getelementptr i64, i64* %p, i64 5
+  %a5 = load volatile i64, i64* %a5.p
+  %a6.p = getelementptr i64, i64* %p, i64 6
+  %a6 = load volatile i64, i64* %a6.p
+  %a7.p = getelementptr i64, i64* %p, i64 7
+  %a7 = load volatile i64, i64* %a7.p
+  %a8.p = getelementptr i64, i64* %p, i64 8
+  %a8 = load volatile i64, i64* %a8.p
+  %a9.p = getelementptr i64, i64* %p, i64 9
+  %a9 = load volatile i64, i64* %a9.p
+  %c = icmp eq i64 %n, 0
+  br i1 %c, label %call, label %use
+
+call:
+  call void @g(i64 %n)
+  br label %join
+
+use:
+  %u0 = add i64 %n, %a0
+  %u1 = add i64 %u0, %a1
+  %u2 = add i64 %u1, %a2
+  %u3 = add i64 %u2, %a3
+  %u4 = add i64 %u3, %a4
+  %u5 = add i64 %u4, %a5
+  %u6 = add i64 %u5, %a6
+  %u7 = add i64 %u6, %a7
+  %u8 = add i64 %u7, %a8
+  %u9 = add i64 %u8, %a9
+  br label %join
+
+join:
+  %s = phi i64 [ 0, %call ], [ %u9, %use ]
+  %r0 = mul i64 %s, %a0
+  %r1 = mul i64 %r0, %a1
+  %r2 = mul i64 %r1, %a2
+  %r3 = mul i64 %r2, %a3
+  %r4 = mul i64 %r3, %a4
+  %r5 = mul i64 %r4, %a5
+  %r6 = mul i64 %r5, %a6
+  %r7 = mul i64 %r6, %a7
+  %r8 = mul i64 %r7, %a8
+  %r9 = mul i64 %r8, %a9
+  ret i64 %r9
+}
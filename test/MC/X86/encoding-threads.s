@@ -0,0 +1,36 @@
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.serial
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.parallel \
+# RUN:   -mc-encoding-threads=4
+# RUN: cmp %t.serial %t.parallel
+# RUN: llvm-readobj -t %t.parallel | FileCheck %s
+
+# The instructions that may need relaxation are encoded when the object file
+# is complete, concurrently. This must not change the object file, nor the
+# type of the TLS symbols they refer to.
+
+# CHECK:      Name: tls
+# CHECK-NEXT: Value: 0x0
+# CHECK-NEXT: Size: 0
+# CHECK-NEXT: Binding: Global
+# CHECK-NEXT: Type: TLS
+# CHECK-NEXT: Other: 0
+# CHECK-NEXT: Section: Undefined
+
+	.text
+	.globl f
+f:
+	testl %edi, %edi
+	je .Lshort
+	jne .Lfar
+	addq $tls@TPOFF, %rax
+	cmpl $sym, %esi
+	jmp .Lshort
+.Lshort:
+	nop
+	jg .Lfar
+	jmp ext
+	.fill 200, 1, 0x90
+.Lfar:
+	subq $sym+8, %rdx
+	jl f
+	ret
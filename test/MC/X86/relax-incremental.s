@@ -0,0 +1,30 @@
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-unknown %s -o %t
+# RUN: llvm-objdump -d %t | FileCheck %s
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-unknown %s -o /dev/null \
+# RUN:   -stats 2>&1 | FileCheck %s --check-prefix=STATS
+# REQUIRES: asserts
+
+# Both long jumps are relaxed by the first iteration, and the second one finds
+# that nothing else changes. The short jump before them and the fragment
+# holding it only depend on fragments that didn't move, so the second
+# iteration doesn't check them again.
+
+# STATS: 2 assembler - Number of assembler layout and relaxation steps
+# STATS: 2 assembler - Number of relaxed instructions
+# STATS: 2 assembler - Number of relaxation checks skipped because nothing they depend on changed
+
+	.text
+# CHECK: 0: eb 01 jmp 1 <near>
+	jmp near
+	nop
+near:
+# CHECK: 3: e9 81 00 00 00 jmp 129 <first>
+	jmp first
+	.fill 120, 1, 0x90
+# CHECK: 80: e9 cc 00 00 00 jmp 204 <second>
+	jmp second
+	.fill 4, 1, 0x90
+first:
+	.fill 200, 1, 0x90
+second:
+	ret
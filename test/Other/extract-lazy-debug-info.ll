@@ -0,0 +1,69 @@
+; Check that extracting functions from a module whose metadata is loaded on
+; demand gives the same debug info as loading it eagerly, on C++ debug info
+; where uniqued nodes reference each other in cycles: the members of a class
+; are in its elements and have the class as scope.
+
+; RUN: llvm-as -bitcode-mdindex-threshold=1 < %s -o %t.bc
+; RUN: llvm-extract -func=_ZN1S6methodEv %t.bc -S -o %t.method.ll
+; RUN: llvm-extract -func=_ZN1S6methodEv -disable-ondemand-mds-loading %t.bc -S -o %t.method.eager.ll
+; RUN: diff %t.method.ll %t.method.eager.ll
+; RUN: FileCheck %s --check-prefix=METHOD < %t.method.ll
+; RUN: llvm-extract -func=main %t.bc -S -o %t.main.ll
+; RUN: llvm-extract -func=main -disable-ondemand-mds-loading %t.bc -S -o %t.main.eager.ll
+; RUN: diff %t.main.ll %t.main.eager.ll
+; RUN: FileCheck %s --check-prefix=MAIN < %t.main.ll
+
+; METHOD: define void @_ZN1S6methodEv(%struct.S* %this) !dbg [[DEF:![0-9]+]]
+; METHOD: [[DEF]] = distinct !DISubprogram(name: "method"{{.*}} scope: [[S:![0-9]+]],{{.*}} declaration: [[DECL:![0-9]+]]
+; METHOD: [[S]] = !DICompositeType(tag: DW_TAG_structure_type, name: "S"{{.*}} elements: [[ELTS:![0-9]+]])
+; METHOD: [[ELTS]] = !{[[MEMBER:![0-9]+]], [[STATIC:![0-9]+]], [[DECL]]}
+; METHOD: [[MEMBER]] = !DIDerivedType(tag: DW_TAG_member, name: "member", scope: [[S]]
+; METHOD: [[STATIC]] = !DIDerivedType(tag: DW_TAG_member, name: "static_member", scope: [[S]],{{.*}} flags: DIFlagStaticMember)
+; METHOD: [[DECL]] = !DISubprogram(name: "method"{{.*}} scope: [[S]],{{.*}} isDefinition: false
+
+; MAIN: define i32 @main() !dbg
+; MAIN: !DIGlobalVariable(name: "static_member"{{.*}} declaration: [[STATIC:![0-9]+]])
+; MAIN: [[STATIC]] = !DIDerivedType(tag: DW_TAG_member, name: "static_member", scope: [[S:![0-9]+]]
+; MAIN: [[S]] = !DICompositeType(tag: DW_TAG_structure_type, name: "S"
+
+%struct.S = type { i32 }
+
+@_ZN1S13static_memberE = global i32 1, align 4
+
+define void @_ZN1S6methodEv(%struct.S* %this) !dbg !14 {
+entry:
+  %member = getelementptr inbounds %struct.S, %struct.S* %this, i32 0, i32 0, !dbg !21
+  store i32 0, i32* %member, align 4, !dbg !21
+  ret void, !dbg !21
+}
+
+define i32 @main() !dbg !22 {
+entry:
+  %0 = load i32, i32* @_ZN1S13static_memberE, align 4, !dbg !25
+  ret i32 %0, !dbg !25
+}
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!26}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C_plus_plus, file: !1, producer: "clang", isOptimized: false, emissionKind: FullDebug, globals: !2)
+!1 = !DIFile(filename: "s.cpp", directory: "/tmp")
+!2 = !{!3}
+!3 = !DIGlobalVariable(name: "static_member", linkageName: "_ZN1S13static_memberE", scope: !0, file: !1, line: 7, type: !7, isLocal: false, isDefinition: true, variable: i32* @_ZN1S13static_memberE, declaration: !6)
+!4 = !DICompositeType(tag: DW_TAG_structure_type, name: "S", file: !1, line: 1, size: 32, align: 32, elements: !5)
+!5 = !{!8, !6, !9}
+!6 = !DIDerivedType(tag: DW_TAG_member, name: "static_member", scope: !4, file: !1, line: 3, baseType: !7, flags: DIFlagStaticMember)
+!7 = !DIBasicType(name: "int", size: 32, align: 32, encoding: DW_ATE_signed)
+!8 = !DIDerivedType(tag: DW_TAG_member, name: "member", scope: !4, file: !1, line: 2, baseType: !7, size: 32, align: 32)
+!9 = !DISubprogram(name: "method", linkageName: "_ZN1S6methodEv", scope: !4, file: !1, line: 4, type: !10, isLocal: false, isDefinition: false, scopeLine: 4, flags: DIFlagPrototyped, isOptimized: false)
+!10 = !DISubroutineType(types: !11)
+!11 = !{null, !12}
+!12 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !4, size: 64, align: 64, flags: DIFlagArtificial | DIFlagObjectPointer)
+!13 = !{}
+!14 = distinct !DISubprogram(name: "method", linkageName: "_ZN1S6methodEv", scope: !4, file: !1, line: 10, type: !10, isLocal: false, isDefinition: true, scopeLine: 10, flags: DIFlagPrototyped, isOptimized: false, unit: !0, declaration: !9, variables: !13)
+!21 = !DILocation(line: 11, column: 3, scope: !14)
+!22 = distinct !DISubprogram(name: "main", scope: !1, file: !1, line: 14, type: !23, isLocal: false, isDefinition: true, scopeLine: 14, isOptimized: false, unit: !0, variables: !13)
+!23 = !DISubroutineType(types: !24)
+!24 = !{!7}
+!25 = !DILocation(line: 15, column: 3, scope: !22)
+!26 = !{i32 2, !"Debug Info Version", i32 3}
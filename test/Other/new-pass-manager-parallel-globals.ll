@@ -0,0 +1,41 @@
+; Check that the changes the function pipelines make to global variables are
+; kept when they run on several threads, as they are when they run serially.
+
+; RUN: opt -S -passes=instcombine %s -o %t.serial.ll
+; RUN: opt -S -passes=instcombine -function-pipeline-threads=2 %s \
+; RUN:     -o %t.parallel.ll
+; RUN: diff %t.serial.ll %t.parallel.ll
+; RUN: FileCheck %s < %t.parallel.ll
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+; The load is rewritten to rely on the alignment instcombine gives @g.
+; CHECK: @g = internal global [4 x i32] zeroinitializer, align 16
+; CHECK: @h = internal global [4 x i32] zeroinitializer, align 16
+; CHECK: define <4 x i32> @load_g()
+; CHECK-NEXT: load <4 x i32>, {{.*}} @g {{.*}}, align 16
+; CHECK: define <4 x i32> @load_h()
+; CHECK-NEXT: load <4 x i32>, {{.*}} @h {{.*}}, align 16
+
+@g = internal global [4 x i32] zeroinitializer, align 1
+@h = internal global [4 x i32] zeroinitializer, align 1
+
+define <4 x i32> @load_g() {
+  %p = bitcast [4 x i32]* @g to <4 x i32>*
+  %v = load <4 x i32>, <4 x i32>* %p, align 1
+  ret <4 x i32> %v
+}
+
+define <4 x i32> @load_h() {
+  %p = bitcast [4 x i32]* @h to <4 x i32>*
+  %v = load <4 x i32>, <4 x i32>* %p, align 1
+  ret <4 x i32> %v
+}
+
+define i32 @user() {
+  %a = call <4 x i32> @load_g()
+  %b = call <4 x i32> @load_h()
+  %s = add <4 x i32> %a, %b
+  %r = extractelement <4 x i32> %s, i32 0
+  ret i32 %r
+}
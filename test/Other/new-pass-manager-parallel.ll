@@ -0,0 +1,58 @@
+; Check that running the function pipelines of the new pass manager on several
+; threads produces the same module as running them serially.
+
+; RUN: opt -S -passes='function(instcombine,simplify-cfg),no-op-module,function(early-cse)' \
+; RUN:     %s -o %t.serial.ll
+; RUN: opt -S -passes='function(instcombine,simplify-cfg),no-op-module,function(early-cse)' \
+; RUN:     -function-pipeline-threads=3 %s -o %t.parallel.ll
+; RUN: diff %t.serial.ll %t.parallel.ll
+; RUN: FileCheck %s < %t.parallel.ll
+
+; The function pipeline runs with the pass manager debug output of each
+; partition.
+; RUN: opt -disable-output -debug-pass-manager -passes='function(no-op-function)' \
+; RUN:     -function-pipeline-threads=2 %s 2>&1 | FileCheck %s --check-prefix=DEBUG
+; DEBUG: Running pass: ParallelFunctionPipelinePass
+; DEBUG-DAG: Running pass: NoOpFunctionPass on internal_fn
+; DEBUG-DAG: Running pass: NoOpFunctionPass on caller
+; DEBUG-DAG: Running pass: NoOpFunctionPass on alias_user
+
+; CHECK: @table = internal constant [2 x i32] [i32 3, i32 5]
+; CHECK: @0 = private constant i32 7
+; CHECK: @fn_alias = alias i32 (i32), i32 (i32)* @internal_fn
+; CHECK: define internal i32 @internal_fn(i32 %x)
+; CHECK-NEXT: ret i32 %x
+; CHECK: define i32 @caller()
+; CHECK-NEXT: entry:
+; CHECK-NEXT: %r = call i32 @internal_fn(i32 5)
+; CHECK: define i32 @alias_user()
+; CHECK-NEXT: %r = call i32 @internal_fn(i32 7)
+
+@table = internal constant [2 x i32] [i32 3, i32 5]
+@0 = private constant i32 7
+
+@fn_alias = alias i32 (i32), i32 (i32)* @internal_fn
+
+define internal i32 @internal_fn(i32 %x) {
+  %a = add i32 %x, 0
+  ret i32 %a
+}
+
+define i32 @caller() {
+entry:
+  %p = getelementptr [2 x i32], [2 x i32]* @table, i32 0, i32 1
+  %v = load i32, i32* %p
+  br label %next
+
+next:
+  %r = call i32 @internal_fn(i32 %v)
+  ret i32 %r
+}
+
+define i32 @alias_user() {
+  %v = load i32, i32* @0
+  %r = call i32 @fn_alias(i32 %v)
+  ret i32 %r
+}
+
+declare void @external()
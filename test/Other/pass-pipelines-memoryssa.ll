@@ -0,0 +1,33 @@
+; With -enable-memoryssa-gvn-dse, GVN and DSE build their own MemorySSA and
+; the pipeline no longer computes MemoryDependenceAnalysis for them.
+;
+; RUN: opt -disable-output -disable-verify -debug-pass=Structure \
+; RUN:     -O2 -enable-memoryssa-gvn-dse %s 2>&1 \
+; RUN:     | FileCheck %s
+; RUN: opt -disable-output -disable-verify -debug-pass=Structure \
+; RUN:     -O2 %s 2>&1 \
+; RUN:     | FileCheck %s --check-prefix=MEMDEP
+;
+; CHECK: MergedLoadStoreMotion
+; CHECK-NEXT: Function Alias Analysis Results
+; CHECK-NEXT: Global Value Numbering
+; CHECK: Value Propagation
+; CHECK-NEXT: Dominator Tree Construction
+; CHECK-NEXT: Basic Alias Analysis (stateless AA impl)
+; CHECK-NEXT: Function Alias Analysis Results
+; CHECK-NEXT: Dead Store Elimination
+;
+; MEMDEP: MergedLoadStoreMotion
+; MEMDEP-NEXT: Function Alias Analysis Results
+; MEMDEP-NEXT: Memory Dependence Analysis
+; MEMDEP-NEXT: Global Value Numbering
+; MEMDEP: Value Propagation
+; MEMDEP-NEXT: Dominator Tree Construction
+; MEMDEP-NEXT: Basic Alias Analysis (stateless AA impl)
+; MEMDEP-NEXT: Function Alias Analysis Results
+; MEMDEP-NEXT: Memory Dependence Analysis
+; MEMDEP-NEXT: Dead Store Elimination
+
+define void @foo() {
+  ret void
+}
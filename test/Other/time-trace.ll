@@ -0,0 +1,43 @@
+; Check that -time-trace-file records a span for every pass run on every IR
+; unit, for both pass managers.
+
+; RUN: opt < %s -disable-output -instsimplify -loop-rotate -inline -globaldce \
+; RUN:     -time-trace-file=%t.legacy.json
+; RUN: FileCheck %s --check-prefix=LEGACY < %t.legacy.json
+; RUN: opt < %s -disable-output -time-trace-file=%t.new.json \
+; RUN:     -passes='no-op-module,cgscc(no-op-cgscc),function(no-op-function)'
+; RUN: FileCheck %s --check-prefix=NEW < %t.new.json
+
+; LEGACY: {"traceEvents":[
+; LEGACY-DAG: "ph":"X","ts":{{[0-9]+}},"dur":{{[0-9]+}},"name":"Remove redundant instructions","args":{"detail":"caller","mem-delta":{{-?[0-9]+}}}}
+; LEGACY-DAG: "name":"Remove redundant instructions","args":{"detail":"callee"
+; LEGACY-DAG: "name":"Rotate Loops","args":{"detail":"callee:loop"
+; LEGACY-DAG: "name":"Function Integration/Inlining","args":{"detail":"callee"
+; LEGACY-DAG: "name":"Function Integration/Inlining","args":{"detail":"caller"
+; LEGACY-DAG: "name":"Dead Global Elimination","args":{"detail":"<stdin>"
+; LEGACY: ],"displayTimeUnit":"ms"}
+
+; NEW-DAG: "name":"NoOpModulePass","args":{"detail":"<stdin>"
+; NEW-DAG: "name":"NoOpCGSCCPass","args":{"detail":"(callee)"
+; NEW-DAG: "name":"NoOpCGSCCPass","args":{"detail":"(caller)"
+; NEW-DAG: "name":"NoOpFunctionPass","args":{"detail":"callee"
+; NEW-DAG: "name":"NoOpFunctionPass","args":{"detail":"caller"
+
+define void @callee(i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %i.next = add i32 %i, 1
+  %cond = icmp slt i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+define void @caller() {
+  call void @callee(i32 8)
+  ret void
+}
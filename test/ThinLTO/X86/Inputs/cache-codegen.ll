@@ -0,0 +1,13 @@
+source_filename = "cache-codegen.c"
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+define void @globalfunc() {
+entry:
+  ret void
+}
+
+define internal void @unused() {
+entry:
+  ret void
+}
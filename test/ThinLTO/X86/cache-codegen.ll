@@ -0,0 +1,30 @@
+; REQUIRES: asserts
+; RUN: opt -module-hash -module-summary %s -o %t.bc
+; RUN: rm -Rf %t.cache && mkdir %t.cache
+; RUN: llvm-lto -thinlto-action=run -exported-symbol=globalfunc %t.bc -thinlto-cache-dir %t.cache -stats 2>&1 | FileCheck %s --check-prefix=MISS
+; The timestamp, the entry for the module and the one for its optimized IR.
+; RUN: ls %t.cache | count 3
+
+; A version of the module with an extra function optimized away misses the
+; module entry but reuses the code generated for the same optimized IR.
+; RUN: opt -module-hash -module-summary %p/Inputs/cache-codegen.ll -o %t.bc
+; RUN: llvm-lto -thinlto-action=run -exported-symbol=globalfunc %t.bc -thinlto-cache-dir %t.cache -stats 2>&1 | FileCheck %s --check-prefix=HIT
+; RUN: ls %t.cache | count 4
+
+; Different target options miss both entries, then hit them.
+; RUN: llvm-lto -thinlto-action=run -exported-symbol=globalfunc %t.bc -thinlto-cache-dir %t.cache -function-sections -stats 2>&1 | FileCheck %s --check-prefix=MISS
+; RUN: ls %t.cache | count 6
+; RUN: llvm-lto -thinlto-action=run -exported-symbol=globalfunc %t.bc -thinlto-cache-dir %t.cache -function-sections
+; RUN: ls %t.cache | count 6
+
+; MISS-NOT: optimized IR was found in the cache
+; HIT: 1 thinlto {{.*}} Number of modules whose optimized IR was found in the cache
+
+source_filename = "cache-codegen.c"
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+define void @globalfunc() {
+entry:
+  ret void
+}
@@ -0,0 +1,45 @@
+; REQUIRES: asserts
+; RUN: opt < %s -correlated-propagation -S | FileCheck %s
+; RUN: opt < %s -correlated-propagation -lvi-cache-limit=2 -S | FileCheck %s
+; RUN: opt < %s -correlated-propagation -lvi-query-budget=1 -S | FileCheck %s
+; RUN: opt < %s -correlated-propagation -lvi-dominator-fast-path -S \
+; RUN:   | FileCheck %s
+; RUN: opt < %s -correlated-propagation -lvi-cache-limit=2 -stats \
+; RUN:   -disable-output 2>&1 | FileCheck %s --check-prefix=EVICT
+; RUN: opt < %s -correlated-propagation -lvi-query-budget=1 -stats \
+; RUN:   -disable-output 2>&1 | FileCheck %s --check-prefix=BUDGET
+; RUN: opt < %s -correlated-propagation -lvi-dominator-fast-path -stats \
+; RUN:   -disable-output 2>&1 | FileCheck %s --check-prefix=FAST
+
+; Evicting values from the cache, running out of budget for a query or
+; answering it from the dominating conditions gives the same answer here.
+; EVICT: {{[0-9]+}} lazy-value-info - Number of values evicted from the cache
+; BUDGET: {{[0-9]+}} lazy-value-info - Number of queries that ran out of budget
+; FAST: {{[0-9]+}} lazy-value-info - Number of queries answered from dominating conditions
+
+; CHECK-LABEL: @chain(
+; CHECK: c2:
+; CHECK-NEXT: %e = icmp ult i32 %y2, 20
+; CHECK-NEXT: %r = and i1 true, %e
+define i1 @chain(i32 %x, i32 %y) {
+entry:
+  %c = icmp ult i32 %x, 10
+  br i1 %c, label %a, label %exit
+
+a:
+  %y1 = add i32 %y, 1
+  br label %b
+
+b:
+  %y2 = add i32 %y1, 1
+  br label %c2
+
+c2:
+  %d = icmp ult i32 %x, 20
+  %e = icmp ult i32 %y2, 20
+  %r = and i1 %d, %e
+  ret i1 %r
+
+exit:
+  ret i1 false
+}
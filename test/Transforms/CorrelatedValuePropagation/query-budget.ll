@@ -0,0 +1,330 @@
+; RUN: opt < %s -correlated-propagation -S | FileCheck %s
+; RUN: opt < %s -correlated-propagation -lvi-query-budget=100 -S \
+; RUN:   | FileCheck %s --check-prefix=BUDGET
+
+; Bounding the work of a query is opt-in. By default, the range of %v299 is
+; still derived through the whole chain of additions, which takes more than
+; the few hundred block values a budget would typically allow. With a budget,
+; the query gives up and the comparison is kept.
+
+; CHECK-LABEL: @chain(
+; CHECK: use:
+; CHECK-NEXT: ret i1 true
+; BUDGET-LABEL: @chain(
+; BUDGET: use:
+; BUDGET-NEXT: %r = icmp ult i32 %v299, 1000
+define i1 @chain(i32 %x) {
+entry:
+  %c = icmp ult i32 %x, 10
+  br i1 %c, label %body, label %exit
+
+body:
+  %v0 = add i32 %x, 1
+  %v1 = add i32 %v0, 1
+  %v2 = add i32 %v1, 1
+  %v3 = add i32 %v2, 1
+  %v4 = add i32 %v3, 1
+  %v5 = add i32 %v4, 1
+  %v6 = add i32 %v5, 1
+  %v7 = add i32 %v6, 1
+  %v8 = add i32 %v7, 1
+  %v9 = add i32 %v8, 1
+  %v10 = add i32 %v9, 1
+  %v11 = add i32 %v10, 1
+  %v12 = add i32 %v11, 1
+  %v13 = add i32 %v12, 1
+  %v14 = add i32 %v13, 1
+  %v15 = add i32 %v14, 1
+  %v16 = add i32 %v15, 1
+  %v17 = add i32 %v16, 1
+  %v18 = add i32 %v17, 1
+  %v19 = add i32 %v18, 1
+  %v20 = add i32 %v19, 1
+  %v21 = add i32 %v20, 1
+  %v22 = add i32 %v21, 1
+  %v23 = add i32 %v22, 1
+  %v24 = add i32 %v23, 1
+  %v25 = add i32 %v24, 1
+  %v26 = add i32 %v25, 1
+  %v27 = add i32 %v26, 1
+  %v28 = add i32 %v27, 1
+  %v29 = add i32 %v28, 1
+  %v30 = add i32 %v29, 1
+  %v31 = add i32 %v30, 1
+  %v32 = add i32 %v31, 1
+  %v33 = add i32 %v32, 1
+  %v34 = add i32 %v33, 1
+  %v35 = add i32 %v34, 1
+  %v36 = add i32 %v35, 1
+  %v37 = add i32 %v36, 1
+  %v38 = add i32 %v37, 1
+  %v39 = add i32 %v38, 1
+  %v40 = add i32 %v39, 1
+  %v41 = add i32 %v40, 1
+  %v42 = add i32 %v41, 1
+  %v43 = add i32 %v42, 1
+  %v44 = add i32 %v43, 1
+  %v45 = add i32 %v44, 1
+  %v46 = add i32 %v45, 1
+  %v47 = add i32 %v46, 1
+  %v48 = add i32 %v47, 1
+  %v49 = add i32 %v48, 1
+  %v50 = add i32 %v49, 1
+  %v51 = add i32 %v50, 1
+  %v52 = add i32 %v51, 1
+  %v53 = add i32 %v52, 1
+  %v54 = add i32 %v53, 1
+  %v55 = add i32 %v54, 1
+  %v56 = add i32 %v55, 1
+  %v57 = add i32 %v56, 1
+  %v58 = add i32 %v57, 1
+  %v59 = add i32 %v58, 1
+  %v60 = add i32 %v59, 1
+  %v61 = add i32 %v60, 1
+  %v62 = add i32 %v61, 1
+  %v63 = add i32 %v62, 1
+  %v64 = add i32 %v63, 1
+  %v65 = add i32 %v64, 1
+  %v66 = add i32 %v65, 1
+  %v67 = add i32 %v66, 1
+  %v68 = add i32 %v67, 1
+  %v69 = add i32 %v68, 1
+  %v70 = add i32 %v69, 1
+  %v71 = add i32 %v70, 1
+  %v72 = add i32 %v71, 1
+  %v73 = add i32 %v72, 1
+  %v74 = add i32 %v73, 1
+  %v75 = add i32 %v74, 1
+  %v76 = add i32 %v75, 1
+  %v77 = add i32 %v76, 1
+  %v78 = add i32 %v77, 1
+  %v79 = add i32 %v78, 1
+  %v80 = add i32 %v79, 1
+  %v81 = add i32 %v80, 1
+  %v82 = add i32 %v81, 1
+  %v83 = add i32 %v82, 1
+  %v84 = add i32 %v83, 1
+  %v85 = add i32 %v84, 1
+  %v86 = add i32 %v85, 1
+  %v87 = add i32 %v86, 1
+  %v88 = add i32 %v87, 1
+  %v89 = add i32 %v88, 1
+  %v90 = add i32 %v89, 1
+  %v91 = add i32 %v90, 1
+  %v92 = add i32 %v91, 1
+  %v93 = add i32 %v92, 1
+  %v94 = add i32 %v93, 1
+  %v95 = add i32 %v94, 1
+  %v96 = add i32 %v95, 1
+  %v97 = add i32 %v96, 1
+  %v98 = add i32 %v97, 1
+  %v99 = add i32 %v98, 1
+  %v100 = add i32 %v99, 1
+  %v101 = add i32 %v100, 1
+  %v102 = add i32 %v101, 1
+  %v103 = add i32 %v102, 1
+  %v104 = add i32 %v103, 1
+  %v105 = add i32 %v104, 1
+  %v106 = add i32 %v105, 1
+  %v107 = add i32 %v106, 1
+  %v108 = add i32 %v107, 1
+  %v109 = add i32 %v108, 1
+  %v110 = add i32 %v109, 1
+  %v111 = add i32 %v110, 1
+  %v112 = add i32 %v111, 1
+  %v113 = add i32 %v112, 1
+  %v114 = add i32 %v113, 1
+  %v115 = add i32 %v114, 1
+  %v116 = add i32 %v115, 1
+  %v117 = add i32 %v116, 1
+  %v118 = add i32 %v117, 1
+  %v119 = add i32 %v118, 1
+  %v120 = add i32 %v119, 1
+  %v121 = add i32 %v120, 1
+  %v122 = add i32 %v121, 1
+  %v123 = add i32 %v122, 1
+  %v124 = add i32 %v123, 1
+  %v125 = add i32 %v124, 1
+  %v126 = add i32 %v125, 1
+  %v127 = add i32 %v126, 1
+  %v128 = add i32 %v127, 1
+  %v129 = add i32 %v128, 1
+  %v130 = add i32 %v129, 1
+  %v131 = add i32 %v130, 1
+  %v132 = add i32 %v131, 1
+  %v133 = add i32 %v132, 1
+  %v134 = add i32 %v133, 1
+  %v135 = add i32 %v134, 1
+  %v136 = add i32 %v135, 1
+  %v137 = add i32 %v136, 1
+  %v138 = add i32 %v137, 1
+  %v139 = add i32 %v138, 1
+  %v140 = add i32 %v139, 1
+  %v141 = add i32 %v140, 1
+  %v142 = add i32 %v141, 1
+  %v143 = add i32 %v142, 1
+  %v144 = add i32 %v143, 1
+  %v145 = add i32 %v144, 1
+  %v146 = add i32 %v145, 1
+  %v147 = add i32 %v146, 1
+  %v148 = add i32 %v147, 1
+  %v149 = add i32 %v148, 1
+  %v150 = add i32 %v149, 1
+  %v151 = add i32 %v150, 1
+  %v152 = add i32 %v151, 1
+  %v153 = add i32 %v152, 1
+  %v154 = add i32 %v153, 1
+  %v155 = add i32 %v154, 1
+  %v156 = add i32 %v155, 1
+  %v157 = add i32 %v156, 1
+  %v158 = add i32 %v157, 1
+  %v159 = add i32 %v158, 1
+  %v160 = add i32 %v159, 1
+  %v161 = add i32 %v160, 1
+  %v162 = add i32 %v161, 1
+  %v163 = add i32 %v162, 1
+  %v164 = add i32 %v163, 1
+  %v165 = add i32 %v164, 1
+  %v166 = add i32 %v165, 1
+  %v167 = add i32 %v166, 1
+  %v168 = add i32 %v167, 1
+  %v169 = add i32 %v168, 1
+  %v170 = add i32 %v169, 1
+  %v171 = add i32 %v170, 1
+  %v172 = add i32 %v171, 1
+  %v173 = add i32 %v172, 1
+  %v174 = add i32 %v173, 1
+  %v175 = add i32 %v174, 1
+  %v176 = add i32 %v175, 1
+  %v177 = add i32 %v176, 1
+  %v178 = add i32 %v177, 1
+  %v179 = add i32 %v178, 1
+  %v180 = add i32 %v179, 1
+  %v181 = add i32 %v180, 1
+  %v182 = add i32 %v181, 1
+  %v183 = add i32 %v182, 1
+  %v184 = add i32 %v183, 1
+  %v185 = add i32 %v184, 1
+  %v186 = add i32 %v185, 1
+  %v187 = add i32 %v186, 1
+  %v188 = add i32 %v187, 1
+  %v189 = add i32 %v188, 1
+  %v190 = add i32 %v189, 1
+  %v191 = add i32 %v190, 1
+  %v192 = add i32 %v191, 1
+  %v193 = add i32 %v192, 1
+  %v194 = add i32 %v193, 1
+  %v195 = add i32 %v194, 1
+  %v196 = add i32 %v195, 1
+  %v197 = add i32 %v196, 1
+  %v198 = add i32 %v197, 1
+  %v199 = add i32 %v198, 1
+  %v200 = add i32 %v199, 1
+  %v201 = add i32 %v200, 1
+  %v202 = add i32 %v201, 1
+  %v203 = add i32 %v202, 1
+  %v204 = add i32 %v203, 1
+  %v205 = add i32 %v204, 1
+  %v206 = add i32 %v205, 1
+  %v207 = add i32 %v206, 1
+  %v208 = add i32 %v207, 1
+  %v209 = add i32 %v208, 1
+  %v210 = add i32 %v209, 1
+  %v211 = add i32 %v210, 1
+  %v212 = add i32 %v211, 1
+  %v213 = add i32 %v212, 1
+  %v214 = add i32 %v213, 1
+  %v215 = add i32 %v214, 1
+  %v216 = add i32 %v215, 1
+  %v217 = add i32 %v216, 1
+  %v218 = add i32 %v217, 1
+  %v219 = add i32 %v218, 1
+  %v220 = add i32 %v219, 1
+  %v221 = add i32 %v220, 1
+  %v222 = add i32 %v221, 1
+  %v223 = add i32 %v222, 1
+  %v224 = add i32 %v223, 1
+  %v225 = add i32 %v224, 1
+  %v226 = add i32 %v225, 1
+  %v227 = add i32 %v226, 1
+  %v228 = add i32 %v227, 1
+  %v229 = add i32 %v228, 1
+  %v230 = add i32 %v229, 1
+  %v231 = add i32 %v230, 1
+  %v232 = add i32 %v231, 1
+  %v233 = add i32 %v232, 1
+  %v234 = add i32 %v233, 1
+  %v235 = add i32 %v234, 1
+  %v236 = add i32 %v235, 1
+  %v237 = add i32 %v236, 1
+  %v238 = add i32 %v237, 1
+  %v239 = add i32 %v238, 1
+  %v240 = add i32 %v239, 1
+  %v241 = add i32 %v240, 1
+  %v242 = add i32 %v241, 1
+  %v243 = add i32 %v242, 1
+  %v244 = add i32 %v243, 1
+  %v245 = add i32 %v244, 1
+  %v246 = add i32 %v245, 1
+  %v247 = add i32 %v246, 1
+  %v248 = add i32 %v247, 1
+  %v249 = add i32 %v248, 1
+  %v250 = add i32 %v249, 1
+  %v251 = add i32 %v250, 1
+  %v252 = add i32 %v251, 1
+  %v253 = add i32 %v252, 1
+  %v254 = add i32 %v253, 1
+  %v255 = add i32 %v254, 1
+  %v256 = add i32 %v255, 1
+  %v257 = add i32 %v256, 1
+  %v258 = add i32 %v257, 1
+  %v259 = add i32 %v258, 1
+  %v260 = add i32 %v259, 1
+  %v261 = add i32 %v260, 1
+  %v262 = add i32 %v261, 1
+  %v263 = add i32 %v262, 1
+  %v264 = add i32 %v263, 1
+  %v265 = add i32 %v264, 1
+  %v266 = add i32 %v265, 1
+  %v267 = add i32 %v266, 1
+  %v268 = add i32 %v267, 1
+  %v269 = add i32 %v268, 1
+  %v270 = add i32 %v269, 1
+  %v271 = add i32 %v270, 1
+  %v272 = add i32 %v271, 1
+  %v273 = add i32 %v272, 1
+  %v274 = add i32 %v273, 1
+  %v275 = add i32 %v274, 1
+  %v276 = add i32 %v275, 1
+  %v277 = add i32 %v276, 1
+  %v278 = add i32 %v277, 1
+  %v279 = add i32 %v278, 1
+  %v280 = add i32 %v279, 1
+  %v281 = add i32 %v280, 1
+  %v282 = add i32 %v281, 1
+  %v283 = add i32 %v282, 1
+  %v284 = add i32 %v283, 1
+  %v285 = add i32 %v284, 1
+  %v286 = add i32 %v285, 1
+  %v287 = add i32 %v286, 1
+  %v288 = add i32 %v287, 1
+  %v289 = add i32 %v288, 1
+  %v290 = add i32 %v289, 1
+  %v291 = add i32 %v290, 1
+  %v292 = add i32 %v291, 1
+  %v293 = add i32 %v292, 1
+  %v294 = add i32 %v293, 1
+  %v295 = add i32 %v294, 1
+  %v296 = add i32 %v295, 1
+  %v297 = add i32 %v296, 1
+  %v298 = add i32 %v297, 1
+  %v299 = add i32 %v298, 1
+  br label %use
+
+use:
+  %r = icmp ult i32 %v299, 1000
+  ret i1 %r
+
+exit:
+  ret i1 false
+}
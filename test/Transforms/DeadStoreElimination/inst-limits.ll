@@ -1,4 +1,6 @@
-; RUN: opt -S -dse < %s | FileCheck %s
+; RUN: opt -S -dse < %s | FileCheck %s --check-prefix=CHECK --check-prefix=MEMDEP
+; RUN: opt -S -aa-pipeline=basic-aa -passes=dse-memoryssa \
+; RUN:   -dse-memoryssa-scan-limit=1 < %s | FileCheck %s --check-prefix=CHECK --check-prefix=MSSA
 target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
 
 ; If there are two stores to the same location, DSE should be able to remove
@@ -129,11 +131,13 @@ entry:
 define i32 @test_outside_limit() {
 entry:
   ; The first store; later there is a second store to the same location
-  ; CHECK: store i32 1, i32* @x, align 4
+  ; MEMDEP: store i32 1, i32* @x, align 4
+  ; MSSA-NOT: store i32 1, i32* @x, align 4
   store i32 1, i32* @x, align 4
 
   ; Insert 99 dummy instructions between the two stores; this is
-  ; one too many instruction for the DSE to take place.
+  ; one too many instruction for the DSE to take place. With MemorySSA, the
+  ; limit only counts the memory accesses walked over, so it does take place.
   %0 = bitcast i32 0 to i32
   %1 = bitcast i32 0 to i32
   %2 = bitcast i32 0 to i32
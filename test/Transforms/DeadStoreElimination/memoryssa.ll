@@ -0,0 +1,132 @@
+; RUN: opt < %s -basicaa -dse -S | FileCheck %s
+; RUN: opt < %s -aa-pipeline=basic-aa -passes=dse-memoryssa -S | FileCheck %s
+
+; The same stores are deleted whether DSE finds their dependencies with
+; MemoryDependenceAnalysis or with MemorySSA.
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+declare void @free(i8* nocapture)
+declare void @use(i32*)
+declare void @llvm.memset.p0i8.i64(i8* nocapture, i8, i64, i32, i1)
+
+; CHECK-LABEL: @overwritten(
+; CHECK-NEXT: store i32 2, i32* %p
+; CHECK-NEXT: ret void
+define void @overwritten(i32* %p) {
+  store i32 1, i32* %p
+  store i32 2, i32* %p
+  ret void
+}
+
+; The may-aliasing store in between does not read %p.
+; CHECK-LABEL: @overwritten_past_mayalias(
+; CHECK-NEXT: store i32 2, i32* %q
+; CHECK-NEXT: store i32 3, i32* %p
+; CHECK-NEXT: ret void
+define void @overwritten_past_mayalias(i32* %p, i32* %q) {
+  store i32 1, i32* %p
+  store i32 2, i32* %q
+  store i32 3, i32* %p
+  ret void
+}
+
+; CHECK-LABEL: @read_in_between(
+; CHECK-NEXT: store i32 1, i32* %p
+; CHECK-NEXT: %v = load i32, i32* %q
+; CHECK-NEXT: store i32 2, i32* %p
+; CHECK-NEXT: ret i32 %v
+define i32 @read_in_between(i32* %p, i32* %q) {
+  store i32 1, i32* %p
+  %v = load i32, i32* %q
+  store i32 2, i32* %p
+  ret i32 %v
+}
+
+; CHECK-LABEL: @call_in_between(
+; CHECK-NEXT: store i32 1, i32* %p
+; CHECK-NEXT: call void @use(i32* %p)
+; CHECK-NEXT: store i32 2, i32* %p
+; CHECK-NEXT: ret void
+define void @call_in_between(i32* %p) {
+  store i32 1, i32* %p
+  call void @use(i32* %p)
+  store i32 2, i32* %p
+  ret void
+}
+
+; CHECK-LABEL: @memset_overwritten(
+; CHECK-NEXT: %c = bitcast i32* %p to i8*
+; CHECK-NEXT: call void @llvm.memset.p0i8.i64(i8* %c, i8 0, i64 4, i32 4, i1 false)
+; CHECK-NEXT: ret void
+define void @memset_overwritten(i32* %p) {
+  store i32 1, i32* %p
+  %c = bitcast i32* %p to i8*
+  call void @llvm.memset.p0i8.i64(i8* %c, i8 0, i64 4, i32 4, i1 false)
+  ret void
+}
+
+; CHECK-LABEL: @store_of_load(
+; CHECK-NEXT: %v = load i32, i32* %p
+; CHECK-NEXT: store i32 0, i32* %q
+; CHECK-NEXT: ret i32 %v
+define i32 @store_of_load(i32* %p, i32* noalias %q) {
+  %v = load i32, i32* %p
+  store i32 0, i32* %q
+  store i32 %v, i32* %p
+  ret i32 %v
+}
+
+; CHECK-LABEL: @store_of_load_clobbered(
+; CHECK: store i32 %v, i32* %p
+define i32 @store_of_load_clobbered(i32* %p) {
+  %v = load i32, i32* %p
+  call void @use(i32* %p)
+  store i32 %v, i32* %p
+  ret i32 %v
+}
+
+; The store in the predecessor is dead as well.
+; CHECK-LABEL: @free_after_store(
+; CHECK: entry:
+; CHECK-NEXT: br label %exit
+; CHECK: exit:
+; CHECK-NEXT: %c = bitcast i32* %p to i8*
+; CHECK-NEXT: call void @free(i8* %c)
+define void @free_after_store(i32* %p) {
+entry:
+  store i32 1, i32* %p
+  br label %exit
+
+exit:
+  %c = bitcast i32* %p to i8*
+  call void @free(i8* %c)
+  ret void
+}
+
+; The load in the block of the free keeps the store alive.
+; CHECK-LABEL: @free_after_read(
+; CHECK: entry:
+; CHECK-NEXT: store i32 1, i32* %p
+define i32 @free_after_read(i32* %p) {
+entry:
+  store i32 1, i32* %p
+  br label %exit
+
+exit:
+  %v = load i32, i32* %p
+  %c = bitcast i32* %p to i8*
+  call void @free(i8* %c)
+  ret i32 %v
+}
+
+; CHECK-LABEL: @dead_at_end(
+; CHECK-NEXT: %a = alloca i32
+; CHECK-NEXT: call void @use(i32* %a)
+; CHECK-NEXT: ret void
+define void @dead_at_end() {
+  %a = alloca i32
+  call void @use(i32* %a)
+  store i32 1, i32* %a
+  ret void
+}
@@ -0,0 +1,116 @@
+; RUN: opt < %s -basicaa -gvn -S | FileCheck %s
+; RUN: opt < %s -aa-pipeline=basic-aa -passes=gvn-memoryssa -S | FileCheck %s
+; RUN: opt < %s -aa-pipeline=basic-aa -passes=gvn-memoryssa -S \
+; RUN:   | FileCheck %s --check-prefix=MSSA
+
+; The same loads are eliminated whether GVN finds their dependencies with
+; MemoryDependenceAnalysis or with MemorySSA.
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+declare void @clobber(i32*)
+
+; CHECK-LABEL: @store_to_load(
+; CHECK-NOT: load
+; CHECK: ret i32 7
+define i32 @store_to_load(i32* %p) {
+  store i32 7, i32* %p
+  %v = load i32, i32* %p
+  ret i32 %v
+}
+
+; CHECK-LABEL: @store_to_load_other_block(
+; CHECK-NOT: load
+; CHECK: ret i32 %x
+define i32 @store_to_load_other_block(i32* %p, i32 %x, i1 %c) {
+entry:
+  store i32 %x, i32* %p
+  br i1 %c, label %then, label %exit
+
+then:
+  br label %exit
+
+exit:
+  %v = load i32, i32* %p
+  ret i32 %v
+}
+
+; The store to %q does not alias the load from %p.
+; CHECK-LABEL: @store_to_load_noalias(
+; CHECK-NOT: load
+; CHECK: ret i32 1
+define i32 @store_to_load_noalias(i32* noalias %p, i32* noalias %q) {
+  store i32 1, i32* %p
+  store i32 2, i32* %q
+  %v = load i32, i32* %p
+  ret i32 %v
+}
+
+; CHECK-LABEL: @load_to_load(
+; CHECK: %a = load i32, i32* %p
+; CHECK-NOT: load
+; CHECK: add i32 %a, %a
+define i32 @load_to_load(i32* %p, i1 %c) {
+entry:
+  %a = load i32, i32* %p
+  br i1 %c, label %then, label %exit
+
+then:
+  br label %exit
+
+exit:
+  %b = load i32, i32* %p
+  %r = add i32 %a, %b
+  ret i32 %r
+}
+
+; The call may write to %p, so the second load stays.
+; CHECK-LABEL: @load_clobbered(
+; CHECK: %a = load i32, i32* %p
+; CHECK: call void @clobber(i32* %p)
+; CHECK: %b = load i32, i32* %p
+define i32 @load_clobbered(i32* %p) {
+  %a = load i32, i32* %p
+  call void @clobber(i32* %p)
+  %b = load i32, i32* %p
+  %r = add i32 %a, %b
+  ret i32 %r
+}
+
+; A load of an alloca nothing was stored to yet is undef.
+; CHECK-LABEL: @alloca_undef(
+; CHECK-NOT: load
+; CHECK: ret i32 undef
+define i32 @alloca_undef() {
+  %a = alloca i32
+  %v = load i32, i32* %a
+  ret i32 %v
+}
+
+; The load of the low half is extracted from the wider store.
+; CHECK-LABEL: @store_to_narrower_load(
+; CHECK-NOT: load
+; CHECK: trunc i64 %x to i32
+define i32 @store_to_narrower_load(i64* %p, i64 %x) {
+  store i64 %x, i64* %p
+  %q = bitcast i64* %p to i32*
+  %v = load i32, i32* %q
+  ret i32 %v
+}
+
+; MemorySSA does not drive load PRE, the partially redundant load stays.
+; MSSA-LABEL: @partially_redundant(
+; MSSA: exit:
+; MSSA: %v = load i32, i32* %p
+define i32 @partially_redundant(i32* %p, i1 %c) {
+entry:
+  br i1 %c, label %then, label %exit
+
+then:
+  store i32 1, i32* %p
+  br label %exit
+
+exit:
+  %v = load i32, i32* %p
+  ret i32 %v
+}
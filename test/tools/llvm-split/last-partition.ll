@@ -0,0 +1,53 @@
+; Test that the last partition, which is split off in place rather than cloned,
+; declares the globals of the other partitions exactly like a cloned partition.
+; RUN: llvm-split -j3 -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 --check-prefix=CHECK02 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 --check-prefix=CHECK12 %s
+; RUN: llvm-dis -o - %t2 | FileCheck --check-prefix=CHECK02 --check-prefix=CHECK12 %s
+; RUN: llvm-dis -o - %t2 | FileCheck --check-prefix=DECL2 %s
+
+; DECL2-NOT: comdat
+; DECL2-NOT: blockaddress
+; DECL2-NOT: alias
+; DECL2-NOT: define
+
+$c = comdat any
+
+; CHECK0:  @cv = global i32 0
+; CHECK12: @cv = external global i32
+@cv = global i32 0, comdat($c)
+
+; CHECK1:  @ba = global i8* blockaddress(@bf, %exit)
+; CHECK02: @ba = external global i8*
+@ba = global i8* blockaddress(@bf, %exit)
+
+; CHECK0:  @av = alias i32, i32* @cv
+; CHECK12: @av = external global i32
+@av = alias i32, i32* @cv
+
+; CHECK0:  @af = alias void (), void ()* @cf
+@af = alias void (), void ()* @cf
+
+; CHECK0:  define void @cf()
+; CHECK12: declare void @cf()
+define void @cf() comdat($c) {
+  ret void
+}
+
+; CHECK1:  define i8* @bf()
+; CHECK02: declare i8* @bf()
+define i8* @bf() {
+entry:
+  br label %exit
+exit:
+  ret i8* blockaddress(@bf, %exit)
+}
+
+define void @user() {
+  store i32 0, i32* @av
+  call void @af()
+  %p = load i8*, i8** @ba
+  ret void
+}
+
+; CHECK12: declare void @af()
@@ -47,6 +47,7 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetSubtargetInfo.h"
@@ -90,6 +91,13 @@ OptLevel("O",
 static cl::opt<std::string>
 TargetTriple("mtriple", cl::desc("Override target triple for module"));
 
+static cl::opt<std::string>
+TimeTraceFile("time-trace-file",
+              cl::desc("Write a trace of the time spent in each pass on each "
+                       "IR unit to <filename>, in the Chrome trace event "
+                       "format"),
+              cl::value_desc("filename"));
+
 static cl::opt<bool> NoVerify("disable-verify", cl::Hidden,
                               cl::desc("Do not verify input module"));
 
@@ -259,11 +267,24 @@ int main(int argc, char **argv) {
   bool HasError = false;
   Context.setDiagnosticHandler(DiagnosticHandler, &HasError);
 
+  if (!TimeTraceFile.empty())
+    timeTraceProfilerInitialize();
+
   // Compile the module TimeCompilations times to give better compile time
   // metrics.
   for (unsigned I = TimeCompilations; I; --I)
     if (int RetVal = compileModule(argv, Context))
       return RetVal;
+
+  if (!TimeTraceFile.empty()) {
+    std::string ErrorInfo;
+    bool Written = timeTraceProfilerWrite(TimeTraceFile, ErrorInfo);
+    timeTraceProfilerCleanup();
+    if (!Written) {
+      errs() << argv[0] << ": " << TimeTraceFile << ": " << ErrorInfo << '\n';
+      return 1;
+    }
+  }
   return 0;
 }
 
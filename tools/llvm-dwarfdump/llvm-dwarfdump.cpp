@@ -73,6 +73,11 @@ static cl::opt<DIDumpType> DumpType(
         clEnumValN(DIDT_CUIndex, "cu_index", ".debug_cu_index"),
         clEnumValN(DIDT_TUIndex, "tu_index", ".debug_tu_index"), clEnumValEnd));
 
+static cl::opt<unsigned>
+    NumThreads("num-threads", cl::init(1),
+               cl::desc("Number of threads used to extract compile units "
+                        "before dumping them"));
+
 static void error(StringRef Filename, std::error_code EC) {
   if (!EC)
     return;
@@ -81,7 +86,11 @@ static void error(StringRef Filename, std::error_code EC) {
 }
 
 static void DumpObjectFile(ObjectFile &Obj, Twine Filename) {
-  std::unique_ptr<DIContext> DICtx(new DWARFContextInMemory(Obj));
+  std::unique_ptr<DWARFContext> DICtx(new DWARFContextInMemory(Obj));
+  if (NumThreads > 1 && (DumpType == DIDT_All || DumpType == DIDT_Info)) {
+    DICtx->setNumThreads(NumThreads);
+    DICtx->extractCompileUnitDIEs();
+  }
 
   outs() << Filename.str() << ":\tfile format " << Obj.getFileFormatName()
          << "\n\n";
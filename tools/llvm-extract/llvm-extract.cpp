@@ -109,15 +109,27 @@ int main(int argc, char **argv) {
   llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
   cl::ParseCommandLineOptions(argc, argv, "llvm extractor\n");
 
-  // Use lazy loading, since we only care about selected global values.
+  // Use lazy loading, since we only care about selected global values. The
+  // metadata is loaded lazily too, so that only the metadata they reference
+  // is read from large bitcode files.
   SMDiagnostic Err;
-  std::unique_ptr<Module> M = getLazyIRFileModule(InputFilename, Err, Context);
+  std::unique_ptr<Module> M =
+      getLazyIRFileModule(InputFilename, Err, Context,
+                          /*ShouldLazyLoadMetadata=*/true);
 
   if (!M.get()) {
     Err.print(argv[0], errs());
     return 1;
   }
 
+  // Attach the module-level metadata before globals get deleted. For large
+  // blocks this only reads the named metadata and the nodes it references,
+  // the others are read when a function referencing them is.
+  if (std::error_code EC = M->materializeMetadata()) {
+    errs() << argv[0] << ": error reading input: " << EC.message() << "\n";
+    return 1;
+  }
+
   // Use SetVector to avoid duplicates.
   SetVector<GlobalValue *> GVs;
 
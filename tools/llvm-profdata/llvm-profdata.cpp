@@ -215,23 +215,21 @@ static void mergeInstrProfile(const WeightedFileVector &Inputs,
     }
     Pool.wait();
 
-    // Merge the writer contexts together (~ lg(NumThreads) serial steps).
-    unsigned Mid = Contexts.size() / 2;
-    unsigned End = Contexts.size();
-    assert(Mid > 0 && "Expected more than one context");
-    do {
-      for (unsigned I = 0; I < Mid; ++I)
-        Pool.async(mergeWriterContexts, Contexts[I].get(),
-                   Contexts[I + Mid].get());
-      Pool.wait();
-      if (End & 1) {
-        Pool.async(mergeWriterContexts, Contexts[0].get(),
-                   Contexts[End - 1].get());
-        Pool.wait();
-      }
-      End = Mid;
-      Mid /= 2;
-    } while (Mid > 0);
+    // Merge the writer contexts together (~ lg(NumThreads) serial steps). Each
+    // step merges the two halves of a range of contexts, with the right half
+    // reduced by a nested task while the current worker reduces the left one.
+    std::function<void(unsigned, unsigned)> MergeRange = [&](unsigned Begin,
+                                                             unsigned End) {
+      if (End - Begin < 2)
+        return;
+      unsigned Mid = Begin + (End - Begin) / 2;
+      auto RightHalf = Pool.async(MergeRange, Mid, End);
+      MergeRange(Begin, Mid);
+      Pool.wait(RightHalf);
+      mergeWriterContexts(Contexts[Begin].get(), Contexts[Mid].get());
+    };
+    assert(Contexts.size() > 1 && "Expected more than one context");
+    Pool.wait(Pool.async(MergeRange, 0U, unsigned(Contexts.size())));
   }
 
   // Handle deferred hard errors encountered during merging.
@@ -246,6 +244,51 @@ static void mergeInstrProfile(const WeightedFileVector &Inputs,
     Writer.write(Output);
 }
 
+/// Merge indexed profiles without loading them in memory: the records of each
+/// function are read from the memory mapped inputs and merged only when the
+/// function is written out.
+static void mergeIndexedInstrProfile(const WeightedFileVector &Inputs,
+                                     StringRef OutputFilename,
+                                     bool OutputSparse) {
+  if (OutputFilename.compare("-") == 0)
+    exitWithError("Cannot write indexed profdata format to stdout.");
+
+  std::vector<std::unique_ptr<IndexedInstrProfReader>> Readers;
+  std::vector<InstrProfWriter::WeightedInput> WeightedReaders;
+  for (const auto &Input : Inputs) {
+    auto ReaderOrErr = IndexedInstrProfReader::create(Input.Filename);
+    if (Error E = ReaderOrErr.takeError())
+      exitWithError(std::move(E), Input.Filename);
+    Readers.push_back(std::move(ReaderOrErr.get()));
+    WeightedReaders.push_back(
+        std::make_pair(Readers.back().get(), Input.Weight));
+  }
+
+  std::error_code EC;
+  raw_fd_ostream Output(OutputFilename.data(), EC, sys::fs::F_None);
+  if (EC)
+    exitWithErrorCode(EC, OutputFilename);
+
+  SmallSet<instrprof_error, 4> WriterErrorCodes;
+  InstrProfWriter Writer(OutputSparse);
+  Error E = Writer.writeMerged(
+      Output, WeightedReaders, [&](Error E, StringRef FuncName) {
+        // Only show hint the first time an error occurs.
+        instrprof_error IPE = InstrProfError::take(std::move(E));
+        bool FirstTime = WriterErrorCodes.insert(IPE).second;
+        handleMergeWriterError(make_error<InstrProfError>(IPE), "", FuncName,
+                               FirstTime);
+      });
+  if (E) {
+    // Don't leave a partially written profile behind.
+    Output.close();
+    sys::fs::remove(OutputFilename);
+    exitWithError(make_error<StringError>(
+        "Merge IR generated profile with Clang generated profile.",
+        std::error_code()));
+  }
+}
+
 static sampleprof::SampleProfileFormat FormatMap[] = {
     sampleprof::SPF_None, sampleprof::SPF_Text, sampleprof::SPF_Binary,
     sampleprof::SPF_GCC};
@@ -408,6 +451,11 @@ static int merge_main(int argc, const char *argv[]) {
       cl::desc("Number of merge threads to use (default: autodetect)"));
   cl::alias NumThreadsA("j", cl::desc("Alias for --num-threads"),
                         cl::aliasopt(NumThreads));
+  cl::opt<bool> Stream(
+      "stream", cl::init(false),
+      cl::desc("Merge indexed profiles one function at a time instead of "
+               "loading them in memory (only meaningful for -instr with "
+               "indexed inputs and a binary output)"));
 
   cl::ParseCommandLineOptions(argc, argv, "LLVM profile data merger\n");
 
@@ -432,7 +480,13 @@ static int merge_main(int argc, const char *argv[]) {
     return 0;
   }
 
-  if (ProfileKind == instr)
+  if (ProfileKind == instr && Stream) {
+    if (OutputFormat != PF_Binary)
+      exitWithError("-stream requires the binary output format.");
+    if (NumThreads.getNumOccurrences())
+      exitWithError("-stream can't be used with -num-threads.");
+    mergeIndexedInstrProfile(WeightedInputs, OutputFilename, OutputSparse);
+  } else if (ProfileKind == instr)
     mergeInstrProfile(WeightedInputs, OutputFilename, OutputFormat,
                       OutputSparse, NumThreads);
   else
@@ -86,6 +86,11 @@ static cl::opt<int> ClPrintSourceContextLines(
     "print-source-context-lines", cl::init(0),
     cl::desc("Print N number of source file context"));
 
+static cl::opt<std::string>
+    ClCachePath("cache-path", cl::init(""),
+                cl::desc("Directory of a persistent cache of symbolization "
+                         "results, reused across runs"));
+
 template<typename T>
 static bool error(Expected<T> &ResOrErr) {
   if (ResOrErr)
@@ -149,6 +154,7 @@ int main(int argc, char **argv) {
   cl::ParseCommandLineOptions(argc, argv, "llvm-symbolizer\n");
   LLVMSymbolizer::Options Opts(ClPrintFunctions, ClUseSymbolTable, ClDemangle,
                                ClUseRelativeAddress, ClDefaultArch);
+  Opts.CachePath = ClCachePath;
 
   for (const auto &hint : ClDsymHint) {
     if (sys::path::extension(hint) == ".dSYM") {
@@ -200,5 +206,9 @@ int main(int argc, char **argv) {
     outs().flush();
   }
 
+  if (std::error_code EC = Symbolizer.flush())
+    errs() << "LLVMSymbolizer: error writing the cache: " << EC.message()
+           << "\n";
+
   return 0;
 }
@@ -47,6 +47,14 @@ static cl::opt<std::string>
                         "pipeline for handling managed aliasing queries"),
                cl::Hidden);
 
+// This flag enables running the function pipelines of the "passes" flag that
+// are nested directly in module pipelines on several threads.
+static cl::opt<unsigned> FunctionPipelineThreads(
+    "function-pipeline-threads",
+    cl::desc("Number of threads optimizing the functions of the module in "
+             "function pipelines nested directly in module pipelines"),
+    cl::init(1), cl::Hidden);
+
 bool llvm::runPassPipeline(StringRef Arg0, LLVMContext &Context, Module &M,
                            TargetMachine *TM, tool_output_file *Out,
                            StringRef PassPipeline, OutputKind OK,
@@ -54,6 +62,8 @@ bool llvm::runPassPipeline(StringRef Arg0, LLVMContext &Context, Module &M,
                            bool ShouldPreserveAssemblyUseListOrder,
                            bool ShouldPreserveBitcodeUseListOrder) {
   PassBuilder PB(TM);
+  if (FunctionPipelineThreads > 1)
+    PB.setParallelFunctionPipelines(FunctionPipelineThreads, AAPipeline);
 
   // Specially handle the alias analysis manager so that we can register
   // a custom pipeline of AA passes with it.
@@ -48,6 +48,7 @@
 #include "llvm/Support/SystemUtils.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
@@ -195,6 +196,13 @@ DefaultDataLayout("default-data-layout",
           cl::desc("data layout string to use if not specified by module"),
           cl::value_desc("layout-string"), cl::init(""));
 
+static cl::opt<std::string>
+TimeTraceFile("time-trace-file",
+              cl::desc("Write a trace of the time spent in each pass on each "
+                       "IR unit to <filename>, in the Chrome trace event "
+                       "format"),
+              cl::value_desc("filename"));
+
 static cl::opt<bool> PreserveBitcodeUseListOrder(
     "preserve-bc-uselistorder",
     cl::desc("Preserve use-list order when writing LLVM bitcode."),
@@ -322,6 +330,19 @@ static TargetMachine* GetTargetMachine(Triple TheTriple, StringRef CPUStr,
                                         CMModel, GetCodeGenOptLevel());
 }
 
+/// Write the trace requested with -time-trace-file, if any. Returns false if
+/// it couldn't be written.
+static bool writeTimeTrace(const char *Argv0) {
+  if (TimeTraceFile.empty())
+    return true;
+  std::string ErrorInfo;
+  bool Written = timeTraceProfilerWrite(TimeTraceFile, ErrorInfo);
+  timeTraceProfilerCleanup();
+  if (!Written)
+    errs() << Argv0 << ": " << TimeTraceFile << ": " << ErrorInfo << '\n';
+  return Written;
+}
+
 #ifdef LINK_POLLY_INTO_TOOLS
 namespace polly {
 void initializePollyPasses(llvm::PassRegistry &Registry);
@@ -383,6 +404,9 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  if (!TimeTraceFile.empty())
+    timeTraceProfilerInitialize();
+
   SMDiagnostic Err;
 
   Context.setDiscardValueNames(DiscardValueNames);
@@ -474,11 +498,12 @@ int main(int argc, char **argv) {
     // The user has asked to use the new pass manager and provided a pipeline
     // string. Hand off the rest of the functionality to the new code for that
     // layer.
-    return runPassPipeline(argv[0], Context, *M, TM.get(), Out.get(),
-                           PassPipeline, OK, VK, PreserveAssemblyUseListOrder,
-                           PreserveBitcodeUseListOrder)
-               ? 0
-               : 1;
+    bool Succeeded = runPassPipeline(
+        argv[0], Context, *M, TM.get(), Out.get(), PassPipeline, OK, VK,
+        PreserveAssemblyUseListOrder, PreserveBitcodeUseListOrder);
+    if (!writeTimeTrace(argv[0]))
+      return 1;
+    return Succeeded ? 0 : 1;
   }
 
   // Create a PassManager to hold and optimize the collection of passes we are
@@ -678,6 +703,9 @@ int main(int argc, char **argv) {
   // Now that we have all of the passes ready, run them.
   Passes.run(*M);
 
+  if (!writeTimeTrace(argv[0]))
+    return 1;
+
   // Compare the two outputs and make sure they're the same
   if (RunTwice) {
     assert(Out);
@@ -204,6 +204,39 @@ TEST_F(AliasAnalysisTest, getModRefInfo) {
   EXPECT_EQ(AA.getModRefInfo(AtomicRMW), MRI_ModRef);
 }
 
+TEST_F(AliasAnalysisTest, BasicAAQueryCacheInvalidation) {
+  // Setup function.
+  auto *PtrType = Type::getInt32PtrTy(C);
+  FunctionType *FTy = FunctionType::get(Type::getVoidTy(C), {PtrType}, false);
+  auto *F = cast<Function>(M.getOrInsertFunction("f", FTy));
+  auto *BB = BasicBlock::Create(C, "entry", F);
+  auto *I64 = Type::getInt64Ty(C);
+  Argument *P = &*F->arg_begin();
+  auto *A = GetElementPtrInst::CreateInBounds(P, ConstantInt::get(I64, 1), "a",
+                                              BB);
+  auto *B = GetElementPtrInst::CreateInBounds(P, ConstantInt::get(I64, 2), "b",
+                                              BB);
+  ReturnInst::Create(C, nullptr, BB);
+
+  AC.reset(new AssumptionCache(*F));
+  BasicAAResult BAA(M.getDataLayout(), TLI, *AC, nullptr, nullptr,
+                    /*CacheAcrossQueries=*/true);
+  MemoryLocation LocA(A, 4), LocB(B, 4);
+  EXPECT_EQ(NoAlias, BAA.alias(LocA, LocB));
+
+  // Rewrite an index in place, which the value handles do not see, and tell
+  // the result that a pass preserving it changed the function.
+  B->setOperand(1, ConstantInt::get(I64, 1));
+  PreservedAnalyses PA;
+  PA.preserve<BasicAA>();
+  EXPECT_FALSE(BAA.invalidate(*F, PA));
+  EXPECT_EQ(MustAlias, BAA.alias(LocA, LocB));
+
+  // Passes that change nothing leave the caches alone.
+  EXPECT_FALSE(BAA.invalidate(*F, PreservedAnalyses::all()));
+  EXPECT_EQ(MustAlias, BAA.alias(LocB, LocA));
+}
+
 class AAPassInfraTest : public testing::Test {
 protected:
   LLVMContext C;
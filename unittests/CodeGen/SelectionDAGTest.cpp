@@ -0,0 +1,115 @@
+//===- SelectionDAGTest.cpp - SelectionDAG memory management tests --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/SelectionDAG.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineModuleInfo.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Target/TargetLoweringObjectFile.h"
+#include "llvm/Target/TargetMachine.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+class SelectionDAGTest : public testing::Test {
+protected:
+  static void SetUpTestCase() {
+    InitializeAllTargets();
+    InitializeAllTargetMCs();
+  }
+
+  void SetUp() override {
+    // As we lack a dedicated always available target for unittests, we go
+    // for "x86_64" which should be available in most builds.
+    Triple TargetTriple("x86_64--");
+    std::string Error;
+    const Target *T = TargetRegistry::lookupTarget("", TargetTriple, Error);
+    if (!T)
+      return;
+    TargetOptions Options;
+    TM.reset(T->createTargetMachine("x86_64", "", "", Options, None,
+                                    CodeModel::Default, CodeGenOpt::None));
+
+    M.reset(new Module("SelectionDAGTest", Context));
+    M->setDataLayout(TM->createDataLayout());
+    auto *F = cast<Function>(M->getOrInsertFunction(
+        "f", FunctionType::get(Type::getVoidTy(Context), false)));
+    MMI.reset(new MachineModuleInfo(*TM->getMCAsmInfo(),
+                                    *TM->getMCRegisterInfo(),
+                                    TM->getObjFileLowering()));
+    MF.reset(new MachineFunction(F, *TM, 0, *MMI));
+    DAG.reset(new SelectionDAG(*TM, CodeGenOpt::None));
+    DAG->init(*MF);
+  }
+
+  /// Builds an add of two registers, which has two operands and is not
+  /// folded.
+  SDNode *buildAdd() {
+    SDLoc Loc;
+    SDValue R1 = DAG->getRegister(1, MVT::i32);
+    SDValue R2 = DAG->getRegister(2, MVT::i32);
+    return DAG->getNode(ISD::ADD, Loc, MVT::i32, R1, R2).getNode();
+  }
+
+  LLVMContext Context;
+  std::unique_ptr<TargetMachine> TM;
+  std::unique_ptr<Module> M;
+  std::unique_ptr<MachineModuleInfo> MMI;
+  std::unique_ptr<MachineFunction> MF;
+  std::unique_ptr<SelectionDAG> DAG;
+};
+
+TEST_F(SelectionDAGTest, OperandsRecycledAcrossClear) {
+  if (!DAG)
+    return;
+
+  const SDUse *Ops = buildAdd()->op_begin();
+  DAG->clear();
+
+  // The shuffle mask comes from a separate allocator, and the operand array
+  // freed by clear() is handed out again.
+  SDLoc Loc;
+  SDValue V1 = DAG->getRegister(1, MVT::v4i32);
+  SDValue V2 = DAG->getRegister(2, MVT::v4i32);
+  int Mask[] = {0, 5, 2, 7};
+  auto *Shuffle = cast<ShuffleVectorSDNode>(
+      DAG->getVectorShuffle(MVT::v4i32, Loc, V1, V2, Mask).getNode());
+  EXPECT_EQ(Ops, Shuffle->op_begin());
+  EXPECT_EQ(V1, Shuffle->getOperand(0));
+  EXPECT_EQ(V2, Shuffle->getOperand(1));
+
+  // Operands allocated afterwards do not overlap the mask.
+  SDNode *Add = buildAdd();
+  EXPECT_EQ(ISD::ADD, Add->getOpcode());
+  EXPECT_EQ(makeArrayRef(Mask), Shuffle->getMask());
+}
+
+#ifdef LLVM_ENABLE_ABI_BREAKING_CHECKS
+TEST_F(SelectionDAGTest, PersistentIdsRestartAfterClear) {
+  if (!DAG)
+    return;
+
+  SDNode *Add = buildAdd();
+  uint16_t Id = Add->PersistentId;
+  EXPECT_EQ(Id, Add->getOperand(1)->PersistentId + 1);
+  EXPECT_EQ(Id, Add->getOperand(0)->PersistentId + 2);
+
+  DAG->clear();
+  EXPECT_EQ(Id, buildAdd()->PersistentId);
+}
+#endif
+
+} // end anonymous namespace
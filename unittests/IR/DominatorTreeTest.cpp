@@ -10,6 +10,7 @@
 #include "llvm/IR/Dominators.h"
 #include "llvm/Analysis/PostDominators.h"
 #include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/CFG.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
@@ -251,6 +252,159 @@ namespace llvm {
       Passes.add(P);
       Passes.run(*M);
     }
+
+    typedef DominatorTree::UpdateType UpdateType;
+
+    BasicBlock *getBlock(Function &F, StringRef Name) {
+      for (BasicBlock &BB : F)
+        if (BB.getName() == Name)
+          return &BB;
+      llvm_unreachable("No such block");
+    }
+
+    // Check that both trees match the ones computed from scratch.
+    void expectUpToDate(Function &F, DominatorTree &DT,
+                        PostDominatorTree &PDT) {
+      DominatorTree FreshDT(F);
+      EXPECT_FALSE(DT.compare(FreshDT));
+      PostDominatorTree FreshPDT;
+      FreshPDT.recalculate(F);
+      EXPECT_FALSE(PDT.compare(FreshPDT));
+    }
+
+    // Make BB branch to Succs, or return if there are none, and return the
+    // updates describing the change.
+    std::vector<UpdateType> setSuccessors(BasicBlock *BB,
+                                          ArrayRef<BasicBlock *> Succs) {
+      SmallPtrSet<BasicBlock *, 4> OldSuccs(succ_begin(BB), succ_end(BB));
+      SmallPtrSet<BasicBlock *, 4> NewSuccs(Succs.begin(), Succs.end());
+      std::vector<UpdateType> Updates;
+      for (BasicBlock *Succ : OldSuccs)
+        if (!NewSuccs.count(Succ))
+          Updates.push_back({DominatorTree::Delete, BB, Succ});
+      for (BasicBlock *Succ : NewSuccs)
+        if (!OldSuccs.count(Succ))
+          Updates.push_back({DominatorTree::Insert, BB, Succ});
+
+      BB->getTerminator()->eraseFromParent();
+      LLVMContext &Context = BB->getContext();
+      if (Succs.empty()) {
+        ReturnInst::Create(Context, BB);
+        return Updates;
+      }
+      Value *Cond = &*BB->getParent()->arg_begin();
+      SwitchInst *SI = SwitchInst::Create(Cond, Succs[0], Succs.size(), BB);
+      for (unsigned I = 1, E = Succs.size(); I != E; ++I)
+        SI->addCase(ConstantInt::get(Type::getInt32Ty(Context), I), Succs[I]);
+      return Updates;
+    }
+
+    TEST(DominatorTree, ApplyUpdates) {
+      const char *ModuleString =
+          "define void @f(i32 %x) {\n"
+          "entry:\n"
+          "  br label %a\n"
+          "a:\n"
+          "  switch i32 %x, label %b [ i32 1, label %c ]\n"
+          "b:\n"
+          "  br label %d\n"
+          "c:\n"
+          "  br label %d\n"
+          "d:\n"
+          "  br label %e\n"
+          "e:\n"
+          "  ret void\n"
+          "u1:\n"
+          "  br label %u2\n"
+          "u2:\n"
+          "  br label %e\n"
+          "}\n";
+      LLVMContext Context;
+      SMDiagnostic Err;
+      std::unique_ptr<Module> M = parseAssemblyString(ModuleString, Err,
+                                                      Context);
+      Function &F = *M->getFunction("f");
+      DominatorTree DT(F);
+      PostDominatorTree PDT;
+      PDT.recalculate(F);
+      BasicBlock *A = getBlock(F, "a"), *B = getBlock(F, "b"),
+                 *C = getBlock(F, "c"), *D = getBlock(F, "d"),
+                 *E = getBlock(F, "e"), *U1 = getBlock(F, "u1");
+
+      // Bypass d: e is now dominated by a.
+      auto Updates = setSuccessors(B, {D, E});
+      DT.applyUpdates(Updates);
+      PDT.applyUpdates(Updates);
+      expectUpToDate(F, DT, PDT);
+      EXPECT_EQ(DT.getNode(E)->getIDom()->getBlock(), A);
+
+      // Make u1 and u2 reachable. u2 branches back into the tree.
+      Updates = setSuccessors(C, {D, U1});
+      DT.applyUpdates(Updates);
+      PDT.applyUpdates(Updates);
+      expectUpToDate(F, DT, PDT);
+      EXPECT_EQ(DT.getNode(U1)->getIDom()->getBlock(), C);
+
+      // Make c unreachable, which takes u1 and u2 along.
+      Updates = setSuccessors(A, {B});
+      DT.applyUpdates(Updates);
+      PDT.applyUpdates(Updates);
+      expectUpToDate(F, DT, PDT);
+      EXPECT_FALSE(DT.getNode(C));
+      EXPECT_FALSE(DT.getNode(U1));
+
+      // Several changes at once, one of which adds an exit.
+      Updates = setSuccessors(A, {B, C});
+      auto MoreUpdates = setSuccessors(D, {});
+      Updates.insert(Updates.end(), MoreUpdates.begin(), MoreUpdates.end());
+      DT.applyUpdates(Updates);
+      PDT.applyUpdates(Updates);
+      expectUpToDate(F, DT, PDT);
+    }
+
+    // Rewire random blocks of a function many times over, updating the trees
+    // after each batch of changes.
+    TEST(DominatorTree, ApplyRandomUpdates) {
+      const unsigned NumBlocks = 16;
+      std::string ModuleString = "define void @f(i32 %x) {\nentry:\n";
+      for (unsigned I = 0; I != NumBlocks; ++I)
+        ModuleString += "  br label %b" + std::to_string(I) + "\nb" +
+                        std::to_string(I) + ":\n";
+      ModuleString += "  ret void\n}\n";
+      LLVMContext Context;
+      SMDiagnostic Err;
+      std::unique_ptr<Module> M = parseAssemblyString(ModuleString, Err,
+                                                      Context);
+      Function &F = *M->getFunction("f");
+      std::vector<BasicBlock *> Blocks;
+      for (BasicBlock &BB : F)
+        Blocks.push_back(&BB);
+      DominatorTree DT(F);
+      PostDominatorTree PDT;
+      PDT.recalculate(F);
+
+      uint64_t Seed = 42;
+      auto Random = [&Seed](unsigned Limit) {
+        Seed = Seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return unsigned(Seed >> 33) % Limit;
+      };
+      for (unsigned Round = 0; Round != 500; ++Round) {
+        std::vector<UpdateType> Updates;
+        for (unsigned Changes = 1 + Random(3); Changes; --Changes) {
+          BasicBlock *BB = Blocks[Random(Blocks.size())];
+          // Mostly branch, sometimes return. The entry cannot be a target.
+          std::vector<BasicBlock *> Succs;
+          for (unsigned NumSuccs = Random(8) ? 1 + Random(3) : 0; NumSuccs;
+               --NumSuccs)
+            Succs.push_back(Blocks[1 + Random(Blocks.size() - 1)]);
+          auto BBUpdates = setSuccessors(BB, Succs);
+          Updates.insert(Updates.end(), BBUpdates.begin(), BBUpdates.end());
+        }
+        DT.applyUpdates(Updates);
+        PDT.applyUpdates(Updates);
+        expectUpToDate(F, DT, PDT);
+      }
+    }
   }
 }
 
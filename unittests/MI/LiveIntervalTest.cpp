@@ -6,6 +6,7 @@
 #include "llvm/CodeGen/MachineModuleInfo.h"
 #include "llvm/CodeGen/MachineRegisterInfo.h"
 #include "llvm/CodeGen/Passes.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
@@ -353,6 +354,32 @@ TEST(LiveIntervalTest, MoveOverUndefUse1) {
   });
 }
 
+TEST(LiveIntervalTest, MoveDownLazyUnqueried) {
+  // In lazy mode, an interval nobody queried before the move must be computed
+  // from the new positions, not have the move applied to it once more.
+  auto &Lazy = static_cast<cl::opt<bool> &>(
+      *cl::getRegisteredOptions()["lazy-live-intervals"]);
+  Lazy = true;
+  liveIntervalTest(
+"    %0 = IMPLICIT_DEF\n"
+"    NOOP\n"
+"    NOOP\n"
+"    RETQ %0\n",
+  [](MachineFunction &MF, LiveIntervals &LIS) {
+    unsigned Reg = TargetRegisterInfo::index2VirtReg(0);
+    ASSERT_TRUE(LIS.isLazy());
+    ASSERT_FALSE(LIS.hasInterval(Reg));
+    testHandleMove(MF, LIS, 0, 2);
+    EXPECT_FALSE(LIS.hasInterval(Reg));
+
+    MachineInstr &Def = *MF.getRegInfo().def_instr_begin(Reg);
+    const LiveInterval &LI = LIS.getInterval(Reg);
+    ASSERT_EQ(1u, LI.size());
+    EXPECT_EQ(LIS.getInstructionIndex(Def).getRegSlot(), LI.beginIndex());
+  });
+  Lazy = false;
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   initLLVM();
@@ -0,0 +1,109 @@
+//===- ArchiveTest.cpp - Tests for Archive --------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Object/Archive.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <thread>
+
+using namespace llvm;
+using namespace object;
+
+namespace {
+
+void writeHeader(raw_ostream &OS, StringRef Name, size_t Size) {
+  std::string SizeStr = std::to_string(Size);
+  OS << Name << std::string(16 - Name.size(), ' ') << "0           "
+     << "0     0     644     " << SizeStr
+     << std::string(10 - SizeStr.size(), ' ') << "`\n";
+}
+
+void writeBE32(raw_ostream &OS, uint32_t V) {
+  char Buf[4];
+  support::endian::write32be(Buf, V);
+  OS.write(Buf, 4);
+}
+
+// A GNU archive with members a.o and b.o. Its symbol table defines foo in
+// a.o, bar in b.o and foo again in b.o.
+std::string makeArchive() {
+  const size_t SymTabSize = 4 + 3 * 4 + 12;
+  const uint32_t AOffset = 8 + 60 + SymTabSize;
+  const uint32_t BOffset = AOffset + 60 + 6;
+
+  std::string Data;
+  raw_string_ostream OS(Data);
+  OS << "!<arch>\n";
+  writeHeader(OS, "/", SymTabSize);
+  writeBE32(OS, 3);
+  writeBE32(OS, AOffset);
+  writeBE32(OS, BOffset);
+  writeBE32(OS, BOffset);
+  OS.write("foo\0bar\0foo\0", 12);
+  writeHeader(OS, "a.o/", 6);
+  OS << "aaaaa\n";
+  writeHeader(OS, "b.o/", 6);
+  OS << "bbbbb\n";
+  return OS.str();
+}
+
+std::string findMember(const Archive &A, StringRef Sym) {
+  auto ChildOrErr = A.findSym(Sym);
+  if (!ChildOrErr) {
+    consumeError(ChildOrErr.takeError());
+    return "<error>";
+  }
+  if (!*ChildOrErr)
+    return "<none>";
+  ErrorOr<StringRef> NameOrErr = (*ChildOrErr)->getName();
+  return NameOrErr ? NameOrErr->str() : "<error>";
+}
+
+TEST(ArchiveTest, FindSym) {
+  std::string Data = makeArchive();
+  Expected<std::unique_ptr<Archive>> AOrErr =
+      Archive::create(MemoryBufferRef(Data, "test.a"));
+  ASSERT_TRUE(!!AOrErr);
+  Archive &A = **AOrErr;
+  ASSERT_EQ(3u, A.getNumberOfSymbols());
+
+  EXPECT_EQ("a.o", findMember(A, "foo"));
+  EXPECT_EQ("b.o", findMember(A, "bar"));
+  EXPECT_EQ("<none>", findMember(A, "baz"));
+  EXPECT_EQ("<none>", findMember(A, ""));
+  // Repeated lookups use the index built by the first one.
+  EXPECT_EQ("a.o", findMember(A, "foo"));
+  EXPECT_EQ("<none>", findMember(A, "baz"));
+}
+
+#if LLVM_ENABLE_THREADS
+TEST(ArchiveTest, FindSymConcurrently) {
+  std::string Data = makeArchive();
+  Expected<std::unique_ptr<Archive>> AOrErr =
+      Archive::create(MemoryBufferRef(Data, "test.a"));
+  ASSERT_TRUE(!!AOrErr);
+  Archive &A = **AOrErr;
+
+  // The first lookups race to build the index.
+  std::string Results[4];
+  std::vector<std::thread> Threads;
+  for (unsigned I = 0; I != 4; ++I)
+    Threads.emplace_back([&, I] {
+      Results[I] = findMember(A, I % 2 ? "bar" : "baz");
+    });
+  for (std::thread &T : Threads)
+    T.join();
+  for (unsigned I = 0; I != 4; ++I)
+    EXPECT_EQ(I % 2 ? "b.o" : "<none>", Results[I]);
+}
+#endif
+
+} // end anonymous namespace
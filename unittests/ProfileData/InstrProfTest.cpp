@@ -140,6 +140,42 @@ TEST_P(MaybeSparseInstrProfTest, get_function_counts) {
   ASSERT_TRUE(ErrorEquals(instrprof_error::unknown_function, std::move(E2)));
 }
 
+TEST_P(MaybeSparseInstrProfTest, get_function_counts_in_place) {
+  InstrProfRecord Record1("foo", 0x1234, {1, 2});
+  InstrProfRecord Record2("foo", 0x1235, {3, 4, 5});
+  // The value data of the first record has to be skipped to find the second.
+  Record1.reserveSites(IPVK_IndirectCallTarget, 1);
+  InstrProfValueData VD[] = {{(uint64_t)"callee", 7}};
+  Record1.addValueData(IPVK_IndirectCallTarget, 0, VD, 1, nullptr);
+  NoError(Writer.addRecord(std::move(Record1)));
+  NoError(Writer.addRecord(std::move(Record2)));
+  auto Profile = Writer.writeBuffer();
+  readProfile(std::move(Profile));
+
+  ArrayRef<support::ulittle64_t> Counts;
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("foo", 0x1235, Counts)));
+  ASSERT_EQ(3U, Counts.size());
+  ASSERT_EQ(3U, Counts[0]);
+  ASSERT_EQ(4U, Counts[1]);
+  ASSERT_EQ(5U, Counts[2]);
+
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("foo", 0x1234, Counts)));
+  ASSERT_EQ(2U, Counts.size());
+  ASSERT_EQ(1U, Counts[0]);
+  ASSERT_EQ(2U, Counts[1]);
+
+  Error E1 = Reader->getFunctionCounts("foo", 0x5678, Counts);
+  ASSERT_TRUE(ErrorEquals(instrprof_error::hash_mismatch, std::move(E1)));
+
+  Error E2 = Reader->getFunctionCounts("bar", 0x1234, Counts);
+  ASSERT_TRUE(ErrorEquals(instrprof_error::unknown_function, std::move(E2)));
+
+  std::vector<StringRef> Names;
+  Reader->getFunctionNames(Names);
+  ASSERT_EQ(1U, Names.size());
+  ASSERT_EQ(StringRef("foo"), Names[0]);
+}
+
 // Profile data is copied from general.proftext
 TEST_F(InstrProfTest, get_profile_summary) {
   InstrProfRecord Record1("func1", 0x1234, {97531});
@@ -9,6 +9,7 @@
 
 #include "llvm/Support/ThreadPool.h"
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Triple.h"
@@ -17,6 +18,8 @@
 
 #include "gtest/gtest.h"
 
+#include <numeric>
+
 using namespace llvm;
 
 // Fixture for the unittests, allowing to *temporarily* disable the unittests
@@ -166,3 +169,70 @@ TEST_F(ThreadPoolTest, PoolDestruction) {
   }
   ASSERT_EQ(5, checked_in);
 }
+
+TEST_F(ThreadPoolTest, NestedWait) {
+  CHECK_UNSUPPORTED();
+  // Test that a task can spawn subtasks and wait on them, even when the pool
+  // has a single worker that must run them itself.
+  std::atomic_int checked_in{0};
+  ThreadPool Pool{1};
+  auto Outer = Pool.async([&Pool, &checked_in] {
+    ASSERT_TRUE(Pool.isWorkerThread());
+    SmallVector<std::shared_future<ThreadPool::VoidTy>, 8> Subtasks;
+    for (size_t i = 0; i < 8; ++i)
+      Subtasks.push_back(Pool.async([&checked_in] { ++checked_in; }));
+    for (auto &Subtask : Subtasks)
+      Pool.wait(Subtask);
+    ASSERT_EQ(8, checked_in);
+    ++checked_in;
+  });
+  ASSERT_FALSE(Pool.isWorkerThread());
+  Pool.wait(Outer);
+  ASSERT_EQ(9, checked_in);
+  Pool.wait();
+}
+
+TEST_F(ThreadPoolTest, NestedWaitRunsLateTasks) {
+  CHECK_UNSUPPORTED();
+  // Test that a worker waiting on a task running elsewhere still picks up
+  // tasks queued afterwards: here the other worker is stuck until the late
+  // task has run, so only the waiting worker can run it.
+  ThreadPool Pool{2};
+  std::promise<void> Started, LateDone;
+  std::shared_future<void> LateDoneFuture = LateDone.get_future().share();
+  auto Blocker = Pool.async([&] {
+    Started.set_value();
+    LateDoneFuture.wait();
+  });
+  Started.get_future().wait();
+  auto Waiter = Pool.async([&] { Pool.wait(Blocker); });
+  // Give the waiter a chance to run out of work before queuing the late task.
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  Pool.async([&] { LateDone.set_value(); });
+  Pool.wait(Waiter);
+  Pool.wait();
+}
+
+static unsigned ParallelSum(ThreadPool &Pool, ArrayRef<unsigned> Values) {
+  if (Values.size() <= 4)
+    return std::accumulate(Values.begin(), Values.end(), 0U);
+  unsigned Mid = Values.size() / 2;
+  unsigned RightSum = 0;
+  auto Right = Pool.async(
+      [&] { RightSum = ParallelSum(Pool, Values.drop_front(Mid)); });
+  unsigned LeftSum = ParallelSum(Pool, Values.slice(0, Mid));
+  Pool.wait(Right);
+  return LeftSum + RightSum;
+}
+
+TEST_F(ThreadPoolTest, RecursiveTasks) {
+  CHECK_UNSUPPORTED();
+  // Test divide-and-conquer parallelism on a pool smaller than the recursion
+  // fan-out.
+  std::vector<unsigned> Values(1000);
+  std::iota(Values.begin(), Values.end(), 0U);
+  ThreadPool Pool{2};
+  unsigned Sum = 0;
+  Pool.wait(Pool.async([&] { Sum = ParallelSum(Pool, Values); }));
+  ASSERT_EQ(999U * 1000U / 2, Sum);
+}
@@ -0,0 +1,67 @@
+//===- unittests/TimeProfilerTest.cpp - TimeProfiler tests ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+TEST(TimeProfiler, Disabled) {
+  ASSERT_FALSE(timeTraceProfilerEnabled());
+  bool DetailComputed = false;
+  {
+    TimeTraceScope Scope("Pass", [&] {
+      DetailComputed = true;
+      return std::string("function");
+    });
+  }
+  EXPECT_FALSE(DetailComputed);
+}
+
+TEST(TimeProfiler, NestedScopes) {
+  timeTraceProfilerInitialize();
+  EXPECT_TRUE(timeTraceProfilerEnabled());
+  {
+    TimeTraceScope Outer("Outer", "module");
+    TimeTraceScope Inner("Inner", [] { return std::string("function"); });
+  }
+  std::string Trace;
+  raw_string_ostream OS(Trace);
+  timeTraceProfilerWrite(OS);
+  timeTraceProfilerCleanup();
+  EXPECT_FALSE(timeTraceProfilerEnabled());
+  OS.flush();
+
+  // Spans are written as they end, so the inner one comes first.
+  size_t Inner =
+      Trace.find("\"name\":\"Inner\",\"args\":{\"detail\":\"function\"");
+  size_t Outer =
+      Trace.find("\"name\":\"Outer\",\"args\":{\"detail\":\"module\"");
+  ASSERT_NE(std::string::npos, Inner);
+  ASSERT_NE(std::string::npos, Outer);
+  EXPECT_LT(Inner, Outer);
+  EXPECT_EQ(0u, Trace.find("{\"traceEvents\":["));
+}
+
+TEST(TimeProfiler, Escaping) {
+  timeTraceProfilerInitialize();
+  { TimeTraceScope Scope("Pass", "\"quoted\\name\"\n"); }
+  std::string Trace;
+  raw_string_ostream OS(Trace);
+  timeTraceProfilerWrite(OS);
+  timeTraceProfilerCleanup();
+  OS.flush();
+  EXPECT_NE(std::string::npos,
+            Trace.find("\"detail\":\"\\\"quoted\\\\name\\\"\\n\""));
+}
+
+} // end anonymous namespace
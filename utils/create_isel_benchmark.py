@@ -0,0 +1,68 @@
+#!/usr/bin/env python
+"""An instruction selection throughput benchmark creation program.
+
+This is a python program that creates LLVM IR with many functions made of many
+small basic blocks, each mixing the DAG shapes instruction selection spends
+its time on: integer and vector arithmetic, loads and stores, shuffles,
+compares and selects. Every block goes through its own SelectionDAG, so the
+cost of setting up and clearing the DAG between blocks shows up next to the
+cost of selecting the nodes themselves.
+
+To compare the ISel throughput of two builds of llc, generate a module and
+time the instruction selector of both on it, for instance:
+
+  create_isel_benchmark.py 200 50 > isel.ll
+  llc -O0 -time-passes -o /dev/null isel.ll 2>&1 | grep "Instruction Selection"
+"""
+
+from __future__ import print_function
+
+import argparse
+
+
+def emit_block(fn, blk, last_block):
+  p = "%%f%db%d" % (fn, blk)
+  print("b%d:" % blk)
+  print("  %s.x = load i32, i32* %%p" % p)
+  print("  %s.a = add i32 %s.x, %d" % (p, p, blk))
+  print("  %s.m = mul i32 %s.a, %%n" % (p, p))
+  print("  %s.s = shl i32 %s.m, 3" % (p, p))
+  print("  store i32 %s.s, i32* %%p" % p)
+  print("  %s.v = load <4 x i32>, <4 x i32>* %%q" % p)
+  print("  %s.w = shufflevector <4 x i32> %s.v, <4 x i32> undef, "
+        "<4 x i32> <i32 %d, i32 %d, i32 %d, i32 %d>" %
+        (p, p, blk % 4, (blk + 1) % 4, (blk + 2) % 4, (blk + 3) % 4))
+  print("  %s.y = add <4 x i32> %s.v, %s.w" % (p, p, p))
+  print("  store <4 x i32> %s.y, <4 x i32>* %%q" % p)
+  print("  %s.c = icmp slt i32 %s.s, %%n" % (p, p))
+  print("  %s.z = select i1 %s.c, i32 %s.a, i32 %s.m" % (p, p, p, p))
+  print("  store i32 %s.z, i32* %%p" % p)
+  if blk == last_block:
+    print("  ret i32 %s.z" % p)
+  else:
+    print("  br i1 %s.c, label %%b%d, label %%b%d" %
+          (p, blk + 1, min(blk + 2, last_block)))
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__,
+      formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('functions', type=int, help="Number of functions")
+  parser.add_argument('blocks', type=int,
+                      help="Number of basic blocks per function")
+  args = parser.parse_args()
+  if args.functions < 1 or args.blocks < 1:
+    parser.error("there must be at least one function and one block")
+
+  for fn in range(args.functions):
+    print("define i32 @f%d(i32* %%p, <4 x i32>* %%q, i32 %%n) {" % fn)
+    print("entry:")
+    print("  br label %b0")
+    for blk in range(args.blocks):
+      emit_block(fn, blk, args.blocks - 1)
+    print("}")
+    print()
+
+
+if __name__ == '__main__':
+  main()
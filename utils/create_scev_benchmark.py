@@ -0,0 +1,90 @@
+#!/usr/bin/env python
+"""A ScalarEvolution compile time benchmark creation program.
+
+This is a python program that creates LLVM IR whose scalar evolution
+expressions are deep DAGs: two independent ladders of multiplies and adds,
+rooted at loads SCEV cannot tell apart, are summed into the trip count of a
+loop. Canonicalizing that sum compares both ladders operand by operand, and
+folding it walks every expression of both; either step done without
+memoization takes time exponential in the height of the ladders.
+
+With --exit-condition, it instead creates a loop whose exit condition is a
+chain of 'and's, each of a value with itself. Computing the exit limit of
+such a condition without memoization visits every path through the chain,
+i.e. takes time exponential in its height as well.
+
+To look for regressions, generate a module and time a pass that computes trip
+counts on it, for instance:
+
+  create_scev_benchmark.py 40 > scev.ll
+  opt -indvars -time-passes -disable-output scev.ll 2>&1 | grep "Scalar Evolution"
+"""
+
+from __future__ import print_function
+
+import argparse
+
+
+def emit_ladder(name, ptr, height):
+  print("  %%%s.x0 = load i64, i64* %s" % (name, ptr))
+  print("  %%%s.y0 = load i64, i64* %s" % (name, ptr))
+  for i in range(height):
+    print("  %%%s.x%d = mul i64 %%%s.x%d, %%%s.y%d" %
+          (name, i + 1, name, i, name, i))
+    print("  %%%s.y%d = add i64 %%%s.x%d, %%%s.y%d" %
+          (name, i + 1, name, i, name, i))
+
+
+def emit_exit_condition_loop(height):
+  print("define void @f(i32 %n) {")
+  print("entry:")
+  print("  br label %loop")
+  print()
+  print("loop:")
+  print("  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]")
+  print("  %i.next = add i32 %i, 1")
+  print("  %c0 = icmp ne i32 %i.next, %n")
+  for i in range(height):
+    print("  %%c%d = and i1 %%c%d, %%c%d" % (i + 1, i, i))
+  print("  br i1 %%c%d, label %%loop, label %%exit" % height)
+  print()
+  print("exit:")
+  print("  ret void")
+  print("}")
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__,
+      formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('height', type=int,
+                      help="Height of the ladders or of the exit condition")
+  parser.add_argument('--exit-condition', action='store_true',
+                      help="Create a loop with a deep exit condition instead")
+  args = parser.parse_args()
+  if args.height < 1:
+    parser.error("the ladders must be at least one step high")
+
+  if args.exit_condition:
+    emit_exit_condition_loop(args.height)
+    return
+
+  print("define void @f(i64* %p, i64* %q) {")
+  print("entry:")
+  emit_ladder("a", "%p", args.height)
+  emit_ladder("b", "%q", args.height)
+  print("  %%n = add i64 %%a.x%d, %%b.x%d" % (args.height, args.height))
+  print("  br label %loop")
+  print()
+  print("loop:")
+  print("  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]")
+  print("  %i.next = add nuw i64 %i, 1")
+  print("  %c = icmp ult i64 %i.next, %n")
+  print("  br i1 %c, label %loop, label %exit")
+  print()
+  print("exit:")
+  print("  ret void")
+  print("}")
+
+
+if __name__ == '__main__':
+  main()